@@ -0,0 +1,73 @@
+///
+/// @file      mutff_cmov.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library compressed movie header
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_CMOV_H_
+#define MUTFF_CMOV_H_
+
+#include <stddef.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+///
+/// @brief The working space needed by the compressed movie functions beyond
+/// the uncompressed movie atom itself
+///
+/// mutff_write_compressed_movie_atom additionally needs room for the
+/// compressed movie atom.
+///
+#define MuTFF_COMPRESSED_MOVIE_WORK_SIZE 2560U
+
+///
+/// @brief Read a movie atom holding a compressed movie atom
+///
+/// The 'cmvd' data is decompressed as it is read, into buf, and the movie atom
+/// it holds parsed from there. The decompressor's state is also kept in buf.
+/// Only 'zlib' compression is supported.
+///
+/// @param [in] ctx       The context, positioned at the 'moov' atom
+/// @param [out] n        The number of bytes read
+/// @param [out] out      The movie
+/// @param [in] buf       Working space
+/// @param [in] buf_size  The size of buf
+/// @return               The MuTFFError code. MuTFFErrorOutOfMemory if the
+///                       movie atom and MuTFF_COMPRESSED_MOVIE_WORK_SIZE bytes
+///                       do not fit in buf.
+///
+MuTFFError mutff_read_compressed_movie_atom(MuTFFContext *ctx, size_t *n,
+                                           MuTFFMovieAtom *out, void *buf,
+                                           size_t buf_size);
+
+///
+/// @brief Write a movie atom holding only a compressed movie atom
+///
+/// The movie atom is serialised into the start of buf and compressed into the
+/// rest of it, after the compressor's state.
+///
+/// @param [in] ctx       The context
+/// @param [out] n        The number of bytes written
+/// @param [in] in        The movie
+/// @param [in] buf       Working space
+/// @param [in] buf_size  The size of buf
+/// @return               The MuTFFError code. MuTFFErrorOutOfMemory if the
+///                       movie atom, MuTFF_COMPRESSED_MOVIE_WORK_SIZE bytes and
+///                       the compressed movie atom do not fit in buf.
+///
+MuTFFError mutff_write_compressed_movie_atom(MuTFFContext *ctx, size_t *n,
+                                            const MuTFFMovieAtom *in,
+                                            void *buf, size_t buf_size);
+
+/// @} MuTFF
+
+#endif  // MUTFF_CMOV_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
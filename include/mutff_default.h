@@ -929,8 +929,67 @@ typedef struct {
   int16_t color_table_id;
 } MuTFFVideoSampleDescription;
 
+///
+/// @brief Hint sample description data
+///
+/// The time scale, time offset and sequence offset are entries of the
+/// additional data table, each of which may be absent.
+///
+/// @see
+/// https://developer.apple.com/library/archive/documentation/QuickTime/QTFF/QTFFChap3/qtff3.html#//apple_ref/doc/uid/TP40000939-CH205-SW38
+///
+typedef struct {
+  uint16_t version;
+  uint16_t last_compatible_version;
+  uint32_t max_packet_size;
+  bool time_scale_present;
+  uint32_t time_scale;
+  bool time_offset_present;
+  int32_t time_offset;
+  bool sequence_offset_present;
+  int32_t sequence_offset;
+} MuTFFHintSampleDescription;
+
+///
+/// @brief Sound sample description data
+///
+/// The fields from `samples_per_packet` are present in versions 1 and 2 only,
+/// and the fields from `audio_sample_rate` in version 2 only. In version 2 the
+/// version 0 fields hold fixed values. `little_endian` is set by an 'enda'
+/// extension atom.
+///
+/// @see
+/// https://developer.apple.com/library/archive/documentation/QuickTime/QTFF/QTFFChap3/qtff3.html#//apple_ref/doc/uid/TP40000939-CH205-SW1
+///
+typedef struct {
+  uint16_t version;
+  uint16_t revision_level;
+  uint32_t vendor;
+  uint16_t number_of_channels;
+  uint16_t sample_size;
+  int16_t compression_id;
+  uint16_t packet_size;
+  mutff_q16_16_t sample_rate;
+
+  uint32_t samples_per_packet;
+  uint32_t bytes_per_packet;
+  uint32_t bytes_per_frame;
+  uint32_t bytes_per_sample;
+
+  double audio_sample_rate;
+  uint32_t audio_channels;
+  uint32_t bits_per_channel;
+  uint32_t format_specific_flags;
+  uint32_t bytes_per_audio_packet;
+  uint32_t lpcm_frames_per_audio_packet;
+
+  bool little_endian;
+} MuTFFSoundSampleDescription;
+
 typedef union {
   MuTFFVideoSampleDescription video;
+  MuTFFSoundSampleDescription sound;
+  MuTFFHintSampleDescription hint;
 } MuTFFSampleDescriptionData;
 
 ///
@@ -992,6 +1051,61 @@ MuTFFError mutff_video_sample_description_size(
 MuTFFError mutff_write_video_sample_description(
     MuTFFContext *ctx, size_t *n, const MuTFFVideoSampleDescription *in);
 
+///
+/// @brief Read hint sample description data
+///
+/// @param [in] ctx   The context
+/// @param [out] n    The number of bytes read
+/// @param [in] size  The size of the data, up to the end of the description
+/// @param [out] out  The parsed description
+/// @return           The MuTFFError code
+///
+MuTFFError mutff_read_hint_sample_description(MuTFFContext *ctx, size_t *n,
+                                              uint64_t size,
+                                              MuTFFHintSampleDescription *out);
+
+MuTFFError mutff_hint_sample_description_size(
+    uint64_t *out, const MuTFFHintSampleDescription *desc);
+
+///
+/// @brief Write hint sample description data
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes written
+/// @param [in] in   The description
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_write_hint_sample_description(
+    MuTFFContext *ctx, size_t *n, const MuTFFHintSampleDescription *in);
+
+///
+/// @brief Read sound sample description data
+///
+/// Extension atoms are not read by this function, they are read by
+/// mutff_read_sample_description.
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes read
+/// @param [out] out The parsed description
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_read_sound_sample_description(
+    MuTFFContext *ctx, size_t *n, MuTFFSoundSampleDescription *out);
+
+MuTFFError mutff_sound_sample_description_size(
+    uint64_t *out, const MuTFFSoundSampleDescription *desc);
+
+///
+/// @brief Write sound sample description data
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes written
+/// @param [in] in   The description
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_write_sound_sample_description(
+    MuTFFContext *ctx, size_t *n, const MuTFFSoundSampleDescription *in);
+
 ///
 /// @brief The maximum length of the data in a compressed matte atom
 /// @see MuTFFCompressedMatteAtom
@@ -2478,6 +2592,9 @@ MuTFFError mutff_write_base_media_information_header_atom(
 ///
 typedef struct {
   MuTFFBaseMediaInformationHeaderAtom base_media_information_header;
+
+  bool sample_table_present;
+  MuTFFSampleTableAtom sample_table;
 } MuTFFBaseMediaInformationAtom;
 
 ///
@@ -2668,7 +2785,10 @@ typedef struct {
 /// @param [in] ctx  The context
 /// @param [out] n   The number of bytes read
 /// @param [out] out The parsed atom
-/// @return          The MuTFFError code
+/// @return          The MuTFFError code. MuTFFErrorCompressed if the movie
+///                  atom holds a compressed movie atom, with the context moved
+///                  back to the start of the movie atom so that it may be
+///                  read with mutff_read_compressed_movie_atom.
 ///
 MuTFFError mutff_read_movie_atom(MuTFFContext *ctx, size_t *n,
                                  MuTFFMovieAtom *out);
@@ -2684,6 +2804,141 @@ MuTFFError mutff_read_movie_atom(MuTFFContext *ctx, size_t *n,
 MuTFFError mutff_write_movie_atom(MuTFFContext *ctx, size_t *n,
                                   const MuTFFMovieAtom *in);
 
+///
+/// @brief The position of an atom within an enclosing atom
+///
+typedef struct {
+  uint64_t offset;
+  uint64_t size;
+} MuTFFAtomExtent;
+
+///
+/// @brief The layout of a serialised movie atom
+///
+/// All offsets are relative to the start of the movie atom. The head holds the
+/// movie atom's header and the movie header atom, the tail holds any clipping,
+/// color table, user data and movie extends atoms.
+///
+typedef struct {
+  uint64_t size;
+  MuTFFAtomExtent head;
+  size_t track_count;
+  MuTFFAtomExtent track[MuTFF_MAX_TRACK_ATOMS];
+  MuTFFAtomExtent tail;
+} MuTFFMovieAtomLayout;
+
+///
+/// @brief Compute the layout of a movie atom
+///
+/// Once the layout is known each region of the movie atom can be serialised
+/// independently of the others, for instance by writing each track atom from
+/// a separate thread into its own part of one buffer using
+/// mutff_write_movie_atom_head(), mutff_write_track_atom() and
+/// mutff_write_movie_atom_tail(). The writers share no state, so this
+/// requires only a separate MuTFFContext per thread.
+///
+/// @param [out] out The layout
+/// @param [in] in   The atom
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_movie_atom_layout(MuTFFMovieAtomLayout *out,
+                                   const MuTFFMovieAtom *in);
+
+///
+/// @brief Write the head of a movie atom
+///
+/// Writes the movie atom's header followed by the movie header atom.
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes written
+/// @param [in] in   The atom
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_write_movie_atom_head(MuTFFContext *ctx, size_t *n,
+                                       const MuTFFMovieAtom *in);
+
+///
+/// @brief Write the tail of a movie atom
+///
+/// Writes the child atoms which follow the track atoms.
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes written
+/// @param [in] in   The atom
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_write_movie_atom_tail(MuTFFContext *ctx, size_t *n,
+                                       const MuTFFMovieAtom *in);
+
+#define MuTFF_MAX_MOVIE_CHILD_ATOMS 16U
+
+///
+/// @brief The location of a movie atom and its children in a source file
+///
+/// `offset` is the position of the movie atom in the source, child offsets are
+/// relative to the start of the movie atom. Children are listed in the order
+/// they appear, including those of unrecognised types.
+///
+typedef struct {
+  uint64_t offset;
+  uint64_t size;
+  size_t child_count;
+  uint32_t child_type[MuTFF_MAX_MOVIE_CHILD_ATOMS];
+  MuTFFAtomExtent child[MuTFF_MAX_MOVIE_CHILD_ATOMS];
+} MuTFFMovieAtomSource;
+
+///
+/// @brief Read the location of a movie atom and its children
+///
+/// Only the atom headers are read.
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes read
+/// @param [out] out The location of the atom
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_read_movie_atom_source(MuTFFContext *ctx, size_t *n,
+                                        MuTFFMovieAtomSource *out);
+
+///
+/// @brief Parts of a movie atom which have been modified
+/// @see mutff_rewrite_movie_atom
+///
+#define MuTFF_DIRTY_MOVIE_HEADER (1UL << 0U)
+#define MuTFF_DIRTY_CLIPPING (1UL << 1U)
+#define MuTFF_DIRTY_COLOR_TABLE (1UL << 2U)
+#define MuTFF_DIRTY_USER_DATA (1UL << 3U)
+#define MuTFF_DIRTY_MOVIE_EXTENDS (1UL << 4U)
+#define MuTFF_DIRTY_TRACK(i) (1UL << (8U + (i)))
+
+///
+/// @brief Write a modified movie atom, reusing unmodified parts of the source
+///
+/// Children of the movie atom which are not marked as dirty are copied verbatim
+/// from their original location in the source, so they are not re-serialised.
+/// Dirty children are serialised from `in`, or dropped if they are no longer
+/// present. Unrecognised children are always copied. Track atoms correspond to
+/// the source's track atoms in order; tracks beyond those in the source are
+/// written after the last source track and source tracks beyond
+/// `in->track_count` are dropped.
+///
+/// If the movie atom precedes the media data and its size changes, chunk
+/// offsets must be adjusted and the affected tracks marked as dirty.
+///
+/// @param [in] ctx     The context to write to
+/// @param [out] n      The number of bytes written
+/// @param [in] src     The context of the source file
+/// @param [in] source  The location of the movie atom in the source
+/// @param [in] in      The modified atom
+/// @param [in] dirty   The parts of the atom which have been modified
+/// @return             The MuTFFError code
+///
+MuTFFError mutff_rewrite_movie_atom(MuTFFContext *ctx, size_t *n,
+                                    MuTFFContext *src,
+                                    const MuTFFMovieAtomSource *source,
+                                    const MuTFFMovieAtom *in,
+                                    unsigned long dirty);
+
 ///
 /// @brief Movie fragment header atom.
 ///
@@ -2985,11 +3240,30 @@ typedef struct {
 /// @param [in] ctx  The context
 /// @param [out] n   The number of bytes read
 /// @param [out] out The parsed file
-/// @return          The MuTFFError code
+/// @return          The MuTFFError code. MuTFFErrorCompressed if the movie
+///                  atom is compressed, with the context at the start of the
+///                  movie atom; see mutff_read_movie_file_buffered.
 ///
 MuTFFError mutff_read_movie_file(MuTFFContext *ctx, size_t *n,
                                  MuTFFMovieFile *out);
 
+///
+/// @brief Read a QuickTime movie file, which may have a compressed movie atom
+///
+/// A compressed movie atom is read with mutff_read_compressed_movie_atom,
+/// using buf as its working space.
+///
+/// @param [in] ctx       The context
+/// @param [out] n        The number of bytes read
+/// @param [out] out      The parsed file
+/// @param [in] buf       Working space
+/// @param [in] buf_size  The size of buf
+/// @return               The MuTFFError code
+///
+MuTFFError mutff_read_movie_file_buffered(MuTFFContext *ctx, size_t *n,
+                                          MuTFFMovieFile *out, void *buf,
+                                          size_t buf_size);
+
 ///
 /// @brief Write a QuickTime movie file
 ///
@@ -3001,6 +3275,46 @@ MuTFFError mutff_read_movie_file(MuTFFContext *ctx, size_t *n,
 MuTFFError mutff_write_movie_file(MuTFFContext *ctx, size_t *n,
                                   const MuTFFMovieFile *in);
 
+///
+/// @brief State of an incremental read of a movie file which is still being
+/// written
+///
+/// `offset` is the position in the file of the first top-level atom which has
+/// not yet been read.
+///
+typedef struct {
+  uint64_t offset;
+  bool movie_present;
+} MuTFFMovieFileTail;
+
+///
+/// @brief Begin an incremental read of a movie file
+///
+/// @param [out] tail The read state
+/// @param [out] out  The file, which is filled in by subsequent calls to
+///                   mutff_read_movie_file_tail()
+///
+void mutff_init_movie_file_tail(MuTFFMovieFileTail *tail, MuTFFMovieFile *out);
+
+///
+/// @brief Read the top-level atoms appended to a movie file since the last call
+///
+/// Only atoms which have been completely written are read; reading stops at
+/// the first incomplete atom and resumes from it on the next call. Atoms with a
+/// size of zero, which extend to the end of the file, are treated as
+/// incomplete. The context may be re-opened between calls, the read resumes
+/// from the offset stored in the read state rather than the current position.
+///
+/// @param [in] ctx      The context
+/// @param [out] n       The number of bytes read by this call
+/// @param [in,out] tail The read state
+/// @param [in,out] out  The file
+/// @return              The MuTFFError code
+///
+MuTFFError mutff_read_movie_file_tail(MuTFFContext *ctx, size_t *n,
+                                      MuTFFMovieFileTail *tail,
+                                      MuTFFMovieFile *out);
+
 /// @} MuTFF
 
 #endif  // MUTFF_DEFAULT_H_
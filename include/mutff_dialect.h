@@ -0,0 +1,83 @@
+///
+/// @file      mutff_dialect.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library file dialect header file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_DIALECT_H_
+#define MUTFF_DIALECT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+///
+/// @brief The family of specifications a file follows, as given by its brands
+///
+typedef enum {
+  MuTFFDialectUnknown,
+  MuTFFDialectQuickTime,
+  MuTFFDialectISO,
+  MuTFFDialectCMAF,
+} MuTFFDialect;
+
+///
+/// @brief Refine a dialect with a brand of the file
+///
+/// The major brand should be added first, followed by each compatible brand in
+/// order. A known major brand is not overridden by compatible brands, except
+/// that ISO files carrying a CMAF brand become CMAF files.
+///
+/// @param [in,out] dialect  The dialect, initially MuTFFDialectUnknown
+/// @param [in] brand        The brand
+///
+void mutff_dialect_add_brand(MuTFFDialect *dialect, uint32_t brand);
+
+///
+/// @brief Get the dialect of a file from its file type atom
+///
+/// Files with a file type atom but no known brand are assumed to be ISO files.
+/// Files without a file type atom should be treated as QuickTime files.
+///
+/// @param [out] out  The dialect
+/// @param [in] atom  The file type atom
+///
+void mutff_file_type_dialect(MuTFFDialect *out, const MuTFFFileTypeAtom *atom);
+
+///
+/// @brief Check whether atoms of a type may be present in a dialect
+///
+/// Readers may skip atoms of types which are not part of the file's dialect
+/// without examining them.
+///
+/// @param [in] dialect  The dialect
+/// @param [in] type     The atom type
+/// @return              Whether the atom type is part of the dialect
+///
+bool mutff_dialect_has_atom(MuTFFDialect dialect, uint32_t type);
+
+///
+/// @brief Check whether the movie atom of a file in a dialect precedes all of
+///        its media data
+///
+/// If so, readers only needing the movie atom may stop reading once it is
+/// found.
+///
+/// @param [in] dialect  The dialect
+/// @return              Whether the movie atom is known to come first
+///
+bool mutff_dialect_movie_first(MuTFFDialect dialect);
+
+/// @} MuTFF
+
+#endif  // MUTFF_DIALECT_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
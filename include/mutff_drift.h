@@ -0,0 +1,107 @@
+///
+/// @file      mutff_drift.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library sync drift analysis header
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_DRIFT_H_
+#define MUTFF_DRIFT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+#define MuTFF_MAX_DRIFT_EVENTS 16U
+
+///
+/// @brief Types of discontinuity in a track's timeline
+///
+typedef enum {
+  // a stretch of the movie in which the track shows nothing
+  MuTFFDriftEventGap,
+  // media shown a second time
+  MuTFFDriftEventOverlap,
+  // media which is never shown
+  MuTFFDriftEventSkip,
+  // the track's media stopping before the other track's
+  MuTFFDriftEventEnd,
+} MuTFFDriftEventType;
+
+///
+/// @brief A discontinuity in a track's timeline
+///
+/// `time` is the movie time at which the discontinuity appears and `duration`
+/// its length, both in the movie time scale.
+///
+typedef struct {
+  size_t track;
+  MuTFFDriftEventType type;
+  int64_t time;
+  int64_t duration;
+} MuTFFDriftEvent;
+
+///
+/// @brief A point on the drift curve
+///
+/// `time` is the movie time at which the video shows some media and `drift`
+/// how much later the audio shows media the same nominal distance into its
+/// track, both in the movie time scale. The nominal distance is the one which
+/// would be reached if every sample lasted the track's most common sample
+/// duration, so a track whose samples run long or short drifts.
+///
+typedef struct {
+  int64_t time;
+  int64_t drift;
+} MuTFFDriftPoint;
+
+///
+/// @brief The discontinuities found by a drift analysis
+///
+/// Every event is counted, only the first MuTFF_MAX_DRIFT_EVENTS are
+/// recorded.
+///
+typedef struct {
+  uint32_t event_count;
+  MuTFFDriftEvent event[MuTFF_MAX_DRIFT_EVENTS];
+} MuTFFDriftReport;
+
+///
+/// @brief Compare the timelines of an audio and a video track
+///
+/// Each track's timeline is built from its edit list, including the rate of
+/// each edit, and the drift curve follows the decode times and composition
+/// offsets of the samples, every interval. The tables are walked once, with
+/// cursors which only move forwards. Media is measured from each track's
+/// first composition time. Tracks which stop showing media at different times
+/// are reported with a MuTFFDriftEventEnd event.
+///
+/// @param [out] curve         The drift curve
+/// @param [out] curve_count   The number of points on the curve
+/// @param [in] max_points     The number of points curve has room for
+/// @param [out] report        The discontinuities in either track
+/// @param [in] movie          The movie
+/// @param [in] audio_track    The index of the audio track within the movie
+/// @param [in] video_track    The index of the video track within the movie
+/// @param [in] interval       The distance between points on the curve, in
+///                            the movie time scale
+/// @return                    The MuTFFError code. MuTFFErrorOutOfMemory if
+///                            there are more than max_points points.
+///
+MuTFFError mutff_analyse_drift(MuTFFDriftPoint *curve, size_t *curve_count,
+                               size_t max_points, MuTFFDriftReport *report,
+                               const MuTFFMovieAtom *movie, size_t audio_track,
+                               size_t video_track, uint32_t interval);
+
+/// @} MuTFF
+
+#endif  // MUTFF_DRIFT_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,77 @@
+///
+/// @file      mutff_edl.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library edit decision list header
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_EDL_H_
+#define MUTFF_EDL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+///
+/// @brief A movie from which an edit decision list takes media
+///
+/// `url` locates the source's file from the movie being made and is stored,
+/// with its terminator, in a 'url ' data reference, so must be shorter than
+/// MuTFF_MAX_DATA_REFERENCE_DATA_SIZE.
+///
+typedef struct {
+  const MuTFFMovieAtom *movie;
+  const char *url;
+} MuTFFEDLSource;
+
+///
+/// @brief An event in an edit decision list
+///
+/// The media of a source track from `in` up to `out`, in the media time scale,
+/// is shown from `time`, in the time scale of the movie being made.
+///
+typedef struct {
+  size_t source;
+  size_t track;
+  uint32_t time;
+  uint32_t in;
+  uint32_t out;
+} MuTFFEDLSegment;
+
+///
+/// @brief Make a reference movie from an edit decision list
+///
+/// Each source track used gets a track in the new movie. Its media is that of
+/// the source, with a data reference to the source's file in place of the
+/// original, so the chunk offsets of the source still locate its samples and
+/// no media is copied. Its edit list shows the segments using it in turn,
+/// with empty edits between them. The segments of a track must be given in
+/// order of time and must not overlap.
+///
+/// @param [out] out             The new movie, ready to be written
+/// @param [in] sources          The source movies
+/// @param [in] source_count     The number of source movies
+/// @param [in] segments         The segments
+/// @param [in] segment_count    The number of segments
+/// @param [in] time_scale       The time scale of the new movie
+/// @return                      The MuTFFError code. MuTFFErrorOutOfMemory if
+///                              there are too many tracks or edits or a url
+///                              is too long.
+///
+MuTFFError mutff_render_edl(MuTFFMovieAtom *out, const MuTFFEDLSource *sources,
+                            size_t source_count,
+                            const MuTFFEDLSegment *segments,
+                            size_t segment_count, uint32_t time_scale);
+
+/// @} MuTFF
+
+#endif  // MUTFF_EDL_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
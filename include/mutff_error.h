@@ -22,6 +22,8 @@ typedef enum {
   MuTFFErrorEOF,
   MuTFFErrorBadFormat,
   MuTFFErrorOutOfMemory,
+  /// A compressed movie atom, to be read with mutff_read_compressed_movie_atom
+  MuTFFErrorCompressed,
 } MuTFFError;
 
 /// @} MuTFF
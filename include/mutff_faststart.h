@@ -0,0 +1,95 @@
+///
+/// @file      mutff_faststart.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library movie-first view header
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_FASTSTART_H_
+#define MUTFF_FASTSTART_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+///
+/// @brief A file with its movie atom moved to the front, without rewriting it
+///
+/// The movie atom is placed after the file type atom, or at the start of the
+/// file if there is none, and the atoms it passes are moved back. The movie
+/// atom is held in memory with its chunk offsets adjusted, and every other
+/// byte is read from the original file when asked for.
+///
+typedef struct {
+  MuTFFContext *source;
+  unsigned char *movie;
+  uint64_t movie_size;
+  uint64_t movie_offset;
+  uint64_t insert_offset;
+  uint64_t size;
+  uint64_t pos;
+} MuTFFFaststartView;
+
+///
+/// @brief Create a movie-first view of a file
+///
+/// The source context must be positioned at the start of the file and is
+/// used for every read from the view, so must outlive it. Both 'stco' and
+/// 'co64' chunk offset atoms are adjusted, in place, so the movie atom keeps
+/// its size and any atoms the library does not parse.
+///
+/// @param [out] out        The view
+/// @param [in] source      The context of the original file
+/// @param [in] buf         Memory to hold the movie atom, which must outlive
+///                         the view
+/// @param [in] buf_size    The size of buf
+/// @return                 The MuTFFError code. MuTFFErrorOutOfMemory if the
+///                         movie atom does not fit in buf. MuTFFErrorBadFormat
+///                         if an adjusted offset does not fit in a 'stco'
+///                         atom or the movie atom is compressed.
+///
+MuTFFError mutff_faststart_view_init(MuTFFFaststartView *out,
+                                    MuTFFContext *source, void *buf,
+                                    size_t buf_size);
+
+///
+/// @brief Read a range of bytes of the view
+///
+/// @param [in] view     The view
+/// @param [out] dest    The bytes read
+/// @param [in] offset   The offset of the first byte in the view
+/// @param [in] bytes    The number of bytes to read
+/// @return              The MuTFFError code. MuTFFErrorEOF if the range
+///                      extends past the end of the view.
+///
+MuTFFError mutff_faststart_read_at(MuTFFFaststartView *view, void *dest,
+                                   uint64_t offset, size_t bytes);
+
+MuTFFError mutff_read_faststart(mutff_file_t *file, void *dest,
+                                unsigned int bytes);
+
+MuTFFError mutff_write_faststart(mutff_file_t *file, const void *src,
+                                 unsigned int bytes);
+
+MuTFFError mutff_tell_faststart(mutff_file_t *file, unsigned int *location);
+
+MuTFFError mutff_seek_faststart(mutff_file_t *file, long delta);
+
+///
+/// @brief I/O driver reading a MuTFFFaststartView as a file
+///
+/// The view is read-only, writes fail with MuTFFErrorIOError.
+///
+extern MuTFFIODriver mutff_faststart_driver;
+
+/// @} MuTFF
+
+#endif  // MUTFF_FASTSTART_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
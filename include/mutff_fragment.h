@@ -0,0 +1,68 @@
+///
+/// @file      mutff_fragment.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library fragmentation header
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_FRAGMENT_H_
+#define MUTFF_FRAGMENT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+///
+/// @brief Limits on the fragments of a track
+///
+/// `max_size` is in bytes of sample data and `max_duration` in the media time
+/// scale. A limit of zero is no limit.
+///
+typedef struct {
+  uint64_t max_size;
+  uint64_t max_duration;
+} MuTFFFragmentPolicy;
+
+///
+/// @brief A run of samples making up one fragment
+///
+typedef struct {
+  uint32_t first_sample;
+  uint32_t sample_count;
+  uint64_t size;
+  uint64_t duration;
+} MuTFFFragmentRange;
+
+///
+/// @brief Divide a track into fragments within the limits of a policy
+///
+/// Fragments begin only at sync samples and are made as large as the policy
+/// allows. The run of samples from one sync sample to the next is never split,
+/// so a fragment holding a single such run may exceed the limits; check the
+/// size and duration of each fragment to find them.
+///
+/// @param [out] out            The fragments
+/// @param [out] count          The number of fragments
+/// @param [in] max_count       The number of fragments out has room for
+/// @param [in] sample_table    The sample table of the track
+/// @param [in] policy          The policy
+/// @return                     The MuTFFError code. MuTFFErrorOutOfMemory if
+///                             there are more than max_count fragments.
+///
+MuTFFError mutff_plan_fragments(MuTFFFragmentRange *out, size_t *count,
+                                size_t max_count,
+                                const MuTFFSampleTableAtom *sample_table,
+                                const MuTFFFragmentPolicy *policy);
+
+/// @} MuTFF
+
+#endif  // MUTFF_FRAGMENT_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
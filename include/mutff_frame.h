@@ -0,0 +1,111 @@
+///
+/// @file      mutff_frame.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library uncompressed video header
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_FRAME_H_
+#define MUTFF_FRAME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_memory.h"
+#include "mutff_sample.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+///
+/// @brief Pixel formats of uncompressed video
+///
+typedef enum {
+  MuTFFPixelFormatUnknown = 0,
+  // 'raw ', depth 16: big-endian 1-5-5-5 RGB
+  MuTFFPixelFormatRGB555,
+  // 'raw ', depth 24
+  MuTFFPixelFormatRGB24,
+  // 'raw ', depth 32
+  MuTFFPixelFormatARGB32,
+  // '2vuy': 8-bit 4:2:2 as Cb Y0 Cr Y1
+  MuTFFPixelFormatCbYCrY,
+  // 'yuv2': 8-bit 4:2:2 as Y0 Cb Y1 Cr, with signed chroma
+  MuTFFPixelFormatYUYV,
+  // 'v210': 10-bit 4:2:2, six pixels in every 16 bytes
+  MuTFFPixelFormatV210,
+} MuTFFPixelFormat;
+
+///
+/// @brief Get the pixel format of an uncompressed video sample description
+///
+/// @param [out] format     The pixel format
+/// @param [out] row_size   The number of bytes of pixel data in each row,
+///                         excluding any padding. v210 rows are further padded
+///                         to a multiple of 128 bytes.
+/// @param [in] desc        The sample description
+/// @return                 The MuTFFError code. MuTFFErrorBadFormat if the
+///                         video is not uncompressed.
+///
+MuTFFError mutff_video_pixel_format(MuTFFPixelFormat *format, size_t *row_size,
+                                    const MuTFFSampleDescription *desc);
+
+///
+/// @brief A view of an uncompressed video frame in memory
+///
+/// Row y of the frame begins at data + y * stride.
+///
+typedef struct {
+  const unsigned char *data;
+  uint16_t width;
+  uint16_t height;
+  MuTFFPixelFormat pixel_format;
+  size_t stride;
+} MuTFFFrameView;
+
+///
+/// @brief Get a view of a frame of uncompressed video
+///
+/// The frame is not copied, the view points into the buffer, which is
+/// typically a mapping of the whole file. The stride is derived from the size
+/// of the sample, so accounts for any padding at the end of each row. The
+/// position of the buffer is not changed.
+///
+/// @param [out] out           The view
+/// @param [in] buf            The buffer holding the file
+/// @param [in] sample_table   The sample table of the track
+/// @param [in] index          The zero-based index of the sample
+/// @return                    The MuTFFError code. MuTFFErrorEOF if the frame
+///                            lies outside the buffer.
+///
+MuTFFError mutff_frame_view(MuTFFFrameView *out, const MuTFFMemoryBuffer *buf,
+                            const MuTFFSampleTableAtom *sample_table,
+                            uint32_t index);
+
+///
+/// @brief Get a view of the next frame of uncompressed video
+///
+/// Views every frame of a track in time linear in the size of its sample
+/// table, where calling mutff_frame_view for each would not.
+///
+/// @see mutff_frame_view
+///
+/// @param [out] out         The view
+/// @param [in] buf          The buffer holding the file
+/// @param [in, out] cursor  A cursor over the sample table of the track
+/// @return                  The MuTFFError code. MuTFFErrorEOF after the last
+///                          frame or if the frame lies outside the buffer.
+///
+MuTFFError mutff_frame_view_next(MuTFFFrameView *out,
+                                 const MuTFFMemoryBuffer *buf,
+                                 MuTFFSampleCursor *cursor);
+
+/// @} MuTFF
+
+#endif  // MUTFF_FRAME_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,188 @@
+///
+/// @file      mutff_hint.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library RTP hint track header file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_HINT_H_
+#define MUTFF_HINT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+#define MuTFF_MAX_RTP_PACKETS 8U
+#define MuTFF_MAX_RTP_CONSTRUCTORS 4U
+#define MuTFF_RTP_HEADER_SIZE 12U
+
+///
+/// @brief Types of RTP packet data table entry
+///
+typedef enum {
+  MuTFFRTPConstructorNoOp = 0,
+  MuTFFRTPConstructorImmediate = 1,
+  MuTFFRTPConstructorSample = 2,
+  MuTFFRTPConstructorSampleDescription = 3,
+} MuTFFRTPConstructorType;
+
+///
+/// @brief An RTP packet data table entry
+///
+/// For immediate data `length` bytes of `data` are used. Otherwise `length`
+/// bytes are taken from `offset` bytes into the sample, or sample description,
+/// `sample` of the track given by `track_reference_index`. An index of -1
+/// refers to the hint track itself and other indices to the tracks referenced
+/// by its 'hint' track reference.
+///
+typedef struct {
+  MuTFFRTPConstructorType type;
+  int8_t track_reference_index;
+  uint16_t length;
+  uint32_t sample;
+  uint32_t offset;
+  uint16_t bytes_per_block;
+  uint16_t samples_per_block;
+  unsigned char data[14];
+} MuTFFRTPConstructor;
+
+///
+/// @brief An RTP packet in a hint sample
+///
+typedef struct {
+  int32_t relative_time;
+  bool padding;
+  bool extension;
+  bool marker;
+  uint8_t payload_type;
+  uint16_t sequence_number;
+  uint16_t flags;
+  size_t constructor_count;
+  MuTFFRTPConstructor constructor[MuTFF_MAX_RTP_CONSTRUCTORS];
+} MuTFFRTPPacket;
+
+///
+/// @brief An RTP hint sample
+/// @see
+/// https://developer.apple.com/library/archive/documentation/QuickTime/QTFF/QTFFChap3/qtff3.html#//apple_ref/doc/uid/TP40000939-CH205-SW41
+///
+typedef struct {
+  size_t packet_count;
+  MuTFFRTPPacket packet[MuTFF_MAX_RTP_PACKETS];
+} MuTFFRTPHintSample;
+
+///
+/// @brief Read an RTP hint sample
+///
+/// @param [in] ctx  The context, positioned at the start of the sample
+/// @param [out] n   The number of bytes read
+/// @param [out] out The sample
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_read_rtp_hint_sample(MuTFFContext *ctx, size_t *n,
+                                      MuTFFRTPHintSample *out);
+
+///
+/// @brief A hint track and the media tracks it refers to
+///
+typedef struct {
+  const MuTFFSampleTableAtom *sample_table;
+  const MuTFFHintSampleDescription *description;
+  size_t reference_count;
+  const MuTFFSampleTableAtom
+      *reference[MuTFF_MAX_TRACK_REFERENCE_TYPE_TRACK_IDS];
+} MuTFFHintTrack;
+
+///
+/// @brief Resolve a hint track and its referenced tracks within a movie
+///
+/// @param [out] out    The hint track
+/// @param [in] movie   The movie
+/// @param [in] track   The index of the hint track within the movie
+/// @return             The MuTFFError code
+///
+MuTFFError mutff_hint_track_init(MuTFFHintTrack *out,
+                                 const MuTFFMovieAtom *movie, size_t track);
+
+///
+/// @brief A part of an RTP packet payload
+///
+/// Immediate data is found at `data`, otherwise `data` is NULL and the bytes
+/// are at `offset` in the file.
+///
+typedef struct {
+  const unsigned char *data;
+  uint64_t offset;
+  uint32_t length;
+} MuTFFRTPSegment;
+
+///
+/// @brief Get the parts which make up the payload of an RTP packet
+///
+/// The segments may be passed directly to a scatter-gather write, such as
+/// writev or sendmsg over a mapping of the file. Immediate segments point into
+/// the packet, which must outlive them.
+///
+/// @param [out] out     The segments
+/// @param [out] count   The number of segments
+/// @param [in] track    The hint track
+/// @param [in] packet   The packet
+/// @return              The MuTFFError code. MuTFFErrorBadFormat for sample
+///                      description constructors, which are not supported.
+///
+MuTFFError mutff_rtp_packet_segments(
+    MuTFFRTPSegment out[MuTFF_MAX_RTP_CONSTRUCTORS], size_t *count,
+    const MuTFFHintTrack *track, const MuTFFRTPPacket *packet);
+
+///
+/// @brief Write the RTP header of a packet
+///
+/// @param [out] out          The header
+/// @param [in] track         The hint track
+/// @param [in] packet        The packet
+/// @param [in] sample_time   The decode time of the hint sample containing the
+///                           packet
+/// @param [in] ssrc          The synchronisation source identifier
+///
+void mutff_rtp_packet_header(unsigned char out[MuTFF_RTP_HEADER_SIZE],
+                             const MuTFFHintTrack *track,
+                             const MuTFFRTPPacket *packet,
+                             uint32_t sample_time, uint32_t ssrc);
+
+///
+/// @brief Construct an RTP packet
+///
+/// The header and immediate data are written straight into dest and media data
+/// is read from the file straight into its place in dest, with no intermediate
+/// copies.
+///
+/// @param [in] ctx           The context of the file holding the media
+/// @param [out] n            The size of the packet
+/// @param [out] dest         Where to write the packet
+/// @param [in] size          The number of bytes available at dest
+/// @param [in] track         The hint track
+/// @param [in] packet        The packet
+/// @param [in] sample_time   The decode time of the hint sample containing the
+///                           packet
+/// @param [in] ssrc          The synchronisation source identifier
+/// @return                   The MuTFFError code. MuTFFErrorOutOfMemory if the
+///                           packet does not fit in dest.
+///
+MuTFFError mutff_write_rtp_packet(MuTFFContext *ctx, size_t *n, void *dest,
+                                  size_t size, const MuTFFHintTrack *track,
+                                  const MuTFFRTPPacket *packet,
+                                  uint32_t sample_time, uint32_t ssrc);
+
+/// @} MuTFF
+
+#endif  // MUTFF_HINT_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
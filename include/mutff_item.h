@@ -0,0 +1,197 @@
+///
+/// @file      mutff_item.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library HEIF item header file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_ITEM_H_
+#define MUTFF_ITEM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+#define MuTFF_MAX_ITEMS 16U
+#define MuTFF_MAX_ITEM_EXTENTS 4U
+#define MuTFF_MAX_ITEM_PROPERTY_ASSOCIATIONS 8U
+#define MuTFF_MAX_ITEM_PROPERTIES 16U
+#define MuTFF_MAX_ITEM_REFERENCES 16U
+#define MuTFF_MAX_ITEM_REFERENCE_TARGETS 4U
+
+#define MuTFF_ITEM_REFERENCE_THUMBNAIL MuTFF_FOURCC('t', 'h', 'm', 'b')
+
+///
+/// @brief A contiguous run of an item's data
+///
+typedef struct {
+  uint64_t offset;
+  uint64_t length;
+} MuTFFItemExtent;
+
+///
+/// @brief An association between an item and a property
+///
+/// `index` is the one-based index of the property within the item property
+/// container, or zero for no property.
+///
+typedef struct {
+  bool essential;
+  uint16_t index;
+} MuTFFItemPropertyAssociation;
+
+///
+/// @brief An item, combining its item info and item location entries and its
+///        property associations
+///
+/// @see ISO/IEC 14496-12:2015 § 8.11
+///
+typedef struct {
+  uint32_t item_id;
+  uint32_t item_type;
+  uint8_t construction_method;
+  uint16_t data_reference_index;
+  uint64_t base_offset;
+  size_t extent_count;
+  MuTFFItemExtent extent[MuTFF_MAX_ITEM_EXTENTS];
+  size_t property_count;
+  MuTFFItemPropertyAssociation property[MuTFF_MAX_ITEM_PROPERTY_ASSOCIATIONS];
+} MuTFFItem;
+
+///
+/// @brief A reference from one item to others
+///
+typedef struct {
+  uint32_t type;
+  uint32_t from_item_id;
+  size_t to_item_count;
+  uint32_t to_item_id[MuTFF_MAX_ITEM_REFERENCE_TARGETS];
+} MuTFFItemReference;
+
+///
+/// @brief An item property
+///
+/// The property itself is not read, only its type and position in the file.
+///
+typedef struct {
+  uint32_t type;
+  MuTFFAtomExtent extent;
+} MuTFFItemProperty;
+
+///
+/// @brief Meta atom of a HEIF image file
+///
+/// `item_data` is the position in the file of the data of the item data atom,
+/// if present.
+///
+/// Only the primary item and its thumbnails are stored, with the thumbnail
+/// references between them, so that files with many items, such as tiled
+/// images, fit. Every item is stored if there is no primary item. Properties
+/// after the first MuTFF_MAX_ITEM_PROPERTIES are not stored.
+///
+/// @see ISO/IEC 14496-12:2015 § 8.11.1
+/// @see ISO/IEC 23008-12:2017 § 6
+///
+typedef struct {
+  uint32_t handler_type;
+  bool primary_item_present;
+  uint32_t primary_item_id;
+  size_t item_count;
+  MuTFFItem item[MuTFF_MAX_ITEMS];
+  size_t reference_count;
+  MuTFFItemReference reference[MuTFF_MAX_ITEM_REFERENCES];
+  size_t property_count;
+  MuTFFItemProperty property[MuTFF_MAX_ITEM_PROPERTIES];
+  bool item_data_present;
+  MuTFFAtomExtent item_data;
+} MuTFFMetaAtom;
+
+///
+/// @brief Read a meta atom
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes read
+/// @param [out] out The atom
+/// @return          The MuTFFError code. MuTFFErrorBadFormat if the handler
+///                  type is not 'pict'.
+///
+MuTFFError mutff_read_meta_atom(MuTFFContext *ctx, size_t *n,
+                                MuTFFMetaAtom *out);
+
+///
+/// @brief Read the meta atom of a HEIF image file
+///
+/// Top-level atoms other than the meta atom, including all media data, are
+/// skipped without being read.
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes read
+/// @param [out] out The meta atom
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_read_heif_file(MuTFFContext *ctx, size_t *n,
+                                MuTFFMetaAtom *out);
+
+///
+/// @brief Find an item by its ID
+///
+/// @param [out] out     The item
+/// @param [in] atom     The meta atom
+/// @param [in] item_id  The item ID
+/// @return              The MuTFFError code. MuTFFErrorBadFormat if there is
+///                      no such item.
+///
+MuTFFError mutff_meta_item(const MuTFFItem **out, const MuTFFMetaAtom *atom,
+                           uint32_t item_id);
+
+///
+/// @brief Get the primary item
+///
+/// @param [out] out   The item
+/// @param [in] atom   The meta atom
+/// @return            The MuTFFError code
+///
+MuTFFError mutff_meta_primary_item(const MuTFFItem **out,
+                                   const MuTFFMetaAtom *atom);
+
+///
+/// @brief Get the thumbnail of an item
+///
+/// @param [out] out   The thumbnail item
+/// @param [in] atom   The meta atom
+/// @param [in] item   The item
+/// @return            The MuTFFError code. MuTFFErrorEOF if the item has no
+///                    thumbnail.
+///
+MuTFFError mutff_meta_item_thumbnail(const MuTFFItem **out,
+                                     const MuTFFMetaAtom *atom,
+                                     const MuTFFItem *item);
+
+///
+/// @brief Get the position in the file of an item's data
+///
+/// Only items stored in the file itself, directly or in the item data atom,
+/// are supported. An extent of zero length extends to the end of the file.
+///
+/// @param [out] out    The extents, of which there are item->extent_count
+/// @param [in] atom    The meta atom
+/// @param [in] item    The item
+/// @return             The MuTFFError code
+///
+MuTFFError mutff_meta_item_extents(MuTFFItemExtent out[MuTFF_MAX_ITEM_EXTENTS],
+                                   const MuTFFMetaAtom *atom,
+                                   const MuTFFItem *item);
+
+/// @} MuTFF
+
+#endif  // MUTFF_ITEM_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
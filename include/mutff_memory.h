@@ -0,0 +1,59 @@
+///
+/// @file      mutff_memory.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF MP4/QTFF library memory buffer I/O driver header file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_MEMORY_H_
+#define MUTFF_MEMORY_H_
+
+#include <stddef.h>
+
+#include "mutff.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+///
+/// @brief A fixed-size memory buffer used as a stream
+///
+/// The buffer is owned by the caller. Reads and writes past the end of the
+/// buffer fail with MuTFFErrorEOF; the buffer is never grown. Separate
+/// MuTFFMemoryBuffer structures may refer to disjoint regions of the same
+/// underlying memory and be used from different threads simultaneously.
+///
+typedef struct {
+  unsigned char *data;
+  size_t size;
+  size_t pos;
+} MuTFFMemoryBuffer;
+
+///
+/// @brief Initialise a memory buffer stream
+///
+/// @param [out] buf  The stream
+/// @param [in] data  The underlying memory
+/// @param [in] size  The size of the underlying memory in bytes
+///
+void mutff_memory_buffer_init(MuTFFMemoryBuffer *buf, void *data, size_t size);
+
+MuTFFError mutff_read_memory(mutff_file_t *file, void *dest,
+                             unsigned int bytes);
+
+MuTFFError mutff_write_memory(mutff_file_t *file, const void *src,
+                              unsigned int bytes);
+
+MuTFFError mutff_tell_memory(mutff_file_t *file, unsigned int *location);
+
+MuTFFError mutff_seek_memory(mutff_file_t *file, long delta);
+
+extern MuTFFIODriver mutff_memory_driver;
+
+/// @} MuTFF
+
+#endif  // MUTFF_MEMORY_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
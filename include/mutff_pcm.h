@@ -0,0 +1,176 @@
+///
+/// @file      mutff_pcm.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library uncompressed sound header
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_PCM_H_
+#define MUTFF_PCM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+///
+/// @brief The layout of uncompressed, interleaved sound samples
+///
+typedef struct {
+  bool floating_point;
+  bool big_endian;
+  uint8_t bytes_per_sample;
+  uint16_t channels;
+} MuTFFPCMFormat;
+
+///
+/// @brief Get the layout of the samples described by a sound sample description
+///
+/// Supported data formats are 'twos', 'sowt', 'in24', 'in32', 'fl32', 'fl64'
+/// and 'lpcm'. All are signed.
+///
+/// @param [out] out   The layout
+/// @param [in] desc   The sample description
+/// @return            The MuTFFError code. MuTFFErrorBadFormat if the samples
+///                    are not uncompressed.
+///
+MuTFFError mutff_pcm_format(MuTFFPCMFormat *out,
+                            const MuTFFSampleDescription *desc);
+
+///
+/// @brief A summary of a run of sound samples, across all channels
+///
+/// Values are scaled to the range -1 to 1.
+///
+typedef struct {
+  float min;
+  float max;
+  float rms;
+} MuTFFPCMPeak;
+
+///
+/// @brief Summarise an uncompressed sound track for drawing its waveform
+///
+/// The track is divided into buckets of bucket_frames frames, the last of
+/// which may be shorter, and each is summarised. Chunks which follow one
+/// another in the file are read together, in reads of up to buf_size bytes.
+///
+/// @param [in] ctx            The context of the file holding the media
+/// @param [out] out           The summaries
+/// @param [out] count         The number of summaries
+/// @param [in] max_count      The number of summaries out has room for
+/// @param [in] sample_table   The sample table of the track
+/// @param [in] bucket_frames  The number of frames in each bucket
+/// @param [in] buf            Working space for reading samples
+/// @param [in] buf_size       The size of buf, which must hold at least one
+///                            frame
+/// @return                    The MuTFFError code. MuTFFErrorOutOfMemory if
+///                            there are more than max_count buckets.
+///
+MuTFFError mutff_pcm_peaks(MuTFFContext *ctx, MuTFFPCMPeak *out, size_t *count,
+                           size_t max_count,
+                           const MuTFFSampleTableAtom *sample_table,
+                           uint32_t bucket_frames, void *buf, size_t buf_size);
+
+///
+/// @brief Convert interleaved samples to interleaved floats
+///
+/// Values are scaled to the range -1 to 1.
+///
+/// @param [out] out     The converted samples, of which there are
+///                      frames * format->channels
+/// @param [in] data     The samples
+/// @param [in] frames   The number of frames
+/// @param [in] format   The layout of the samples
+///
+void mutff_pcm_to_float(float *out, const void *data, size_t frames,
+                        const MuTFFPCMFormat *format);
+
+///
+/// @brief Convert interleaved samples to a plane of floats per channel
+///
+/// @param [out] out     A plane for each channel, each of frames floats
+/// @param [in] data     The samples
+/// @param [in] frames   The number of frames
+/// @param [in] format   The layout of the samples
+///
+void mutff_pcm_to_float_planar(float *const out[], const void *data,
+                               size_t frames, const MuTFFPCMFormat *format);
+
+///
+/// @brief A position within an uncompressed sound track
+///
+typedef struct {
+  const MuTFFSampleTableAtom *sample_table;
+  MuTFFPCMFormat format;
+  uint32_t sample_description_id;
+  uint32_t entry;
+  uint32_t chunk;
+  uint32_t chunk_frame;
+} MuTFFPCMReader;
+
+///
+/// @brief Begin reading an uncompressed sound track from its first frame
+///
+/// @param [out] out           The reader
+/// @param [in] sample_table   The sample table of the track
+/// @return                    The MuTFFError code
+///
+MuTFFError mutff_pcm_reader_init(MuTFFPCMReader *out,
+                                 const MuTFFSampleTableAtom *sample_table);
+
+///
+/// @brief Read the next frames of a track as interleaved floats
+///
+/// Samples are read a chunk at a time, in reads of up to buf_size bytes, and
+/// converted a whole read at a time. The frames read all have the layout
+/// given by reader->format after the call, which only changes between calls
+/// if the track has more than one sample description.
+///
+/// @param [in] ctx          The context of the file holding the media
+/// @param [out] frames      The number of frames read
+/// @param [out] out         The converted frames
+/// @param [in] max_frames   The number of frames out has room for
+/// @param [in,out] reader   The reader
+/// @param [in] buf          Working space for reading samples
+/// @param [in] buf_size     The size of buf, which must hold at least one frame
+/// @return                  The MuTFFError code. MuTFFErrorEOF if there are
+///                          no frames left.
+///
+MuTFFError mutff_pcm_read_float(MuTFFContext *ctx, size_t *frames, float *out,
+                                size_t max_frames, MuTFFPCMReader *reader,
+                                void *buf, size_t buf_size);
+
+///
+/// @brief Read the next frames of a track as a plane of floats per channel
+///
+/// @see mutff_pcm_read_float
+///
+/// @param [in] ctx          The context of the file holding the media
+/// @param [out] frames      The number of frames read
+/// @param [out] out         A plane for each channel, each with room for
+///                          max_frames floats
+/// @param [in] max_frames   The number of frames to read at most
+/// @param [in,out] reader   The reader
+/// @param [in] buf          Working space for reading samples
+/// @param [in] buf_size     The size of buf, which must hold at least one frame
+/// @return                  The MuTFFError code. MuTFFErrorEOF if there are
+///                          no frames left.
+///
+MuTFFError mutff_pcm_read_float_planar(MuTFFContext *ctx, size_t *frames,
+                                       float *const out[], size_t max_frames,
+                                       MuTFFPCMReader *reader, void *buf,
+                                       size_t buf_size);
+
+/// @} MuTFF
+
+#endif  // MUTFF_PCM_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,113 @@
+///
+/// @file      mutff_pool.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library parse context pool header
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_POOL_H_
+#define MUTFF_POOL_H_
+
+#include <stddef.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+///
+/// @brief State used to parse a single file
+///
+/// Holds the parsed movie file and a region of scratch memory from which
+/// further buffers, such as a sample index, may be allocated while the file is
+/// being processed.
+///
+typedef struct MuTFFParseContext {
+  MuTFFMovieFile movie_file;
+  unsigned char *arena;
+  size_t arena_size;
+  size_t arena_used;
+  struct MuTFFParseContext *next;
+} MuTFFParseContext;
+
+///
+/// @brief A pool of parse contexts
+///
+/// All memory used by the pool is provided by the caller when it is
+/// initialised and is reused, never freed, as contexts are acquired and
+/// released. A pool has no internal locking and must only be used by one
+/// thread at a time; services parsing files on many threads should give each
+/// thread its own pool.
+///
+typedef struct {
+  MuTFFParseContext *free;
+  size_t free_count;
+} MuTFFParsePool;
+
+///
+/// @brief Initialise a parse context pool
+///
+/// The arena is divided equally between the contexts, each share being aligned
+/// for uint64_t.
+///
+/// @param [out] pool         The pool
+/// @param [in] contexts      The contexts to pool
+/// @param [in] context_count The number of contexts
+/// @param [in] arena         Scratch memory to share between the contexts
+/// @param [in] arena_size    The size of the scratch memory in bytes
+///
+void mutff_parse_pool_init(MuTFFParsePool *pool, MuTFFParseContext *contexts,
+                           size_t context_count, void *arena,
+                           size_t arena_size);
+
+///
+/// @brief Take a context from a parse context pool
+///
+/// @param [out] out  The context
+/// @param [in] pool  The pool
+/// @return           The MuTFFError code. MuTFFErrorOutOfMemory if every
+///                   context is in use.
+///
+MuTFFError mutff_parse_pool_acquire(MuTFFParseContext **out,
+                                    MuTFFParsePool *pool);
+
+///
+/// @brief Return a context to a parse context pool
+///
+/// The context's arena is reset, invalidating all memory allocated from it.
+///
+/// @param [in] pool     The pool
+/// @param [in] context  The context, previously acquired from pool
+///
+void mutff_parse_pool_release(MuTFFParsePool *pool,
+                              MuTFFParseContext *context);
+
+///
+/// @brief Allocate scratch memory from a parse context
+///
+/// The memory is aligned for uint64_t and remains valid until the context is
+/// reset or released.
+///
+/// @param [out] out      The memory
+/// @param [in] context   The context
+/// @param [in] size      The number of bytes to allocate
+/// @return               The MuTFFError code
+///
+MuTFFError mutff_parse_context_alloc(void **out, MuTFFParseContext *context,
+                                     size_t size);
+
+///
+/// @brief Free all scratch memory allocated from a parse context
+///
+/// @param [in] context  The context
+///
+void mutff_parse_context_reset(MuTFFParseContext *context);
+
+/// @} MuTFF
+
+#endif  // MUTFF_POOL_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,192 @@
+///
+/// @file      mutff_query.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library index query header file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_QUERY_H_
+#define MUTFF_QUERY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_sample.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+///
+/// @brief Query the summary of a track
+///
+#define MuTFF_QUERY_TRACK_SUMMARY MuTFF_FOURCC('t', 'r', 'a', 'k')
+
+///
+/// @brief Query the byte range of the sample at a time
+///
+/// The request argument is the time, in the track's media time scale.
+///
+#define MuTFF_QUERY_BYTE_RANGE MuTFF_FOURCC('t', 'i', 'm', 'e')
+
+///
+/// @brief Query the sync samples of a track
+///
+/// The request argument is the first sample to consider. Responses hold at most
+/// MuTFF_MAX_QUERY_SYNC_SAMPLES sync samples, further pages are obtained by
+/// repeating the request with the argument set to the `next` field of the
+/// response.
+///
+#define MuTFF_QUERY_SYNC_SAMPLES MuTFF_FOURCC('k', 'e', 'y', 's')
+
+#define MuTFF_MAX_QUERY_NAME_LEN 64U
+#define MuTFF_MAX_QUERY_SYNC_SAMPLES 16U
+
+///
+/// @brief A query on a sample index
+///
+/// On the wire a request is the big-endian sequence size (u32), type (u32),
+/// request_id (u32), track (u32), argument (u64), followed by the name of the
+/// movie. Requests may be pipelined; responses are sent in request order and
+/// carry the request ID of the request they answer.
+///
+typedef struct {
+  uint32_t type;
+  uint32_t request_id;
+  uint32_t track;
+  uint64_t argument;
+  size_t name_length;
+  char name[MuTFF_MAX_QUERY_NAME_LEN];
+} MuTFFQueryRequest;
+
+///
+/// @brief Read a query request
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes read
+/// @param [out] out The request
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_read_query_request(MuTFFContext *ctx, size_t *n,
+                                    MuTFFQueryRequest *out);
+
+///
+/// @brief Write a query request
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes written
+/// @param [in] in   The request
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_write_query_request(MuTFFContext *ctx, size_t *n,
+                                     const MuTFFQueryRequest *in);
+
+///
+/// @brief Response to a track summary query
+///
+typedef struct {
+  uint32_t track_id;
+  uint32_t handler_type;
+  uint32_t time_scale;
+  uint32_t duration;
+  uint32_t sample_count;
+} MuTFFQueryTrackSummary;
+
+///
+/// @brief Response to a byte range query
+///
+/// `sync_sample` is the closest sync sample at or before `sample`, from which
+/// decoding must start.
+///
+typedef struct {
+  uint32_t sample;
+  uint32_t sync_sample;
+  uint64_t offset;
+  uint32_t size;
+  uint64_t decode_time;
+  uint32_t duration;
+} MuTFFQueryByteRange;
+
+///
+/// @brief A sync sample in the response to a sync samples query
+///
+typedef struct {
+  uint32_t sample;
+  uint64_t decode_time;
+  uint64_t offset;
+} MuTFFQuerySyncSample;
+
+///
+/// @brief Response to a sync samples query
+///
+typedef struct {
+  uint32_t next;
+  uint32_t sample_count;
+  MuTFFQuerySyncSample sample[MuTFF_MAX_QUERY_SYNC_SAMPLES];
+} MuTFFQuerySyncSamples;
+
+///
+/// @brief Type-specific data of a query response
+///
+typedef union {
+  MuTFFQueryTrackSummary track_summary;
+  MuTFFQueryByteRange byte_range;
+  MuTFFQuerySyncSamples sync_samples;
+} MuTFFQueryResponseData;
+
+///
+/// @brief The response to a query
+///
+/// On the wire a response is the big-endian sequence size (u32), type (u32),
+/// request_id (u32), status (u32), followed by the fields of the
+/// type-specific data if the status is MuTFFErrorNone.
+///
+typedef struct {
+  uint32_t type;
+  uint32_t request_id;
+  MuTFFError status;
+  MuTFFQueryResponseData data;
+} MuTFFQueryResponse;
+
+///
+/// @brief Read a query response
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes read
+/// @param [out] out The response
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_read_query_response(MuTFFContext *ctx, size_t *n,
+                                     MuTFFQueryResponse *out);
+
+///
+/// @brief Write a query response
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes written
+/// @param [in] in   The response
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_write_query_response(MuTFFContext *ctx, size_t *n,
+                                      const MuTFFQueryResponse *in);
+
+///
+/// @brief Answer a query from a sample index
+///
+/// Errors in answering the query, such as a bad track index, are reported in
+/// the status of the response rather than the return value.
+///
+/// @param [out] out     The response
+/// @param [in] index    The sample index of the movie named in the request
+/// @param [in] request  The request
+///
+void mutff_answer_query(MuTFFQueryResponse *out, const MuTFFSampleIndex *index,
+                        const MuTFFQueryRequest *request);
+
+/// @} MuTFF
+
+#endif  // MUTFF_QUERY_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,298 @@
+///
+/// @file      mutff_sample.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library sample table header file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_SAMPLE_H_
+#define MUTFF_SAMPLE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+///
+/// @brief A single media sample, as described by a sample table
+///
+typedef struct {
+  uint64_t offset;
+  uint32_t size;
+  uint64_t decode_time;
+  uint32_t duration;
+  int32_t composition_offset;
+  uint32_t sample_description_id;
+  bool sync;
+} MuTFFSample;
+
+///
+/// @brief A position in a sample table, for visiting its samples in order
+///
+/// Each step moves along the runs of the tables rather than searching them
+/// again, so visiting every sample takes time linear in the size of the
+/// tables.
+///
+typedef struct {
+  const MuTFFSampleTableAtom *sample_table;
+  uint32_t sample_count;
+  uint32_t index;
+  uint32_t time_to_sample_entry;
+  uint32_t time_to_sample_used;
+  uint64_t decode_time;
+  uint32_t composition_offset_entry;
+  uint32_t composition_offset_used;
+  uint32_t sample_to_chunk_entry;
+  uint32_t chunk;
+  uint32_t chunk_used;
+  uint64_t offset;
+  uint32_t sync_sample_entry;
+} MuTFFSampleCursor;
+
+///
+/// @brief Get the sample table of a media atom
+///
+/// @param [out] out  The sample table
+/// @param [in] atom  The media atom
+/// @return           The MuTFFError code. MuTFFErrorBadFormat if the media
+///                   has no sample table.
+///
+MuTFFError mutff_media_atom_sample_table(const MuTFFSampleTableAtom **out,
+                                         const MuTFFMediaAtom *atom);
+
+///
+/// @brief Get the sample table of a media atom, to be changed
+///
+/// @see mutff_media_atom_sample_table
+///
+/// @param [out] out  The sample table
+/// @param [in] atom  The media atom
+/// @return           The MuTFFError code. MuTFFErrorBadFormat if the media
+///                   has no sample table.
+///
+MuTFFError mutff_media_atom_mutable_sample_table(MuTFFSampleTableAtom **out,
+                                                 MuTFFMediaAtom *atom);
+
+///
+/// @brief Get the number of samples in a sample table
+///
+/// @param [out] out  The number of samples
+/// @param [in] atom  The sample table
+/// @return           The MuTFFError code
+///
+MuTFFError mutff_sample_table_sample_count(uint32_t *out,
+                                           const MuTFFSampleTableAtom *atom);
+
+///
+/// @brief Look up a sample in a sample table
+///
+/// @param [out] out   The sample
+/// @param [in] atom   The sample table
+/// @param [in] index  The zero-based index of the sample
+/// @return            The MuTFFError code
+///
+MuTFFError mutff_sample_table_sample(MuTFFSample *out,
+                                     const MuTFFSampleTableAtom *atom,
+                                     uint32_t index);
+
+///
+/// @brief Position a cursor at a sample of a sample table
+///
+/// @param [out] out   The cursor
+/// @param [in] atom   The sample table, which must outlive the cursor
+/// @param [in] index  The zero-based index of the first sample to visit
+/// @return            The MuTFFError code. MuTFFErrorEOF if the index is after
+///                    the last sample.
+///
+MuTFFError mutff_sample_cursor_init(MuTFFSampleCursor *out,
+                                    const MuTFFSampleTableAtom *atom,
+                                    uint32_t index);
+
+///
+/// @brief Visit the next sample of a sample table
+///
+/// @param [out] out        The sample
+/// @param [in, out] cursor The cursor
+/// @return                 The MuTFFError code. MuTFFErrorEOF after the last
+///                         sample.
+///
+MuTFFError mutff_sample_cursor_next(MuTFFSample *out,
+                                    MuTFFSampleCursor *cursor);
+
+///
+/// @brief Divide the samples of a track into runs of similar total size
+///
+/// Run i is the samples from out[i] up to, but not including, out[i + 1]. Runs
+/// may be empty if there are fewer samples than runs.
+///
+/// @param [out] out    The first sample of each run, followed by the number of
+///                     samples, so count + 1 entries in all
+/// @param [in] count   The number of runs
+/// @param [in] atom    The sample table
+/// @return             The MuTFFError code
+///
+MuTFFError mutff_sample_table_partition(uint32_t *out, size_t count,
+                                        const MuTFFSampleTableAtom *atom);
+
+///
+/// @brief Divide the samples of a track into runs of similar total size which
+/// each begin with a sync sample
+///
+/// A run which would start part way through a group of pictures instead
+/// starts at the next sync sample, so runs may be empty if there are fewer
+/// sync samples than runs.
+///
+/// @see mutff_sample_table_partition
+///
+/// @param [out] out    The first sample of each run, followed by the number of
+///                     samples, so count + 1 entries in all
+/// @param [in] count   The number of runs
+/// @param [in] atom    The sample table
+/// @return             The MuTFFError code
+///
+MuTFFError mutff_sample_table_split(uint32_t *out, size_t count,
+                                    const MuTFFSampleTableAtom *atom);
+
+///
+/// @brief Make the sample table of a run of samples of a track
+///
+/// The samples' data is taken to be stored one after another, in order, from
+/// `offset` in the new file, in a chunk for each run of samples with the same
+/// sample description. Composition shift least greatest atoms are dropped.
+///
+/// @param [out] out      The sample table
+/// @param [in] atom      The sample table of the track
+/// @param [in] first     The zero-based index of the first sample
+/// @param [in] count     The number of samples
+/// @param [in] offset    The offset of the first sample's data in the new file
+/// @return               The MuTFFError code. MuTFFErrorOutOfMemory if the
+///                       samples need more chunks than the table has room for.
+///
+MuTFFError mutff_sample_table_trim(MuTFFSampleTableAtom *out,
+                                   const MuTFFSampleTableAtom *atom,
+                                   uint32_t first, uint32_t count,
+                                   uint32_t offset);
+
+#define MuTFF_SAMPLE_INDEX_MAGIC MuTFF_FOURCC('m', 's', 'i', 'x')
+#define MuTFF_SAMPLE_INDEX_SYNC 0x1U
+
+///
+/// @brief An entry in a sample index
+///
+typedef struct {
+  uint64_t offset;
+  uint64_t decode_time;
+  uint32_t size;
+  uint32_t duration;
+  uint32_t sample_description_id;
+  uint32_t flags;
+  int32_t composition_offset;
+  uint32_t reserved;
+} MuTFFSampleIndexEntry;
+
+///
+/// @brief A track in a sample index
+///
+/// `entries` is the byte offset of the track's first MuTFFSampleIndexEntry
+/// from the start of the index.
+///
+typedef struct {
+  uint32_t track_id;
+  uint32_t handler_type;
+  uint32_t time_scale;
+  uint32_t duration;
+  uint32_t sample_count;
+  uint32_t reserved;
+  uint64_t entries;
+} MuTFFSampleIndexTrack;
+
+///
+/// @brief A flat index of every sample in a movie
+///
+/// The index contains no pointers, only offsets relative to its own start, so
+/// it can be built once into a shared memory segment and mapped read-only, at
+/// any address, by other processes. The memory holding an index must be
+/// aligned for uint64_t.
+///
+typedef struct {
+  uint32_t magic;
+  uint32_t time_scale;
+  uint32_t duration;
+  uint32_t track_count;
+  uint64_t size;
+  MuTFFSampleIndexTrack track[MuTFF_MAX_TRACK_ATOMS];
+} MuTFFSampleIndex;
+
+///
+/// @brief Get the size of the sample index of a movie
+///
+/// @param [out] out   The size of the index in bytes
+/// @param [in] movie  The movie
+/// @return            The MuTFFError code
+///
+MuTFFError mutff_sample_index_size(uint64_t *out, const MuTFFMovieAtom *movie);
+
+///
+/// @brief Build the sample index of a movie
+///
+/// @param [out] dest  Where to build the index
+/// @param [in] size   The number of bytes available at dest
+/// @param [in] movie  The movie
+/// @return            The MuTFFError code. MuTFFErrorOutOfMemory if size is
+///                    too small to hold the index.
+///
+MuTFFError mutff_build_sample_index(void *dest, uint64_t size,
+                                    const MuTFFMovieAtom *movie);
+
+///
+/// @brief Check a sample index is well-formed
+///
+/// Should be called once on an index obtained from an untrusted source, such as
+/// a shared memory segment, before it is used.
+///
+/// @param [in] index  The index
+/// @param [in] size   The number of bytes available at index
+/// @return            The MuTFFError code
+///
+MuTFFError mutff_check_sample_index(const MuTFFSampleIndex *index,
+                                    uint64_t size);
+
+///
+/// @brief Look up a sample in a sample index
+///
+/// @param [out] out    The entry
+/// @param [in] index   The index
+/// @param [in] track   The index of the track within the index
+/// @param [in] sample  The zero-based index of the sample
+/// @return             The MuTFFError code
+///
+MuTFFError mutff_sample_index_entry(const MuTFFSampleIndexEntry **out,
+                                    const MuTFFSampleIndex *index,
+                                    size_t track, uint32_t sample);
+
+///
+/// @brief Find the sample in a sample index which is displayed at a given time
+///
+/// @param [out] out    The zero-based index of the sample
+/// @param [in] index   The index
+/// @param [in] track   The index of the track within the index
+/// @param [in] time    The decode time, in the track's media time scale
+/// @return             The MuTFFError code. MuTFFErrorEOF if the time is after
+///                     the end of the track.
+///
+MuTFFError mutff_sample_index_find_time(uint32_t *out,
+                                        const MuTFFSampleIndex *index,
+                                        size_t track, uint64_t time);
+
+/// @} MuTFF
+
+#endif  // MUTFF_SAMPLE_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
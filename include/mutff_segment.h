@@ -0,0 +1,140 @@
+///
+/// @file      mutff_segment.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library on-demand segment header
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_SEGMENT_H_
+#define MUTFF_SEGMENT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_sample.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+#define MuTFF_MAX_SEGMENT_RANGES 16U
+
+///
+/// @brief A fragmented segment of one track of a progressive movie
+///
+/// The segment is the `header_size` bytes at `header`, a movie fragment atom
+/// and the header of a movie data atom, followed by each range of the
+/// original file in turn, `size` bytes in all.
+///
+typedef struct {
+  unsigned char *header;
+  size_t header_size;
+  uint64_t size;
+  uint32_t first_sample;
+  uint32_t sample_count;
+  uint64_t decode_time;
+  size_t range_count;
+  MuTFFAtomExtent range[MuTFF_MAX_SEGMENT_RANGES];
+} MuTFFSegment;
+
+///
+/// @brief Make one fragmented segment of a track
+///
+/// Segment `number` is made of the samples from the first sync sample decoded
+/// at or after `number * duration` up to the first sync sample decoded at or
+/// after `(number + 1) * duration`, so any segment can be made alone. The
+/// movie fragment's sequence number is `number + 1`, and its runs carry the
+/// samples' composition offsets. The movie fragment is written an atom at a
+/// time, so needs little memory beyond buf.
+///
+/// @param [out] out        The segment
+/// @param [in] buf         Where to write the header
+/// @param [in] buf_size    The size of buf
+/// @param [in] index       The sample index of the movie
+/// @param [in] track       The index of the track within the index
+/// @param [in] number      The zero-based number of the segment
+/// @param [in] duration    The duration of segments, in the media time scale
+/// @return                 The MuTFFError code. MuTFFErrorEOF if the segment
+///                         starts after the end of the track.
+///                         MuTFFErrorBadFormat if no sync sample begins the
+///                         segment. MuTFFErrorOutOfMemory if the header does
+///                         not fit in buf or the segment has too many
+///                         ranges.
+///
+MuTFFError mutff_make_segment(MuTFFSegment *out, void *buf, size_t buf_size,
+                              const MuTFFSampleIndex *index, size_t track,
+                              uint32_t number, uint64_t duration);
+
+///
+/// @brief A segment held in a segment cache
+///
+typedef struct {
+  bool valid;
+  size_t track;
+  uint32_t number;
+  uint64_t last_used;
+  MuTFFSegment segment;
+} MuTFFSegmentCacheEntry;
+
+///
+/// @brief A least-recently-used cache of segments
+///
+/// A cache holds the segments of a single sample index with a single segment
+/// duration. All memory used by the cache is provided by the caller when it
+/// is initialised. A cache has no internal locking and must only be used by
+/// one thread at a time.
+///
+typedef struct {
+  MuTFFSegmentCacheEntry *entries;
+  size_t entry_count;
+  unsigned char *buf;
+  size_t header_size;
+  uint64_t clock;
+} MuTFFSegmentCache;
+
+///
+/// @brief Initialise a segment cache
+///
+/// The memory at buf is divided equally between the entries to hold their
+/// headers.
+///
+/// @param [out] cache        The cache
+/// @param [in] entries       The entries to use
+/// @param [in] entry_count   The number of entries
+/// @param [in] buf           Memory for the headers
+/// @param [in] buf_size      The size of buf
+///
+void mutff_segment_cache_init(MuTFFSegmentCache *cache,
+                              MuTFFSegmentCacheEntry *entries,
+                              size_t entry_count, void *buf, size_t buf_size);
+
+///
+/// @brief Get a segment from a segment cache, making it if it is not held
+///
+/// A segment made replaces the one used least recently. The segment returned
+/// is valid until the cache next makes a segment.
+///
+/// @see mutff_make_segment
+///
+/// @param [out] out        The segment
+/// @param [in] cache       The cache
+/// @param [in] index       The sample index of the movie
+/// @param [in] track       The index of the track within the index
+/// @param [in] number      The zero-based number of the segment
+/// @param [in] duration    The duration of segments, in the media time scale
+/// @return                 The MuTFFError code
+///
+MuTFFError mutff_segment_cache_get(const MuTFFSegment **out,
+                                   MuTFFSegmentCache *cache,
+                                   const MuTFFSampleIndex *index, size_t track,
+                                   uint32_t number, uint64_t duration);
+
+/// @} MuTFF
+
+#endif  // MUTFF_SEGMENT_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,83 @@
+///
+/// @file      mutff_summary.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library movie summary header file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_SUMMARY_H_
+#define MUTFF_SUMMARY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_dialect.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+///
+/// @brief Summary of a track
+///
+/// `codec` is the data format of the track's first sample description, and
+/// `width` and `height` are the integral parts of the track dimensions.
+/// `time_scale` and `duration` are those of the track's media.
+///
+typedef struct {
+  uint32_t track_id;
+  uint32_t handler_type;
+  uint32_t codec;
+  uint16_t width;
+  uint16_t height;
+  uint16_t language;
+  uint32_t time_scale;
+  uint32_t duration;
+  uint32_t sample_count;
+} MuTFFTrackSummary;
+
+///
+/// @brief Summary of a movie file
+///
+/// A small alternative to MuTFFMovieFile for callers which only need the most
+/// commonly used facts about a file.
+///
+typedef struct {
+  uint32_t major_brand;
+  uint32_t minor_version;
+  size_t compatible_brands_count;
+  uint32_t compatible_brands[MuTFF_MAX_COMPATIBLE_BRANDS];
+  MuTFFDialect dialect;
+
+  uint32_t time_scale;
+  uint32_t duration;
+
+  size_t track_count;
+  MuTFFTrackSummary track[MuTFF_MAX_TRACK_ATOMS];
+} MuTFFMovieSummary;
+
+///
+/// @brief Read the summary of a movie file
+///
+/// Only the atoms needed for the summary are read, all others are skipped.
+/// Compatible brands beyond MuTFF_MAX_COMPATIBLE_BRANDS are ignored. Atoms which
+/// are not part of the file's dialect are skipped without being examined, and
+/// if the dialect places the movie atom first reading stops once it has been
+/// read, leaving the context at the start of the following atom.
+///
+/// @param [in] ctx  The context
+/// @param [out] n   The number of bytes read
+/// @param [out] out The summary
+/// @return          The MuTFFError code
+///
+MuTFFError mutff_read_movie_summary(MuTFFContext *ctx, size_t *n,
+                                    MuTFFMovieSummary *out);
+
+/// @} MuTFF
+
+#endif  // MUTFF_SUMMARY_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,124 @@
+///
+/// @file      mutff_sync.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library sync sample alignment header
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_SYNC_H_
+#define MUTFF_SYNC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+#define MuTFF_MAX_SYNC_MISALIGNMENTS 16U
+
+///
+/// @brief Iterator over the presentation times of a track's sync samples
+///
+/// Times are those of the sync samples' decode times, as given by the
+/// time-to-sample and sync sample atoms, placed on the movie timeline by the
+/// track's edit list and converted to a chosen time scale.
+///
+typedef struct {
+  const MuTFFSampleTableAtom *sample_table;
+  uint32_t media_time_scale;
+  uint32_t time_scale;
+  uint64_t media_start;
+  int64_t start;
+  uint32_t sample_count;
+  uint32_t sync_index;
+  uint32_t sample;
+  uint64_t decode_time;
+  uint32_t stts_entry;
+  uint32_t stts_sample;
+
+  // the next time, read ahead while checking alignment
+  bool pending;
+  int64_t pending_time;
+} MuTFFSyncTimeIterator;
+
+///
+/// @brief Begin iterating over the sync samples of a track
+///
+/// Only the first non-empty edit, and any empty edits preceding it, are taken
+/// into account.
+///
+/// @param [out] out         The iterator
+/// @param [in] movie        The movie
+/// @param [in] track        The index of the track within the movie
+/// @param [in] time_scale   The time scale of the times produced
+/// @return                  The MuTFFError code
+///
+MuTFFError mutff_sync_time_iterator_init(MuTFFSyncTimeIterator *out,
+                                         const MuTFFMovieAtom *movie,
+                                         size_t track, uint32_t time_scale);
+
+///
+/// @brief Get the presentation time of the next sync sample
+///
+/// @param [out] out        The time
+/// @param [in,out] it      The iterator
+/// @return                 The MuTFFError code. MuTFFErrorEOF after the last
+///                         sync sample.
+///
+MuTFFError mutff_sync_time_next(int64_t *out, MuTFFSyncTimeIterator *it);
+
+///
+/// @brief A sync sample without a counterpart in every other rendition
+///
+/// `sync_index` is the zero-based index of the sync sample within the
+/// rendition, so is also the index of the group of pictures it starts.
+///
+typedef struct {
+  int64_t time;
+  size_t rendition;
+  uint32_t sync_index;
+} MuTFFSyncMisalignment;
+
+///
+/// @brief The result of checking the alignment of sync samples
+///
+/// Every misalignment is counted, only the first MuTFF_MAX_SYNC_MISALIGNMENTS
+/// are recorded.
+///
+typedef struct {
+  uint32_t aligned_count;
+  uint32_t misalignment_count;
+  MuTFFSyncMisalignment misalignment[MuTFF_MAX_SYNC_MISALIGNMENTS];
+} MuTFFSyncAlignment;
+
+///
+/// @brief Check that the sync samples of several renditions line up
+///
+/// The sync times of all renditions are merged in a single pass, keeping the
+/// renditions in a min-heap by their next time. A sync sample is aligned if
+/// every rendition has a sync sample within tolerance of it. Misalignments are
+/// recorded in order of time.
+///
+/// @param [out] out         The result
+/// @param [in,out] its      An iterator for each rendition, all producing times
+///                          in the same time scale
+/// @param [in] count        The number of renditions
+/// @param [in] tolerance    The greatest permitted difference in time
+/// @param [in] heap         Working space for count rendition indices
+/// @return                  The MuTFFError code
+///
+MuTFFError mutff_check_sync_alignment(MuTFFSyncAlignment *out,
+                                      MuTFFSyncTimeIterator *its, size_t count,
+                                      uint64_t tolerance, size_t *heap);
+
+/// @} MuTFF
+
+#endif  // MUTFF_SYNC_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
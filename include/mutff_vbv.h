@@ -0,0 +1,98 @@
+///
+/// @file      mutff_vbv.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library decoder buffer model header
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_VBV_H_
+#define MUTFF_VBV_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+#define MuTFF_MAX_VBV_EVENTS 16U
+
+///
+/// @brief A constant bit rate decoder buffer
+///
+/// Data arrives at `bit_rate` bits per second from time zero. Each sample is
+/// removed whole at its decode time plus `initial_delay`, which is in the
+/// media time scale.
+///
+typedef struct {
+  uint64_t bit_rate;
+  uint64_t buffer_size;
+  uint64_t initial_delay;
+} MuTFFVBVModel;
+
+///
+/// @brief Types of buffer violation
+///
+typedef enum {
+  // a sample had not wholly arrived by the time it was removed
+  MuTFFVBVUnderflow,
+  // the buffer held more than its size just before a sample was removed
+  MuTFFVBVOverflow,
+} MuTFFVBVEventType;
+
+///
+/// @brief A buffer violation
+///
+/// `time` is the removal time of the sample in the media time scale and
+/// `excess` the number of bits by which the buffer was short or over.
+///
+typedef struct {
+  MuTFFVBVEventType type;
+  uint32_t sample;
+  uint64_t time;
+  uint64_t excess;
+} MuTFFVBVEvent;
+
+///
+/// @brief The result of a decoder buffer simulation
+///
+/// Every violation is counted, only the first MuTFF_MAX_VBV_EVENTS are
+/// recorded. `min_initial_delay`, in the media time scale, is the least delay
+/// at the model's bit rate with no underflows, and `min_buffer_size` the
+/// least buffer size with no overflows at that delay.
+///
+typedef struct {
+  uint32_t underflow_count;
+  uint32_t overflow_count;
+  size_t event_count;
+  MuTFFVBVEvent event[MuTFF_MAX_VBV_EVENTS];
+  uint64_t peak_fullness;
+  uint64_t min_initial_delay;
+  uint64_t min_buffer_size;
+} MuTFFVBVReport;
+
+///
+/// @brief Simulate a decoder buffer over a track
+///
+/// The sample sizes and decode times are taken from the sample table, so no
+/// media is read. The table is walked once more to find `min_buffer_size`.
+///
+/// @param [out] out           The result
+/// @param [in] sample_table   The sample table of the track
+/// @param [in] time_scale     The media time scale of the track
+/// @param [in] model          The buffer
+/// @return                    The MuTFFError code
+///
+MuTFFError mutff_simulate_vbv(MuTFFVBVReport *out,
+                              const MuTFFSampleTableAtom *sample_table,
+                              uint32_t time_scale, const MuTFFVBVModel *model);
+
+/// @} MuTFF
+
+#endif  // MUTFF_VBV_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
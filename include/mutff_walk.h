@@ -0,0 +1,118 @@
+///
+/// @file      mutff_walk.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library atom walker header file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_WALK_H_
+#define MUTFF_WALK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+
+/// @addtogroup MuTFF
+/// @{
+
+#define MuTFF_MAX_ATOM_DEPTH 8U
+
+///
+/// @brief The header of an atom visited by an atom walker
+///
+/// `offset` is relative to the start of the region being walked and `depth` is
+/// zero for atoms at the top level of the region.
+///
+typedef struct {
+  uint64_t offset;
+  uint64_t size;
+  uint32_t type;
+  size_t header_size;
+  size_t depth;
+} MuTFFAtomInfo;
+
+///
+/// @brief State of an iterative walk over a tree of atoms
+///
+/// The walker uses no recursion and has a fixed size, so the memory used to
+/// walk a file does not depend on its contents. Containers nested more than
+/// MuTFF_MAX_ATOM_DEPTH deep cannot be entered.
+///
+typedef struct {
+  unsigned int start;
+  uint64_t next;
+  size_t depth;
+  uint64_t end[MuTFF_MAX_ATOM_DEPTH + 1U];
+} MuTFFAtomWalker;
+
+///
+/// @brief Begin walking the atoms in a region of a file
+///
+/// The region starts at the current position of the context.
+///
+/// @param [in] ctx      The context
+/// @param [out] walker  The walker
+/// @param [in] size     The size of the region in bytes, or UINT64_MAX to walk
+///                      to the end of the file
+/// @return              The MuTFFError code
+///
+MuTFFError mutff_atom_walker_init(MuTFFContext *ctx, MuTFFAtomWalker *walker,
+                                  uint64_t size);
+
+///
+/// @brief Visit the next atom
+///
+/// On success the context is positioned at the start of the atom's header, so
+/// the atom may be read with the usual reader functions. Atoms which are
+/// neither read nor entered are skipped.
+///
+/// @param [in] ctx         The context
+/// @param [in,out] walker  The walker
+/// @param [out] out        The atom
+/// @return                 The MuTFFError code. MuTFFErrorEOF once every atom
+///                         in the region has been visited.
+///
+MuTFFError mutff_atom_walker_next(MuTFFContext *ctx, MuTFFAtomWalker *walker,
+                                  MuTFFAtomInfo *out);
+
+///
+/// @brief Visit the children of the atom last returned by the walker next
+///
+/// @param [in,out] walker  The walker
+/// @param [in] atom        The atom last returned by mutff_atom_walker_next
+/// @param [in] skip        The number of bytes of the atom's data preceding its
+///                         first child
+/// @return                 The MuTFFError code. MuTFFErrorOutOfMemory if the
+///                         atom is already MuTFF_MAX_ATOM_DEPTH deep.
+///
+MuTFFError mutff_atom_walker_enter(MuTFFAtomWalker *walker,
+                                   const MuTFFAtomInfo *atom, uint64_t skip);
+
+///
+/// @brief Move the context past the last top-level atom visited
+///
+/// @param [in] ctx     The context
+/// @param [out] n      The number of bytes from the start of the region
+/// @param [in] walker  The walker
+/// @return             The MuTFFError code
+///
+MuTFFError mutff_atom_walker_finish(MuTFFContext *ctx, size_t *n,
+                                    const MuTFFAtomWalker *walker);
+
+///
+/// @brief Check whether atoms of a type only contain other atoms
+///
+/// @param [in] type  The atom type
+/// @return           Whether the type is a container type
+///
+bool mutff_is_container_atom(uint32_t type);
+
+/// @} MuTFF
+
+#endif  // MUTFF_WALK_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,803 @@
+///
+/// @file      mutff_cmov.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library compressed movie source
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_cmov.h"
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_memory.h"
+#include "mutff_util.h"
+
+#define MuTFF_DEFLATE_MAX_BITS 15U
+#define MuTFF_DEFLATE_WINDOW 32768U
+#define MuTFF_DEFLATE_MIN_MATCH 3U
+#define MuTFF_DEFLATE_MAX_MATCH 258U
+#define MuTFF_DEFLATE_HASH_SIZE 512U
+
+static const uint16_t mutff_length_base[29] = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t mutff_length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                               1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                               4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t mutff_distance_base[30] = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+static const uint8_t mutff_distance_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static uint32_t mutff_adler32(const unsigned char *data, size_t size) {
+  uint32_t a = 1;
+  uint32_t b = 0;
+  for (size_t i = 0; i < size; ++i) {
+    a = (a + data[i]) % 65521U;
+    b = (b + a) % 65521U;
+  }
+  return b << 16U | a;
+}
+
+// compressed data is read from the context a little at a time
+typedef struct {
+  MuTFFContext *ctx;
+  uint64_t remaining;
+  unsigned char in[64];
+  size_t in_pos;
+  size_t in_len;
+  uint32_t bits;
+  unsigned int bit_count;
+} MuTFFBitReader;
+
+static MuTFFError mutff_get_bits(uint32_t *out, MuTFFBitReader *r,
+                                 unsigned int count) {
+  MuTFFError err;
+  while (r->bit_count < count) {
+    if (r->in_pos == r->in_len) {
+      if (r->remaining == 0U) {
+        return MuTFFErrorBadFormat;
+      }
+      const size_t len =
+          r->remaining < sizeof(r->in) ? (size_t)r->remaining : sizeof(r->in);
+      err = mutff_read(r->ctx, r->in, (unsigned int)len);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      r->remaining -= len;
+      r->in_pos = 0;
+      r->in_len = len;
+    }
+    r->bits |= (uint32_t)r->in[r->in_pos++] << r->bit_count;
+    r->bit_count += 8U;
+  }
+  *out = r->bits & ((1UL << count) - 1U);
+  r->bits >>= count;
+  r->bit_count -= count;
+  return MuTFFErrorNone;
+}
+
+// a canonical Huffman code, as the number of codes of each length and the
+// symbols in order of code
+typedef struct {
+  uint16_t count[MuTFF_DEFLATE_MAX_BITS + 1U];
+  uint16_t symbol[288];
+} MuTFFHuffman;
+
+// the state of a decompression, kept in the caller's working space
+typedef struct {
+  MuTFFBitReader reader;
+  MuTFFHuffman literal;
+  MuTFFHuffman distance;
+  uint8_t lengths[320];
+} MuTFFInflater;
+
+static MuTFFError mutff_huffman_build(MuTFFHuffman *h, const uint8_t *lengths,
+                                      size_t symbol_count) {
+  uint16_t offset[MuTFF_DEFLATE_MAX_BITS + 1U];
+
+  memset(h->count, 0, sizeof(h->count));
+  for (size_t i = 0; i < symbol_count; ++i) {
+    h->count[lengths[i]]++;
+  }
+  h->count[0] = 0;
+  int32_t left = 1;
+  for (size_t len = 1; len <= MuTFF_DEFLATE_MAX_BITS; ++len) {
+    left = left * 2 - h->count[len];
+    if (left < 0) {
+      return MuTFFErrorBadFormat;
+    }
+  }
+  offset[1] = 0;
+  for (size_t len = 1; len < MuTFF_DEFLATE_MAX_BITS; ++len) {
+    offset[len + 1U] = offset[len] + h->count[len];
+  }
+  for (size_t i = 0; i < symbol_count; ++i) {
+    if (lengths[i] != 0U) {
+      h->symbol[offset[lengths[i]]++] = (uint16_t)i;
+    }
+  }
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_huffman_decode(uint16_t *out, MuTFFBitReader *r,
+                                       const MuTFFHuffman *h) {
+  MuTFFError err;
+  int32_t code = 0;
+  int32_t first = 0;
+  int32_t index = 0;
+  for (size_t len = 1; len <= MuTFF_DEFLATE_MAX_BITS; ++len) {
+    uint32_t bit;
+    err = mutff_get_bits(&bit, r, 1);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    code |= (int32_t)bit;
+    const int32_t count = h->count[len];
+    if (code - count < first) {
+      *out = h->symbol[index + (code - first)];
+      return MuTFFErrorNone;
+    }
+    index += count;
+    first = (first + count) << 1;
+    code <<= 1;
+  }
+  return MuTFFErrorBadFormat;
+}
+
+// decode the symbols of a compressed block
+static MuTFFError mutff_inflate_codes(unsigned char *out, size_t *len,
+                                      size_t size, MuTFFBitReader *r,
+                                      const MuTFFHuffman *lengths,
+                                      const MuTFFHuffman *distances) {
+  MuTFFError err;
+  uint16_t symbol;
+  uint32_t extra;
+  for (;;) {
+    err = mutff_huffman_decode(&symbol, r, lengths);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    if (symbol < 256U) {
+      if (*len >= size) {
+        return MuTFFErrorOutOfMemory;
+      }
+      out[(*len)++] = (unsigned char)symbol;
+      continue;
+    }
+    if (symbol == 256U) {
+      return MuTFFErrorNone;
+    }
+
+    symbol -= 257U;
+    if (symbol >= 29U) {
+      return MuTFFErrorBadFormat;
+    }
+    err = mutff_get_bits(&extra, r, mutff_length_extra[symbol]);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    const size_t length = mutff_length_base[symbol] + extra;
+    err = mutff_huffman_decode(&symbol, r, distances);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    if (symbol >= 30U) {
+      return MuTFFErrorBadFormat;
+    }
+    err = mutff_get_bits(&extra, r, mutff_distance_extra[symbol]);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    const size_t distance = mutff_distance_base[symbol] + extra;
+    if (distance > *len) {
+      return MuTFFErrorBadFormat;
+    }
+    if (length > size - *len) {
+      return MuTFFErrorOutOfMemory;
+    }
+    // copy forwards, as the match may overlap what it produces
+    for (size_t i = 0; i < length; ++i) {
+      out[*len] = out[*len - distance];
+      ++*len;
+    }
+  }
+}
+
+static MuTFFError mutff_inflate_stored(unsigned char *out, size_t *len,
+                                       size_t size, MuTFFBitReader *r) {
+  MuTFFError err;
+  uint32_t length;
+  uint32_t complement;
+  uint32_t byte;
+
+  // stored blocks start on a byte boundary
+  r->bits = 0;
+  r->bit_count = 0;
+  err = mutff_get_bits(&length, r, 16);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  err = mutff_get_bits(&complement, r, 16);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (length != (~complement & 0xffffU)) {
+    return MuTFFErrorBadFormat;
+  }
+  if (length > size - *len) {
+    return MuTFFErrorOutOfMemory;
+  }
+  for (uint32_t i = 0; i < length; ++i) {
+    err = mutff_get_bits(&byte, r, 8);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    out[(*len)++] = (unsigned char)byte;
+  }
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_inflate_fixed(unsigned char *out, size_t *len,
+                                      size_t size, MuTFFInflater *s) {
+  MuTFFError err;
+  uint8_t *lengths = s->lengths;
+
+  memset(lengths, 8, 144);
+  memset(&lengths[144], 9, 112);
+  memset(&lengths[256], 7, 24);
+  memset(&lengths[280], 8, 8);
+  err = mutff_huffman_build(&s->literal, lengths, 288);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  memset(lengths, 5, 30);
+  err = mutff_huffman_build(&s->distance, lengths, 30);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  return mutff_inflate_codes(out, len, size, &s->reader, &s->literal,
+                             &s->distance);
+}
+
+static MuTFFError mutff_inflate_dynamic(unsigned char *out, size_t *len,
+                                        size_t size, MuTFFInflater *s) {
+  static const uint8_t order[19] = {16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                    11, 4,  12, 3, 13, 2, 14, 1, 15};
+  MuTFFError err;
+  uint32_t literal_count;
+  uint32_t distance_count;
+  uint32_t code_count;
+  uint32_t x;
+  MuTFFBitReader *r = &s->reader;
+  uint8_t *lengths = s->lengths;
+  MuTFFHuffman *literal = &s->literal;
+  MuTFFHuffman *distance = &s->distance;
+
+  err = mutff_get_bits(&literal_count, r, 5);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  err = mutff_get_bits(&distance_count, r, 5);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  err = mutff_get_bits(&code_count, r, 4);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  literal_count += 257U;
+  distance_count += 1U;
+  code_count += 4U;
+  if (literal_count > 286U || distance_count > 30U) {
+    return MuTFFErrorBadFormat;
+  }
+
+  // the code lengths are themselves Huffman coded
+  memset(lengths, 0, 19);
+  for (uint32_t i = 0; i < code_count; ++i) {
+    err = mutff_get_bits(&x, r, 3);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    lengths[order[i]] = (uint8_t)x;
+  }
+  err = mutff_huffman_build(literal, lengths, 19);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  uint32_t i = 0;
+  while (i < literal_count + distance_count) {
+    uint16_t symbol;
+    err = mutff_huffman_decode(&symbol, r, literal);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    if (symbol < 16U) {
+      lengths[i++] = (uint8_t)symbol;
+      continue;
+    }
+    uint8_t repeat = 0;
+    if (symbol == 16U) {
+      if (i == 0U) {
+        return MuTFFErrorBadFormat;
+      }
+      repeat = lengths[i - 1U];
+      err = mutff_get_bits(&x, r, 2);
+      x += 3U;
+    } else if (symbol == 17U) {
+      err = mutff_get_bits(&x, r, 3);
+      x += 3U;
+    } else {
+      err = mutff_get_bits(&x, r, 7);
+      x += 11U;
+    }
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    if (i + x > literal_count + distance_count) {
+      return MuTFFErrorBadFormat;
+    }
+    while (x-- > 0U) {
+      lengths[i++] = repeat;
+    }
+  }
+  if (lengths[256] == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+
+  err = mutff_huffman_build(literal, lengths, literal_count);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  err = mutff_huffman_build(distance, &lengths[literal_count],
+                            distance_count);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  return mutff_inflate_codes(out, len, size, r, literal, distance);
+}
+
+// decompress a zlib stream of src_size bytes from the context
+static MuTFFError mutff_inflate(unsigned char *out, size_t *len, size_t size,
+                                MuTFFInflater *s, MuTFFContext *ctx,
+                                uint64_t src_size) {
+  MuTFFError err;
+  MuTFFBitReader *r = &s->reader;
+  uint32_t header;
+  uint32_t final;
+  uint32_t type;
+  uint32_t x;
+
+  r->ctx = ctx;
+  r->remaining = src_size;
+  r->in_pos = 0;
+  r->in_len = 0;
+  r->bits = 0;
+  r->bit_count = 0;
+  *len = 0;
+
+  err = mutff_get_bits(&header, r, 16);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  // the header is big-endian
+  header = (header & 0xffU) << 8U | header >> 8U;
+  if ((header & 0x0f00U) != 0x0800U || (header & 0x20U) != 0U ||
+      header % 31U != 0U) {
+    return MuTFFErrorBadFormat;
+  }
+
+  do {
+    err = mutff_get_bits(&final, r, 1);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    err = mutff_get_bits(&type, r, 2);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    switch (type) {
+      case 0:
+        err = mutff_inflate_stored(out, len, size, r);
+        break;
+      case 1:
+        err = mutff_inflate_fixed(out, len, size, s);
+        break;
+      case 2:
+        err = mutff_inflate_dynamic(out, len, size, s);
+        break;
+      default:
+        err = MuTFFErrorBadFormat;
+        break;
+    }
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+  } while (final == 0U);
+
+  // the checksum is big-endian, after the last block's byte
+  r->bits = 0;
+  r->bit_count = 0;
+  uint32_t adler = 0;
+  for (size_t i = 0; i < 4U; ++i) {
+    err = mutff_get_bits(&x, r, 8);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    adler = adler << 8U | x;
+  }
+  if (adler != mutff_adler32(out, *len)) {
+    return MuTFFErrorBadFormat;
+  }
+
+  // skip any padding
+  if (r->remaining > 0U) {
+    if (r->remaining > LONG_MAX) {
+      return MuTFFErrorBadFormat;
+    }
+    return mutff_seek(ctx, (long)r->remaining);
+  }
+  return MuTFFErrorNone;
+}
+
+typedef struct {
+  unsigned char *out;
+  size_t size;
+  size_t len;
+  uint32_t bits;
+  unsigned int bit_count;
+  bool overflow;
+} MuTFFBitWriter;
+
+static void mutff_put_bits(MuTFFBitWriter *w, uint32_t value,
+                           unsigned int count) {
+  w->bits |= value << w->bit_count;
+  w->bit_count += count;
+  while (w->bit_count >= 8U) {
+    if (w->len < w->size) {
+      w->out[w->len++] = (unsigned char)w->bits;
+    } else {
+      w->overflow = true;
+    }
+    w->bits >>= 8U;
+    w->bit_count -= 8U;
+  }
+}
+
+// Huffman codes are packed starting from their most significant bit
+static void mutff_put_code(MuTFFBitWriter *w, uint32_t code,
+                           unsigned int count) {
+  uint32_t reversed = 0;
+  for (unsigned int i = 0; i < count; ++i) {
+    reversed = reversed << 1U | (code >> i & 1U);
+  }
+  mutff_put_bits(w, reversed, count);
+}
+
+// write a symbol with the fixed literal/length code
+static void mutff_put_fixed(MuTFFBitWriter *w, uint32_t symbol) {
+  if (symbol < 144U) {
+    mutff_put_code(w, 0x30U + symbol, 8);
+  } else if (symbol < 256U) {
+    mutff_put_code(w, 0x190U + symbol - 144U, 9);
+  } else if (symbol < 280U) {
+    mutff_put_code(w, symbol - 256U, 7);
+  } else {
+    mutff_put_code(w, 0xc0U + symbol - 280U, 8);
+  }
+}
+
+static void mutff_put_match(MuTFFBitWriter *w, size_t length,
+                            size_t distance) {
+  uint32_t code = 28;
+  while (mutff_length_base[code] > length) {
+    --code;
+  }
+  mutff_put_fixed(w, 257U + code);
+  mutff_put_bits(w, (uint32_t)(length - mutff_length_base[code]),
+                 mutff_length_extra[code]);
+  code = 29;
+  while (mutff_distance_base[code] > distance) {
+    --code;
+  }
+  mutff_put_code(w, code, 5);
+  mutff_put_bits(w, (uint32_t)(distance - mutff_distance_base[code]),
+                 mutff_distance_extra[code]);
+}
+
+static uint32_t mutff_deflate_hash(const unsigned char *p) {
+  return ((uint32_t)p[0] << 10U ^ (uint32_t)p[1] << 5U ^ p[2]) %
+         MuTFF_DEFLATE_HASH_SIZE;
+}
+
+// compress data into a zlib stream as a single block using the fixed codes,
+// matching against the most recent earlier position with the same hash. head
+// holds one position per hash, stored plus one so zero is empty.
+static MuTFFError mutff_deflate(unsigned char *out, size_t *len, size_t size,
+                                uint32_t *head, const unsigned char *data,
+                                size_t data_size) {
+  MuTFFBitWriter w;
+
+  if (data_size > UINT32_MAX - 1U) {
+    return MuTFFErrorOutOfMemory;
+  }
+  memset(head, 0, MuTFF_DEFLATE_HASH_SIZE * sizeof(*head));
+  w.out = out;
+  w.size = size;
+  w.len = 0;
+  w.bits = 0;
+  w.bit_count = 0;
+  w.overflow = false;
+
+  mutff_put_bits(&w, 0x78U, 8);
+  mutff_put_bits(&w, 0x01U, 8);
+  mutff_put_bits(&w, 1, 1);
+  mutff_put_bits(&w, 1, 2);
+
+  size_t pos = 0;
+  while (pos < data_size) {
+    size_t length = 0;
+    size_t distance = 0;
+    if (data_size - pos >= MuTFF_DEFLATE_MIN_MATCH) {
+      const uint32_t hash = mutff_deflate_hash(&data[pos]);
+      const uint32_t candidate = head[hash];
+      head[hash] = (uint32_t)pos + 1U;
+      if (candidate != 0U && pos - (candidate - 1U) <= MuTFF_DEFLATE_WINDOW) {
+        const size_t max = data_size - pos < MuTFF_DEFLATE_MAX_MATCH
+                               ? data_size - pos
+                               : MuTFF_DEFLATE_MAX_MATCH;
+        const unsigned char *match = &data[candidate - 1U];
+        while (length < max && match[length] == data[pos + length]) {
+          ++length;
+        }
+        distance = pos - (candidate - 1U);
+      }
+    }
+    if (length >= MuTFF_DEFLATE_MIN_MATCH) {
+      mutff_put_match(&w, length, distance);
+      // remember the positions within the match for later matches
+      for (size_t i = 1; i < length; ++i) {
+        if (data_size - (pos + i) >= MuTFF_DEFLATE_MIN_MATCH) {
+          head[mutff_deflate_hash(&data[pos + i])] = (uint32_t)(pos + i) + 1U;
+        }
+      }
+      pos += length;
+    } else {
+      mutff_put_fixed(&w, data[pos]);
+      ++pos;
+    }
+  }
+  mutff_put_fixed(&w, 256);
+  mutff_put_bits(&w, 0, (8U - w.bit_count) % 8U);
+
+  const uint32_t adler = mutff_adler32(data, data_size);
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    mutff_put_bits(&w, adler >> shift & 0xffU, 8);
+  }
+  if (w.overflow) {
+    return MuTFFErrorOutOfMemory;
+  }
+  *len = w.len;
+  return MuTFFErrorNone;
+}
+
+// find size bytes of working space in buf after the first used bytes
+static void *mutff_cmov_scratch(unsigned char *buf, size_t buf_size,
+                                size_t used, size_t size) {
+  const size_t align = 8U;
+  size_t offset = used + (align - (uintptr_t)&buf[used] % align) % align;
+  if (used > buf_size || offset > buf_size || size > buf_size - offset) {
+    return NULL;
+  }
+  return &buf[offset];
+}
+
+// decompress the movie atom held in a 'cmov' atom into buf
+static MuTFFError mutff_read_cmov(MuTFFContext *ctx, size_t *n,
+                                  size_t *movie_size, unsigned char *buf,
+                                  size_t buf_size) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint32_t compression = 0;
+  bool movie_present = false;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  if (type != MuTFF_FOURCC('c', 'm', 'o', 'v')) {
+    return MuTFFErrorBadFormat;
+  }
+
+  // read child atoms
+  uint64_t child_size;
+  uint32_t child_type;
+  while (*n < size) {
+    MuTFF_FN(mutff_peek_atom_header, &child_size, &child_type);
+    if (child_size == 0U || *n + child_size > size) {
+      return MuTFFErrorBadFormat;
+    }
+
+    switch (child_type) {
+      case MuTFF_FOURCC('d', 'c', 'o', 'm'):
+        MuTFF_FN(mutff_read_header, &child_size, &child_type);
+        if (child_size != bytes + 4U) {
+          return MuTFFErrorBadFormat;
+        }
+        MuTFF_FN(mutff_read_u32, &compression);
+        break;
+
+      case MuTFF_FOURCC('c', 'm', 'v', 'd'): {
+        uint32_t uncompressed_size;
+        if (compression != MuTFF_FOURCC('z', 'l', 'i', 'b') ||
+            movie_present) {
+          return MuTFFErrorBadFormat;
+        }
+        MuTFF_FN(mutff_read_header, &child_size, &child_type);
+        if (child_size < bytes + 4U) {
+          return MuTFFErrorBadFormat;
+        }
+        const uint64_t data_size = child_size - bytes - 4U;
+        MuTFF_FN(mutff_read_u32, &uncompressed_size);
+        MuTFFInflater *const state = mutff_cmov_scratch(
+            buf, buf_size, uncompressed_size, sizeof(MuTFFInflater));
+        if (state == NULL) {
+          return MuTFFErrorOutOfMemory;
+        }
+        err = mutff_inflate(buf, movie_size, uncompressed_size, state, ctx,
+                            data_size);
+        if (err != MuTFFErrorNone) {
+          return err;
+        }
+        if (*movie_size != uncompressed_size) {
+          return MuTFFErrorBadFormat;
+        }
+        *n += data_size;
+        movie_present = true;
+        break;
+      }
+
+      default:
+        // unrecognised atom type - skip as per spec
+        MuTFF_SEEK_CUR(child_size);
+        break;
+    }
+  }
+  if (!movie_present) {
+    return MuTFFErrorBadFormat;
+  }
+
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_read_compressed_movie_atom(MuTFFContext *ctx, size_t *n,
+                                           MuTFFMovieAtom *out, void *buf,
+                                           size_t buf_size) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  size_t movie_size = 0;
+  bool movie_present = false;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  if (type != MuTFF_FOURCC('m', 'o', 'o', 'v')) {
+    return MuTFFErrorBadFormat;
+  }
+
+  // read child atoms
+  uint64_t child_size;
+  uint32_t child_type;
+  while (*n < size) {
+    MuTFF_FN(mutff_peek_atom_header, &child_size, &child_type);
+    if (child_size == 0U || *n + child_size > size) {
+      return MuTFFErrorBadFormat;
+    }
+
+    switch (child_type) {
+      case MuTFF_FOURCC('c', 'm', 'o', 'v'):
+        if (movie_present) {
+          return MuTFFErrorBadFormat;
+        }
+        MuTFF_FN(mutff_read_cmov, &movie_size, buf, buf_size);
+        movie_present = true;
+        break;
+
+      default:
+        // unrecognised atom type - skip as per spec
+        MuTFF_SEEK_CUR(child_size);
+        break;
+    }
+  }
+  if (!movie_present) {
+    return MuTFFErrorBadFormat;
+  }
+
+  // parse the movie atom from memory, refusing to nest compressed movies
+  MuTFFMemoryBuffer movie_buf;
+  MuTFFContext movie_ctx;
+  movie_ctx.io = mutff_memory_driver;
+  movie_ctx.file = &movie_buf;
+  mutff_memory_buffer_init(&movie_buf, buf, movie_size);
+  err = mutff_read_movie_atom(&movie_ctx, &bytes, out);
+  if (err == MuTFFErrorCompressed) {
+    return MuTFFErrorBadFormat;
+  }
+  return err;
+}
+
+MuTFFError mutff_write_compressed_movie_atom(MuTFFContext *ctx, size_t *n,
+                                            const MuTFFMovieAtom *in,
+                                            void *buf, size_t buf_size) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  unsigned char *data = buf;
+  size_t movie_size;
+  size_t compressed_size;
+
+  MuTFFMemoryBuffer movie_buf;
+  MuTFFContext movie_ctx;
+  movie_ctx.io = mutff_memory_driver;
+  movie_ctx.file = &movie_buf;
+  mutff_memory_buffer_init(&movie_buf, buf, buf_size);
+  err = mutff_write_movie_atom(&movie_ctx, &movie_size, in);
+  if (err == MuTFFErrorEOF) {
+    return MuTFFErrorOutOfMemory;
+  } else if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (movie_size > UINT32_MAX) {
+    return MuTFFErrorOutOfMemory;
+  }
+  uint32_t *const head =
+      mutff_cmov_scratch(data, buf_size, movie_size,
+                         MuTFF_DEFLATE_HASH_SIZE * sizeof(uint32_t));
+  if (head == NULL) {
+    return MuTFFErrorOutOfMemory;
+  }
+  unsigned char *const compressed =
+      (unsigned char *)&head[MuTFF_DEFLATE_HASH_SIZE];
+  err = mutff_deflate(compressed, &compressed_size,
+                      buf_size - (size_t)(compressed - data), head, data,
+                      movie_size);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (compressed_size > UINT_MAX) {
+    return MuTFFErrorOutOfMemory;
+  }
+
+  const uint64_t compressed_movie_data_size = 12U + compressed_size;
+  const uint64_t compressed_movie_size = 8U + 12U + compressed_movie_data_size;
+  MuTFF_FN(mutff_write_header, 8U + compressed_movie_size,
+           MuTFF_FOURCC('m', 'o', 'o', 'v'));
+  MuTFF_FN(mutff_write_header, compressed_movie_size,
+           MuTFF_FOURCC('c', 'm', 'o', 'v'));
+  MuTFF_FN(mutff_write_header, 12U, MuTFF_FOURCC('d', 'c', 'o', 'm'));
+  MuTFF_FN(mutff_write_u32, MuTFF_FOURCC('z', 'l', 'i', 'b'));
+  MuTFF_FN(mutff_write_header, compressed_movie_data_size,
+           MuTFF_FOURCC('c', 'm', 'v', 'd'));
+  MuTFF_FN(mutff_write_u32, (uint32_t)movie_size);
+  err = mutff_write(ctx, compressed, (unsigned int)compressed_size);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *n += compressed_size;
+  return MuTFFErrorNone;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -9,6 +9,7 @@
 
 #include "mutff_default.h"
 
+#include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -16,266 +17,35 @@
 #include <string.h>
 
 #include "mutff.h"
+#include "mutff_cmov.h"
 #include "mutff_error.h"
+#include "mutff_util.h"
 
-#define MuTFF_FN(func, ...)               \
-  do {                                    \
-    err = func(ctx, &bytes, __VA_ARGS__); \
-    if (err != MuTFFErrorNone) {          \
-      return err;                         \
-    }                                     \
-    *(n) += (bytes);                      \
-  } while (0);
-
-#define MuTFF_READ_CHILD(func, field, flag) \
-  do {                                      \
-    if (flag == true) {                     \
-      return MuTFFErrorBadFormat;           \
-    }                                       \
-    MuTFF_FN(func, field);                  \
-    (flag) = true;                          \
-  } while (0);
-
-#define MuTFF_SEEK_CUR(offset)     \
-  do {                             \
-    err = mutff_seek(ctx, offset); \
-    if (err != MuTFFErrorNone) {   \
-      return err;                  \
-    }                              \
-    *(n) += (offset);              \
-  } while (0);
-
-// Convert a number from network (big) endian to host endian.
-// These must be implemented here as newlib does not provide the
-// standard library implementations ntohs & ntohl (arpa/inet.h).
-//
-// taken from:
-// https://stackoverflow.com/questions/2100331/macro-definition-to-determine-big-endian-or-little-endian-machine
-static uint16_t mutff_ntoh_16(unsigned char *no) {
-  return ((uint16_t)no[0] << 8) | (uint16_t)no[1];
-}
-
-static void mutff_hton_16(unsigned char *dest, uint16_t n) {
-  dest[0] = n >> 8;
-  dest[1] = n;
-}
-
-static mutff_uint24_t mutff_ntoh_24(unsigned char *no) {
-  return ((mutff_uint24_t)no[0] << 16) | ((mutff_uint24_t)no[1] << 8) |
-         (mutff_uint24_t)no[2];
-}
-
-static void mutff_hton_24(unsigned char *dest, mutff_uint24_t n) {
-  // note this is using implicit truncation
-  dest[0] = n >> 16;
-  dest[1] = n >> 8;
-  dest[2] = n;
-}
-
-static uint32_t mutff_ntoh_32(unsigned char *no) {
-  return ((uint32_t)no[0] << 24) | ((uint32_t)no[1] << 16) |
-         ((uint32_t)no[2] << 8) | (uint32_t)no[3];
-}
-
-static void mutff_hton_32(unsigned char *dest, uint32_t n) {
-  // note this is using implicit truncation
-  dest[0] = n >> 24;
-  dest[1] = n >> 16;
-  dest[2] = n >> 8;
-  dest[3] = n;
-}
-
-static uint64_t mutff_ntoh_64(unsigned char *no) {
-  return ((uint64_t)no[0] << 56) | ((uint64_t)no[1] << 48) |
-         ((uint64_t)no[2] << 40) | ((uint64_t)no[3] << 32) |
-         ((uint64_t)no[4] << 24) | ((uint64_t)no[5] << 16) |
-         ((uint64_t)no[6] << 8) | (uint64_t)no[7];
-}
-
-static void mutff_hton_64(unsigned char *dest, uint64_t n) {
-  // note this is using implicit truncation
-  dest[0] = n >> 56;
-  dest[1] = n >> 48;
-  dest[2] = n >> 40;
-  dest[3] = n >> 32;
-  dest[4] = n >> 24;
-  dest[5] = n >> 16;
-  dest[6] = n >> 8;
-  dest[7] = n;
-}
-
-static MuTFFError mutff_read_u8(MuTFFContext *ctx, size_t *n, uint8_t *data) {
-  const MuTFFError err = mutff_read(ctx, data, 1);
-  if (err != MuTFFErrorNone) {
-    return err;
-  }
-  *n = 1U;
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_read_i8(MuTFFContext *ctx, size_t *n, int8_t *dest) {
-  MuTFFError err;
-  uint8_t twos;
-  size_t bytes;
-  *n = 0;
-  *n = 0;
-
-  MuTFF_FN(mutff_read_u8, &twos);
-  // convert from twos complement to implementation-defined
-  *dest = (twos & 0x7FU) - (twos & 0x80U);
-
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_read_u16(MuTFFContext *ctx, size_t *n, uint16_t *dest) {
-  unsigned char data[2];
-  const MuTFFError err = mutff_read(ctx, data, 2);
-  if (err != MuTFFErrorNone) {
-    return err;
-  }
-  // Convert from network order (big-endian)
-  // to host order (implementation-defined).
-  *dest = mutff_ntoh_16(data);
-  *n = 2U;
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_read_i16(MuTFFContext *ctx, size_t *n, int16_t *dest) {
-  MuTFFError err;
-  uint16_t twos;
-  size_t bytes;
-  *n = 0;
-
-  MuTFF_FN(mutff_read_u16, &twos);
-  *dest = (twos & 0x7FFFU) - (twos & 0x8000U);
-
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_read_u24(MuTFFContext *ctx, size_t *n,
-                                 mutff_uint24_t *dest) {
-  unsigned char data[3];
-  const MuTFFError err = mutff_read(ctx, data, 3);
-  if (err != MuTFFErrorNone) {
-    return err;
-  }
-  *dest = mutff_ntoh_24(data);
-  *n = 3U;
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_read_u32(MuTFFContext *ctx, size_t *n, uint32_t *dest) {
-  unsigned char data[4];
-  const MuTFFError err = mutff_read(ctx, data, 4);
-  if (err != MuTFFErrorNone) {
-    return err;
-  }
-  *dest = mutff_ntoh_32(data);
-  *n = 4U;
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_read_i32(MuTFFContext *ctx, size_t *n, int32_t *dest) {
-  MuTFFError err;
-  uint32_t twos;
-  size_t bytes;
-  *n = 0;
-
-  MuTFF_FN(mutff_read_u32, &twos);
-  *dest = (twos & 0x7FFFFFFFU) - (twos & 0x80000000U);
-
-  *n = bytes;
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_read_u64(MuTFFContext *ctx, size_t *n, uint64_t *dest) {
-  unsigned char data[8];
-  const MuTFFError err = mutff_read(ctx, data, 8);
-  if (err != MuTFFErrorNone) {
-    return err;
-  }
-  *dest = mutff_ntoh_64(data);
-  *n = 8U;
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_write_u8(MuTFFContext *ctx, size_t *n, uint8_t data) {
-  const MuTFFError err = mutff_write(ctx, &data, 1);
-  if (err != MuTFFErrorNone) {
-    return err;
-  }
-  *n = 1U;
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_write_i8(MuTFFContext *ctx, size_t *n, int8_t x) {
-  MuTFFError err;
-  size_t bytes;
-  *n = 0;
-  // ensure number is stored as two's complement
-  x = x >= 0 ? x : ~abs(x) + 1;
-  MuTFF_FN(mutff_write_u8, x);
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_write_u16(MuTFFContext *ctx, size_t *n, uint16_t x) {
-  unsigned char data[2];
-  // convert number to network order
-  mutff_hton_16(data, x);
-  const MuTFFError err = mutff_write(ctx, &data, 2);
-  if (err != MuTFFErrorNone) {
-    return err;
-  }
-  *n = 2U;
-  return MuTFFErrorNone;
-}
+// Size of the buffer used to serialise tables in bulk. Table entries are
+// converted to network order a block at a time and each block is passed to the
+// I/O driver in a single write, rather than issuing one write per field.
+#define MuTFF_TABLE_BUFFER_SIZE 256U
 
-static inline MuTFFError mutff_write_i16(MuTFFContext *ctx, size_t *n,
-                                         int16_t x) {
-  MuTFFError err;
-  size_t bytes;
+static MuTFFError mutff_write_u32_table(MuTFFContext *ctx, size_t *n,
+                                        const uint32_t *table, size_t count) {
+  unsigned char data[MuTFF_TABLE_BUFFER_SIZE];
+  const size_t block_len = MuTFF_TABLE_BUFFER_SIZE / 4U;
   *n = 0;
-  x = x >= 0 ? x : ~abs(x) + 1;
-  MuTFF_FN(mutff_write_u16, x);
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_write_u24(MuTFFContext *ctx, size_t *n,
-                                  mutff_uint24_t x) {
-  unsigned char data[3];
-  mutff_hton_24(data, x);
-  const MuTFFError err = mutff_write(ctx, &data, 3);
-  if (err != MuTFFErrorNone) {
-    return err;
-  }
-  *n = 3U;
-  return MuTFFErrorNone;
-}
 
-static MuTFFError mutff_write_u32(MuTFFContext *ctx, size_t *n, uint32_t x) {
-  unsigned char data[4];
-  mutff_hton_32(data, x);
-  const MuTFFError err = mutff_write(ctx, &data, 4);
-  if (err != MuTFFErrorNone) {
-    return err;
+  while (count > 0U) {
+    const size_t len = count < block_len ? count : block_len;
+    for (size_t i = 0; i < len; ++i) {
+      mutff_hton_32(&data[4U * i], table[i]);
+    }
+    const MuTFFError err = mutff_write(ctx, data, 4U * len);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    *n += 4U * len;
+    table += len;
+    count -= len;
   }
-  *n = 4U;
-  return MuTFFErrorNone;
-}
-
-static inline MuTFFError mutff_write_i32(MuTFFContext *ctx, size_t *n,
-                                         int32_t x) {
-  return mutff_write_u32(ctx, n, x >= 0 ? x : ~abs(x) + 1);
-}
 
-static MuTFFError mutff_write_u64(MuTFFContext *ctx, size_t *n, uint64_t x) {
-  unsigned char data[8];
-  mutff_hton_64(data, x);
-  const MuTFFError err = mutff_write(ctx, &data, 8);
-  if (err != MuTFFErrorNone) {
-    return err;
-  }
-  *n = 8U;
   return MuTFFErrorNone;
 }
 
@@ -384,66 +154,6 @@ static MuTFFError mutff_write_matrix(MuTFFContext *ctx, size_t *n,
   return MuTFFErrorNone;
 }
 
-// return the size of an atom including its header, given the size of the data
-// in it
-static inline uint64_t mutff_atom_size(uint64_t data_size) {
-  return data_size + 8U <= UINT32_MAX ? data_size + 8U : data_size + 16U;
-}
-
-// return the size of the data in an atom, given the size of the entire atom
-// including its header in it
-static inline uint64_t mutff_data_size(uint64_t atom_size) {
-  return atom_size <= UINT32_MAX ? atom_size - 8U : atom_size - 16U;
-}
-
-static MuTFFError mutff_read_header(MuTFFContext *ctx, size_t *n,
-                                    uint64_t *size, uint32_t *type) {
-  MuTFFError err;
-  size_t bytes;
-  *n = 0;
-  uint32_t short_size;
-
-  MuTFF_FN(mutff_read_u32, &short_size);
-  MuTFF_FN(mutff_read_u32, type);
-  if (short_size == 1U) {
-    MuTFF_FN(mutff_read_u64, size);
-  } else {
-    *size = short_size;
-  }
-
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_peek_atom_header(MuTFFContext *ctx, size_t *n,
-                                         uint64_t *size, uint32_t *type) {
-  MuTFFError err;
-  size_t bytes;
-  *n = 0;
-
-  MuTFF_FN(mutff_read_header, size, type);
-  MuTFF_SEEK_CUR(-bytes);
-
-  return MuTFFErrorNone;
-}
-
-static MuTFFError mutff_write_header(MuTFFContext *ctx, size_t *n,
-                                     uint64_t size, uint32_t type) {
-  MuTFFError err;
-  size_t bytes;
-  *n = 0;
-
-  if (size > UINT32_MAX) {
-    MuTFF_FN(mutff_write_u32, 1);
-    MuTFF_FN(mutff_write_u32, type);
-    MuTFF_FN(mutff_write_u64, size);
-  } else {
-    MuTFF_FN(mutff_write_u32, size);
-    MuTFF_FN(mutff_write_u32, type);
-  }
-
-  return MuTFFErrorNone;
-}
-
 MuTFFError mutff_read_quickdraw_rect(MuTFFContext *ctx, size_t *n,
                                      MuTFFQuickDrawRect *out) {
   MuTFFError err;
@@ -1612,6 +1322,52 @@ MuTFFError mutff_write_track_aperture_mode_dimensions_atom(
   return MuTFFErrorNone;
 }
 
+// read the extension atoms of a sound sample description, looking for the
+// 'enda' atom, which is usually found inside a 'wave' atom. Only a 'wave' atom
+// directly in the description is entered, so the recursion is one deep.
+static MuTFFError mutff_read_sound_extensions(MuTFFContext *ctx, size_t *n,
+                                              uint64_t size, bool nested,
+                                              MuTFFSoundSampleDescription *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t child_size;
+  uint32_t child_type;
+  while (*n + 8U <= size) {
+    MuTFF_FN(mutff_read_header, &child_size, &child_type);
+    if (child_size == 0U) {
+      child_size = size - (*n - bytes);
+    }
+    if (child_size < bytes || *n - bytes + child_size > size) {
+      return MuTFFErrorBadFormat;
+    }
+    const uint64_t data_size = child_size - bytes;
+    switch (child_type) {
+      case MuTFF_FOURCC('w', 'a', 'v', 'e'):
+        if (nested) {
+          MuTFF_SEEK_CUR(data_size);
+        } else {
+          MuTFF_FN(mutff_read_sound_extensions, data_size, true, out);
+        }
+        break;
+      case MuTFF_FOURCC('e', 'n', 'd', 'a'): {
+        uint16_t little_endian;
+        if (data_size < 2U) {
+          return MuTFFErrorBadFormat;
+        }
+        MuTFF_FN(mutff_read_u16, &little_endian);
+        out->little_endian = little_endian != 0U;
+        MuTFF_SEEK_CUR(data_size - 2U);
+        break;
+      }
+      default:
+        MuTFF_SEEK_CUR(data_size);
+    }
+  }
+  MuTFF_SEEK_CUR(size - *n);
+  return MuTFFErrorNone;
+}
+
 MuTFFError mutff_read_sample_description(MuTFFContext *ctx, size_t *n,
                                          MuTFFSampleDescription *out) {
   MuTFFError err;
@@ -1622,8 +1378,23 @@ MuTFFError mutff_read_sample_description(MuTFFContext *ctx, size_t *n,
   MuTFF_FN(mutff_read_u32, &out->data_format);
   MuTFF_SEEK_CUR(6U);
   MuTFF_FN(mutff_read_u16, &out->data_reference_index);
-  MuTFF_FN(mutff_media_type_read_fn(mutff_media_type(out->data_format)),
-           &out->data);
+  const MuTFFAtomReadFn read_fn =
+      mutff_media_type_read_fn(mutff_media_type(out->data_format));
+  if (read_fn != NULL) {
+    MuTFF_FN(read_fn, &out->data);
+  }
+  if (*n > size) {
+    return MuTFFErrorBadFormat;
+  }
+  if (mutff_media_type(out->data_format) == MuTFFMediaTypeHintMedia) {
+    // the additional data table is bounded by the description
+    MuTFF_FN(mutff_read_hint_sample_description, size - *n, &out->data.hint);
+  }
+  if (mutff_media_type(out->data_format) == MuTFFMediaTypeSound) {
+    MuTFF_FN(mutff_read_sound_extensions, size - *n, false, &out->data.sound);
+  }
+  // skip any data not described by the media type, such as extension atoms
+  MuTFF_SEEK_CUR(size - *n);
   return MuTFFErrorNone;
 }
 
@@ -1636,6 +1407,10 @@ static inline MuTFFError mutff_sample_description_size(
     return err;
   }
   *out = 16U + data_size;
+  if (mutff_media_type(desc->data_format) == MuTFFMediaTypeSound &&
+      desc->data.sound.little_endian) {
+    *out += 18U;
+  }
   return MuTFFErrorNone;
 }
 
@@ -1657,6 +1432,12 @@ MuTFFError mutff_write_sample_description(MuTFFContext *ctx, size_t *n,
   MuTFF_FN(mutff_write_u16, in->data_reference_index);
   MuTFF_FN(mutff_media_type_write_fn(mutff_media_type(in->data_format)),
            &in->data);
+  if (mutff_media_type(in->data_format) == MuTFFMediaTypeSound &&
+      in->data.sound.little_endian) {
+    MuTFF_FN(mutff_write_header, 18U, MuTFF_FOURCC('w', 'a', 'v', 'e'));
+    MuTFF_FN(mutff_write_header, 10U, MuTFF_FOURCC('e', 'n', 'd', 'a'));
+    MuTFF_FN(mutff_write_u16, 1U);
+  }
   return MuTFFErrorNone;
 }
 
@@ -1714,6 +1495,202 @@ MuTFFError mutff_write_video_sample_description(
   return MuTFFErrorNone;
 }
 
+MuTFFError mutff_read_hint_sample_description(MuTFFContext *ctx, size_t *n,
+                                              uint64_t size,
+                                              MuTFFHintSampleDescription *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t entry_size;
+  uint32_t tag;
+
+  out->time_scale_present = false;
+  out->time_offset_present = false;
+  out->sequence_offset_present = false;
+
+  if (size < 8U) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_FN(mutff_read_u16, &out->version);
+  MuTFF_FN(mutff_read_u16, &out->last_compatible_version);
+  MuTFF_FN(mutff_read_u32, &out->max_packet_size);
+
+  // read the additional data table, which runs to the end of the description
+  while (*n < size) {
+    if (size - *n < 8U) {
+      return MuTFFErrorBadFormat;
+    }
+    MuTFF_FN(mutff_read_header, &entry_size, &tag);
+    if (entry_size < bytes || *n - bytes + entry_size > size) {
+      return MuTFFErrorBadFormat;
+    }
+    const uint64_t data_size = entry_size - bytes;
+    switch (tag) {
+      case MuTFF_FOURCC('t', 'i', 'm', 's'):
+        if (data_size != 4U) {
+          return MuTFFErrorBadFormat;
+        }
+        MuTFF_FN(mutff_read_u32, &out->time_scale);
+        out->time_scale_present = true;
+        break;
+      case MuTFF_FOURCC('t', 's', 'r', 'o'):
+        if (data_size != 4U) {
+          return MuTFFErrorBadFormat;
+        }
+        MuTFF_FN(mutff_read_i32, &out->time_offset);
+        out->time_offset_present = true;
+        break;
+      case MuTFF_FOURCC('s', 'n', 'r', 'o'):
+        if (data_size != 4U) {
+          return MuTFFErrorBadFormat;
+        }
+        MuTFF_FN(mutff_read_i32, &out->sequence_offset);
+        out->sequence_offset_present = true;
+        break;
+      default:
+        MuTFF_SEEK_CUR(data_size);
+        break;
+    }
+  }
+
+  return MuTFFErrorNone;
+}
+
+inline MuTFFError mutff_hint_sample_description_size(
+    uint64_t *out, const MuTFFHintSampleDescription *desc) {
+  *out = 8U;
+  if (desc->time_scale_present) {
+    *out += 12U;
+  }
+  if (desc->time_offset_present) {
+    *out += 12U;
+  }
+  if (desc->sequence_offset_present) {
+    *out += 12U;
+  }
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_write_hint_sample_description(
+    MuTFFContext *ctx, size_t *n, const MuTFFHintSampleDescription *in) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  MuTFF_FN(mutff_write_u16, in->version);
+  MuTFF_FN(mutff_write_u16, in->last_compatible_version);
+  MuTFF_FN(mutff_write_u32, in->max_packet_size);
+  if (in->time_scale_present) {
+    MuTFF_FN(mutff_write_header, 12U, MuTFF_FOURCC('t', 'i', 'm', 's'));
+    MuTFF_FN(mutff_write_u32, in->time_scale);
+  }
+  if (in->time_offset_present) {
+    MuTFF_FN(mutff_write_header, 12U, MuTFF_FOURCC('t', 's', 'r', 'o'));
+    MuTFF_FN(mutff_write_i32, in->time_offset);
+  }
+  if (in->sequence_offset_present) {
+    MuTFF_FN(mutff_write_header, 12U, MuTFF_FOURCC('s', 'n', 'r', 'o'));
+    MuTFF_FN(mutff_write_i32, in->sequence_offset);
+  }
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_read_sound_sample_description(
+    MuTFFContext *ctx, size_t *n, MuTFFSoundSampleDescription *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  MuTFF_FN(mutff_read_u16, &out->version);
+  MuTFF_FN(mutff_read_u16, &out->revision_level);
+  MuTFF_FN(mutff_read_u32, &out->vendor);
+  MuTFF_FN(mutff_read_u16, &out->number_of_channels);
+  MuTFF_FN(mutff_read_u16, &out->sample_size);
+  MuTFF_FN(mutff_read_i16, &out->compression_id);
+  MuTFF_FN(mutff_read_u16, &out->packet_size);
+  MuTFF_FN(mutff_read_q16_16, &out->sample_rate);
+  out->little_endian = false;
+  if (out->version == 1U) {
+    MuTFF_FN(mutff_read_u32, &out->samples_per_packet);
+    MuTFF_FN(mutff_read_u32, &out->bytes_per_packet);
+    MuTFF_FN(mutff_read_u32, &out->bytes_per_frame);
+    MuTFF_FN(mutff_read_u32, &out->bytes_per_sample);
+  } else if (out->version == 2U) {
+    uint32_t struct_size;
+    uint64_t audio_sample_rate;
+    MuTFF_FN(mutff_read_u32, &struct_size);
+    MuTFF_FN(mutff_read_u64, &audio_sample_rate);
+    memcpy(&out->audio_sample_rate, &audio_sample_rate,
+           sizeof(out->audio_sample_rate));
+    MuTFF_FN(mutff_read_u32, &out->audio_channels);
+    MuTFF_SEEK_CUR(4U);
+    MuTFF_FN(mutff_read_u32, &out->bits_per_channel);
+    MuTFF_FN(mutff_read_u32, &out->format_specific_flags);
+    MuTFF_FN(mutff_read_u32, &out->bytes_per_audio_packet);
+    MuTFF_FN(mutff_read_u32, &out->lpcm_frames_per_audio_packet);
+    if (struct_size < 72U) {
+      return MuTFFErrorBadFormat;
+    }
+    // skip to the extension atoms
+    MuTFF_SEEK_CUR(struct_size - 72U);
+  } else if (out->version != 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  return MuTFFErrorNone;
+}
+
+inline MuTFFError mutff_sound_sample_description_size(
+    uint64_t *out, const MuTFFSoundSampleDescription *desc) {
+  switch (desc->version) {
+    case 0:
+      *out = 20U;
+      return MuTFFErrorNone;
+    case 1:
+      *out = 36U;
+      return MuTFFErrorNone;
+    case 2:
+      *out = 56U;
+      return MuTFFErrorNone;
+    default:
+      return MuTFFErrorBadFormat;
+  }
+}
+
+MuTFFError mutff_write_sound_sample_description(
+    MuTFFContext *ctx, size_t *n, const MuTFFSoundSampleDescription *in) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  if (in->version > 2U) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_FN(mutff_write_u16, in->version);
+  MuTFF_FN(mutff_write_u16, in->revision_level);
+  MuTFF_FN(mutff_write_u32, in->vendor);
+  MuTFF_FN(mutff_write_u16, in->number_of_channels);
+  MuTFF_FN(mutff_write_u16, in->sample_size);
+  MuTFF_FN(mutff_write_i16, in->compression_id);
+  MuTFF_FN(mutff_write_u16, in->packet_size);
+  MuTFF_FN(mutff_write_q16_16, in->sample_rate);
+  if (in->version == 1U) {
+    MuTFF_FN(mutff_write_u32, in->samples_per_packet);
+    MuTFF_FN(mutff_write_u32, in->bytes_per_packet);
+    MuTFF_FN(mutff_write_u32, in->bytes_per_frame);
+    MuTFF_FN(mutff_write_u32, in->bytes_per_sample);
+  } else if (in->version == 2U) {
+    uint64_t audio_sample_rate;
+    memcpy(&audio_sample_rate, &in->audio_sample_rate,
+           sizeof(audio_sample_rate));
+    MuTFF_FN(mutff_write_u32, 72U);
+    MuTFF_FN(mutff_write_u64, audio_sample_rate);
+    MuTFF_FN(mutff_write_u32, in->audio_channels);
+    MuTFF_FN(mutff_write_u32, 0x7F000000U);
+    MuTFF_FN(mutff_write_u32, in->bits_per_channel);
+    MuTFF_FN(mutff_write_u32, in->format_specific_flags);
+    MuTFF_FN(mutff_write_u32, in->bytes_per_audio_packet);
+    MuTFF_FN(mutff_write_u32, in->lpcm_frames_per_audio_packet);
+  }
+  return MuTFFErrorNone;
+}
+
 MuTFFError mutff_read_compressed_matte_atom(MuTFFContext *ctx, size_t *n,
                                             MuTFFCompressedMatteAtom *out) {
   MuTFFError err;
@@ -2965,6 +2942,31 @@ static inline MuTFFError mutff_time_to_sample_atom_size(
   return MuTFFErrorNone;
 }
 
+static MuTFFError mutff_write_time_to_sample_table(
+    MuTFFContext *ctx, size_t *n, const MuTFFTimeToSampleTableEntry *table,
+    size_t count) {
+  unsigned char data[MuTFF_TABLE_BUFFER_SIZE];
+  const size_t block_len = MuTFF_TABLE_BUFFER_SIZE / 8U;
+  *n = 0;
+
+  while (count > 0U) {
+    const size_t len = count < block_len ? count : block_len;
+    for (size_t i = 0; i < len; ++i) {
+      mutff_hton_32(&data[8U * i], table[i].sample_count);
+      mutff_hton_32(&data[8U * i + 4U], table[i].sample_duration);
+    }
+    const MuTFFError err = mutff_write(ctx, data, 8U * len);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    *n += 8U * len;
+    table += len;
+    count -= len;
+  }
+
+  return MuTFFErrorNone;
+}
+
 MuTFFError mutff_write_time_to_sample_atom(MuTFFContext *ctx, size_t *n,
                                            const MuTFFTimeToSampleAtom *in) {
   MuTFFError err;
@@ -2982,10 +2984,8 @@ MuTFFError mutff_write_time_to_sample_atom(MuTFFContext *ctx, size_t *n,
   if (in->number_of_entries * 8U != mutff_data_size(size) - 8U) {
     return MuTFFErrorBadFormat;
   }
-  for (uint32_t i = 0; i < in->number_of_entries; ++i) {
-    MuTFF_FN(mutff_write_time_to_sample_table_entry,
-             &in->time_to_sample_table[i]);
-  }
+  MuTFF_FN(mutff_write_time_to_sample_table, in->time_to_sample_table,
+           in->number_of_entries);
   return MuTFFErrorNone;
 }
 
@@ -3173,9 +3173,8 @@ MuTFFError mutff_write_sync_sample_atom(MuTFFContext *ctx, size_t *n,
   if (in->number_of_entries * 4U != mutff_data_size(size) - 8U) {
     return MuTFFErrorBadFormat;
   }
-  for (uint32_t i = 0; i < in->number_of_entries; ++i) {
-    MuTFF_FN(mutff_write_u32, in->sync_sample_table[i]);
-  }
+  MuTFF_FN(mutff_write_u32_table, in->sync_sample_table,
+           in->number_of_entries);
   return MuTFFErrorNone;
 }
 
@@ -3380,9 +3379,8 @@ MuTFFError mutff_write_sample_size_atom(MuTFFContext *ctx, size_t *n,
   MuTFF_FN(mutff_write_u32, in->sample_size);
   MuTFF_FN(mutff_write_u32, in->number_of_entries);
   if (in->sample_size == 0U) {
-    for (uint32_t i = 0; i < in->number_of_entries; ++i) {
-      MuTFF_FN(mutff_write_u32, in->sample_size_table[i]);
-    }
+    MuTFF_FN(mutff_write_u32_table, in->sample_size_table,
+             in->number_of_entries);
   }
   return MuTFFErrorNone;
 }
@@ -3440,9 +3438,8 @@ MuTFFError mutff_write_chunk_offset_atom(MuTFFContext *ctx, size_t *n,
   if (in->number_of_entries * 4U != mutff_data_size(size) - 8U) {
     return MuTFFErrorBadFormat;
   }
-  for (uint32_t i = 0; i < in->number_of_entries; ++i) {
-    MuTFF_FN(mutff_write_u32, in->chunk_offset_table[i]);
-  }
+  MuTFF_FN(mutff_write_u32_table, in->chunk_offset_table,
+           in->number_of_entries);
   return MuTFFErrorNone;
 }
 
@@ -4194,24 +4191,46 @@ MuTFFError mutff_read_base_media_information_atom(
     return MuTFFErrorBadFormat;
   }
 
-  // read child atom
+  out->sample_table_present = false;
+
+  // read child atoms
   MuTFF_FN(mutff_read_base_media_information_header_atom,
            &out->base_media_information_header);
-
-  // skip remaining space
-  MuTFF_SEEK_CUR(size - *n);
+  uint64_t child_size;
+  uint32_t child_type;
+  while (*n < size) {
+    MuTFF_FN(mutff_peek_atom_header, &child_size, &child_type);
+    if (child_size == 0U || *n + child_size > size) {
+      return MuTFFErrorBadFormat;
+    }
+    if (child_type == MuTFF_FOURCC('s', 't', 'b', 'l')) {
+      MuTFF_READ_CHILD(mutff_read_sample_table_atom, &out->sample_table,
+                       out->sample_table_present);
+    } else {
+      MuTFF_SEEK_CUR(child_size);
+    }
+  }
 
   return MuTFFErrorNone;
 }
 
 static inline MuTFFError mutff_base_media_information_atom_size(
     uint64_t *out, const MuTFFBaseMediaInformationAtom *atom) {
+  MuTFFError err;
   uint64_t size;
-  const MuTFFError err = mutff_base_media_information_header_atom_size(
+  uint64_t child_size;
+  err = mutff_base_media_information_header_atom_size(
       &size, &atom->base_media_information_header);
   if (err != MuTFFErrorNone) {
     return err;
   }
+  if (atom->sample_table_present) {
+    err = mutff_sample_table_atom_size(&child_size, &atom->sample_table);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    size += child_size;
+  }
   *out = mutff_atom_size(size);
   return MuTFFErrorNone;
 }
@@ -4229,6 +4248,9 @@ MuTFFError mutff_write_base_media_information_atom(
   MuTFF_FN(mutff_write_header, size, MuTFF_FOURCC('m', 'i', 'n', 'f'));
   MuTFF_FN(mutff_write_base_media_information_header_atom,
            &in->base_media_information_header);
+  if (in->sample_table_present) {
+    MuTFF_FN(mutff_write_sample_table_atom, &in->sample_table);
+  }
   return MuTFFErrorNone;
 }
 
@@ -4288,6 +4310,38 @@ MuTFFMediaType mutff_media_type(uint32_t type) {
       return MuTFFMediaTypeVideo;
     case MuTFF_FOURCC('v', '2', '1', '0'):
       return MuTFFMediaTypeVideo;
+    case MuTFF_FOURCC('s', 'o', 'u', 'n'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('N', 'O', 'N', 'E'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('t', 'w', 'o', 's'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('s', 'o', 'w', 't'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('i', 'n', '2', '4'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('i', 'n', '3', '2'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('f', 'l', '3', '2'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('f', 'l', '6', '4'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('l', 'p', 'c', 'm'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('u', 'l', 'a', 'w'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('a', 'l', 'a', 'w'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('i', 'm', 'a', '4'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('m', 'p', '4', 'a'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('a', 'l', 'a', 'c'):
+      return MuTFFMediaTypeSound;
+    case MuTFF_FOURCC('h', 'i', 'n', 't'):
+      return MuTFFMediaTypeHintMedia;
+    case MuTFF_FOURCC('r', 't', 'p', ' '):
+      return MuTFFMediaTypeHintMedia;
     default:
       return MuTFFMediaTypeUnknown;
   }
@@ -4297,6 +4351,10 @@ inline MuTFFAtomWriteFn mutff_media_type_write_fn(MuTFFMediaType type) {
   switch (type) {
     case MuTFFMediaTypeVideo:
       return (MuTFFAtomWriteFn)mutff_write_video_sample_description;
+    case MuTFFMediaTypeSound:
+      return (MuTFFAtomWriteFn)mutff_write_sound_sample_description;
+    case MuTFFMediaTypeHintMedia:
+      return (MuTFFAtomWriteFn)mutff_write_hint_sample_description;
     default:
       return NULL;
   }
@@ -4306,6 +4364,8 @@ inline MuTFFAtomReadFn mutff_media_type_read_fn(MuTFFMediaType type) {
   switch (type) {
     case MuTFFMediaTypeVideo:
       return (MuTFFAtomReadFn)mutff_read_video_sample_description;
+    case MuTFFMediaTypeSound:
+      return (MuTFFAtomReadFn)mutff_read_sound_sample_description;
     default:
       return NULL;
   }
@@ -4315,6 +4375,10 @@ inline MuTFFAtomSizeFn mutff_media_type_size_fn(MuTFFMediaType type) {
   switch (type) {
     case MuTFFMediaTypeVideo:
       return (MuTFFAtomSizeFn)mutff_video_sample_description_size;
+    case MuTFFMediaTypeSound:
+      return (MuTFFAtomSizeFn)mutff_sound_sample_description_size;
+    case MuTFFMediaTypeHintMedia:
+      return (MuTFFAtomSizeFn)mutff_hint_sample_description_size;
     default:
       return NULL;
   }
@@ -4849,6 +4913,16 @@ MuTFFError mutff_read_movie_atom(MuTFFContext *ctx, size_t *n,
                          movie_header_present);
         break;
 
+      case MuTFF_FOURCC('c', 'm', 'o', 'v'):
+        // decompression needs memory from the caller, who reads the movie
+        // atom again from its start
+        err = mutff_seek(ctx, -(long)*n);
+        if (err != MuTFFErrorNone) {
+          return err;
+        }
+        *n = 0;
+        return MuTFFErrorCompressed;
+
       case MuTFF_FOURCC('c', 'l', 'i', 'p'):
         MuTFF_READ_CHILD(mutff_read_clipping_atom, &out->clipping,
                          out->clipping_present);
@@ -4939,8 +5013,48 @@ static inline MuTFFError mutff_movie_atom_size(uint64_t *out,
   return MuTFFErrorNone;
 }
 
-MuTFFError mutff_write_movie_atom(MuTFFContext *ctx, size_t *n,
-                                  const MuTFFMovieAtom *in) {
+MuTFFError mutff_movie_atom_layout(MuTFFMovieAtomLayout *out,
+                                   const MuTFFMovieAtom *in) {
+  MuTFFError err;
+  uint64_t size;
+  uint64_t child_size;
+
+  err = mutff_movie_atom_size(&size, in);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  out->size = size;
+
+  // head
+  err = mutff_movie_header_atom_size(&child_size, &in->movie_header);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  out->head.offset = 0;
+  out->head.size = size - mutff_data_size(size) + child_size;
+  uint64_t offset = out->head.size;
+
+  // tracks
+  out->track_count = in->track_count;
+  for (size_t i = 0; i < in->track_count; ++i) {
+    err = mutff_track_atom_size(&child_size, &in->track[i]);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    out->track[i].offset = offset;
+    out->track[i].size = child_size;
+    offset += child_size;
+  }
+
+  // tail
+  out->tail.offset = offset;
+  out->tail.size = size - offset;
+
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_write_movie_atom_head(MuTFFContext *ctx, size_t *n,
+                                       const MuTFFMovieAtom *in) {
   MuTFFError err;
   size_t bytes;
   *n = 0;
@@ -4952,9 +5066,16 @@ MuTFFError mutff_write_movie_atom(MuTFFContext *ctx, size_t *n,
   }
   MuTFF_FN(mutff_write_header, size, MuTFF_FOURCC('m', 'o', 'o', 'v'));
   MuTFF_FN(mutff_write_movie_header_atom, &in->movie_header);
-  for (size_t i = 0; i < in->track_count; ++i) {
-    MuTFF_FN(mutff_write_track_atom, &in->track[i]);
-  }
+
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_write_movie_atom_tail(MuTFFContext *ctx, size_t *n,
+                                       const MuTFFMovieAtom *in) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+
   if (in->clipping_present) {
     MuTFF_FN(mutff_write_clipping_atom, &in->clipping);
   }
@@ -4971,6 +5092,308 @@ MuTFFError mutff_write_movie_atom(MuTFFContext *ctx, size_t *n,
   return MuTFFErrorNone;
 }
 
+MuTFFError mutff_write_movie_atom(MuTFFContext *ctx, size_t *n,
+                                  const MuTFFMovieAtom *in) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+
+  MuTFF_FN(mutff_write_movie_atom_head, in);
+  for (size_t i = 0; i < in->track_count; ++i) {
+    MuTFF_FN(mutff_write_track_atom, &in->track[i]);
+  }
+  MuTFF_FN(mutff_write_movie_atom_tail, in);
+
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_read_movie_atom_source(MuTFFContext *ctx, size_t *n,
+                                        MuTFFMovieAtomSource *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  unsigned int pos;
+
+  err = mutff_tell(ctx, &pos);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  out->offset = pos;
+  out->child_count = 0;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  if (type != MuTFF_FOURCC('m', 'o', 'o', 'v')) {
+    return MuTFFErrorBadFormat;
+  }
+  out->size = size;
+
+  // record child atoms
+  uint64_t child_size;
+  uint32_t child_type;
+  while (*n < size) {
+    MuTFF_FN(mutff_peek_atom_header, &child_size, &child_type);
+    if (child_size == 0U || *n + child_size > size) {
+      return MuTFFErrorBadFormat;
+    }
+    if (out->child_count >= MuTFF_MAX_MOVIE_CHILD_ATOMS) {
+      return MuTFFErrorOutOfMemory;
+    }
+    out->child_type[out->child_count] = child_type;
+    out->child[out->child_count].offset = *n;
+    out->child[out->child_count].size = child_size;
+    out->child_count++;
+    MuTFF_SEEK_CUR(child_size);
+  }
+
+  return MuTFFErrorNone;
+}
+
+// copy a range of bytes verbatim from a source context
+static MuTFFError mutff_copy_range(MuTFFContext *ctx, size_t *n,
+                                   MuTFFContext *src, uint64_t offset,
+                                   uint64_t size) {
+  MuTFFError err;
+  unsigned char data[MuTFF_TABLE_BUFFER_SIZE];
+  unsigned int pos;
+  *n = 0;
+
+  err = mutff_tell(src, &pos);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (offset > (uint64_t)LONG_MAX) {
+    return MuTFFErrorIOError;
+  }
+  err = mutff_seek(src, (long)offset - (long)pos);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  while (size > 0U) {
+    const unsigned int len =
+        size < sizeof(data) ? (unsigned int)size : sizeof(data);
+    err = mutff_read(src, data, len);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    err = mutff_write(ctx, data, len);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    *n += len;
+    size -= len;
+  }
+
+  return MuTFFErrorNone;
+}
+
+// a child of a rewritten movie atom, either copied from the source or
+// serialised from the movie atom structure
+typedef struct {
+  bool copy;
+  uint32_t type;
+  size_t index;
+} MuTFFRewriteStep;
+
+#define MuTFF_MAX_REWRITE_STEPS \
+  (MuTFF_MAX_MOVIE_CHILD_ATOMS + MuTFF_MAX_TRACK_ATOMS + 4U)
+
+static void mutff_rewrite_step(MuTFFRewriteStep *steps, size_t *step_count,
+                               bool copy, uint32_t type, size_t index) {
+  steps[*step_count].copy = copy;
+  steps[*step_count].type = type;
+  steps[*step_count].index = index;
+  (*step_count)++;
+}
+
+// decide how each child of a rewritten movie atom is produced
+static void mutff_plan_movie_atom_rewrite(MuTFFRewriteStep *steps,
+                                          size_t *step_count,
+                                          const MuTFFMovieAtomSource *source,
+                                          const MuTFFMovieAtom *in,
+                                          unsigned long dirty) {
+  const uint32_t trak = MuTFF_FOURCC('t', 'r', 'a', 'k');
+  size_t source_track_count = 0;
+  size_t track = 0;
+  bool clipping_seen = false;
+  bool color_table_seen = false;
+  bool user_data_seen = false;
+  bool movie_extends_seen = false;
+  *step_count = 0;
+
+  for (size_t i = 0; i < source->child_count; ++i) {
+    if (source->child_type[i] == trak) {
+      source_track_count++;
+    }
+  }
+
+  for (size_t i = 0; i < source->child_count; ++i) {
+    const uint32_t type = source->child_type[i];
+    unsigned long flag = 0;
+    bool present = true;
+    switch (type) {
+      case MuTFF_FOURCC('m', 'v', 'h', 'd'):
+        flag = MuTFF_DIRTY_MOVIE_HEADER;
+        break;
+      case MuTFF_FOURCC('c', 'l', 'i', 'p'):
+        flag = MuTFF_DIRTY_CLIPPING;
+        present = in->clipping_present;
+        clipping_seen = true;
+        break;
+      case MuTFF_FOURCC('c', 't', 'a', 'b'):
+        flag = MuTFF_DIRTY_COLOR_TABLE;
+        present = in->color_table_present;
+        color_table_seen = true;
+        break;
+      case MuTFF_FOURCC('u', 'd', 't', 'a'):
+        flag = MuTFF_DIRTY_USER_DATA;
+        present = in->user_data_present;
+        user_data_seen = true;
+        break;
+      case MuTFF_FOURCC('m', 'v', 'e', 'x'):
+        flag = MuTFF_DIRTY_MOVIE_EXTENDS;
+        present = in->movie_extends_present;
+        movie_extends_seen = true;
+        break;
+      case MuTFF_FOURCC('t', 'r', 'a', 'k'):
+        flag = MuTFF_DIRTY_TRACK(track);
+        present = track < in->track_count;
+        break;
+      default:
+        break;
+    }
+
+    if (type == trak && !present) {
+      // track removed
+    } else if ((dirty & flag) == 0U) {
+      mutff_rewrite_step(steps, step_count, true, type, i);
+    } else if (present) {
+      mutff_rewrite_step(steps, step_count, false, type, track);
+    }
+
+    // new tracks follow the last source track, or the movie header if there
+    // are no source tracks
+    if (type == trak) {
+      track++;
+    }
+    if ((type == trak && track == source_track_count) ||
+        (type == MuTFF_FOURCC('m', 'v', 'h', 'd') &&
+         source_track_count == 0U)) {
+      for (size_t j = source_track_count; j < in->track_count; ++j) {
+        mutff_rewrite_step(steps, step_count, false, trak, j);
+      }
+    }
+  }
+
+  // new children
+  if (!clipping_seen && in->clipping_present &&
+      (dirty & MuTFF_DIRTY_CLIPPING) != 0U) {
+    mutff_rewrite_step(steps, step_count, false,
+                       MuTFF_FOURCC('c', 'l', 'i', 'p'), 0);
+  }
+  if (!color_table_seen && in->color_table_present &&
+      (dirty & MuTFF_DIRTY_COLOR_TABLE) != 0U) {
+    mutff_rewrite_step(steps, step_count, false,
+                       MuTFF_FOURCC('c', 't', 'a', 'b'), 0);
+  }
+  if (!user_data_seen && in->user_data_present &&
+      (dirty & MuTFF_DIRTY_USER_DATA) != 0U) {
+    mutff_rewrite_step(steps, step_count, false,
+                       MuTFF_FOURCC('u', 'd', 't', 'a'), 0);
+  }
+  if (!movie_extends_seen && in->movie_extends_present &&
+      (dirty & MuTFF_DIRTY_MOVIE_EXTENDS) != 0U) {
+    mutff_rewrite_step(steps, step_count, false,
+                       MuTFF_FOURCC('m', 'v', 'e', 'x'), 0);
+  }
+}
+
+static MuTFFError mutff_rewrite_step_size(uint64_t *out,
+                                          const MuTFFRewriteStep *step,
+                                          const MuTFFMovieAtomSource *source,
+                                          const MuTFFMovieAtom *in) {
+  if (step->copy) {
+    *out = source->child[step->index].size;
+    return MuTFFErrorNone;
+  }
+  switch (step->type) {
+    case MuTFF_FOURCC('m', 'v', 'h', 'd'):
+      return mutff_movie_header_atom_size(out, &in->movie_header);
+    case MuTFF_FOURCC('t', 'r', 'a', 'k'):
+      return mutff_track_atom_size(out, &in->track[step->index]);
+    case MuTFF_FOURCC('c', 'l', 'i', 'p'):
+      return mutff_clipping_atom_size(out, &in->clipping);
+    case MuTFF_FOURCC('c', 't', 'a', 'b'):
+      return mutff_color_table_atom_size(out, &in->color_table);
+    case MuTFF_FOURCC('u', 'd', 't', 'a'):
+      return mutff_user_data_atom_size(out, &in->user_data);
+    default:
+      return mutff_movie_extends_atom_size(out, &in->movie_extends);
+  }
+}
+
+static MuTFFError mutff_write_rewrite_step(MuTFFContext *ctx, size_t *n,
+                                           MuTFFContext *src,
+                                           const MuTFFRewriteStep *step,
+                                           const MuTFFMovieAtomSource *source,
+                                           const MuTFFMovieAtom *in) {
+  if (step->copy) {
+    return mutff_copy_range(
+        ctx, n, src, source->offset + source->child[step->index].offset,
+        source->child[step->index].size);
+  }
+  switch (step->type) {
+    case MuTFF_FOURCC('m', 'v', 'h', 'd'):
+      return mutff_write_movie_header_atom(ctx, n, &in->movie_header);
+    case MuTFF_FOURCC('t', 'r', 'a', 'k'):
+      return mutff_write_track_atom(ctx, n, &in->track[step->index]);
+    case MuTFF_FOURCC('c', 'l', 'i', 'p'):
+      return mutff_write_clipping_atom(ctx, n, &in->clipping);
+    case MuTFF_FOURCC('c', 't', 'a', 'b'):
+      return mutff_write_color_table_atom(ctx, n, &in->color_table);
+    case MuTFF_FOURCC('u', 'd', 't', 'a'):
+      return mutff_write_user_data_atom(ctx, n, &in->user_data);
+    default:
+      return mutff_write_movie_extends_atom(ctx, n, &in->movie_extends);
+  }
+}
+
+MuTFFError mutff_rewrite_movie_atom(MuTFFContext *ctx, size_t *n,
+                                    MuTFFContext *src,
+                                    const MuTFFMovieAtomSource *source,
+                                    const MuTFFMovieAtom *in,
+                                    unsigned long dirty) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  MuTFFRewriteStep steps[MuTFF_MAX_REWRITE_STEPS];
+  size_t step_count;
+
+  if (in->track_count > MuTFF_MAX_TRACK_ATOMS) {
+    return MuTFFErrorBadFormat;
+  }
+  mutff_plan_movie_atom_rewrite(steps, &step_count, source, in, dirty);
+
+  uint64_t size = 0;
+  for (size_t i = 0; i < step_count; ++i) {
+    uint64_t child_size;
+    err = mutff_rewrite_step_size(&child_size, &steps[i], source, in);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    size += child_size;
+  }
+
+  MuTFF_FN(mutff_write_header, mutff_atom_size(size),
+           MuTFF_FOURCC('m', 'o', 'o', 'v'));
+  for (size_t i = 0; i < step_count; ++i) {
+    MuTFF_FN(mutff_write_rewrite_step, src, &steps[i], source, in);
+  }
+
+  return MuTFFErrorNone;
+}
+
 MuTFFError mutff_read_movie_fragment_header_atom(
     MuTFFContext *ctx, size_t *n, MuTFFMovieFragmentHeaderAtom *out) {
   MuTFFError err;
@@ -5623,8 +6046,107 @@ MuTFFError mutff_write_movie_fragment_atom(MuTFFContext *ctx, size_t *n,
   return MuTFFErrorNone;
 }
 
+// read a top-level atom of a movie file. A compressed movie atom is read into
+// buf, or gives MuTFFErrorCompressed if buf is NULL.
+static MuTFFError mutff_read_movie_file_atom(MuTFFContext *ctx, size_t *n,
+                                             MuTFFMovieFile *out,
+                                             bool *movie_present, void *buf,
+                                             size_t buf_size) {
+  MuTFFError err;
+  uint64_t size;
+  uint32_t type;
+  size_t bytes;
+  *n = 0;
+
+  MuTFF_FN(mutff_peek_atom_header, &size, &type);
+  if (size == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+
+  switch (type) {
+    case MuTFF_FOURCC('f', 't', 'y', 'p'):
+      return MuTFFErrorBadFormat;
+
+    case MuTFF_FOURCC('m', 'o', 'o', 'v'):
+      if (*movie_present) {
+        return MuTFFErrorBadFormat;
+      }
+      err = mutff_read_movie_atom(ctx, &bytes, &out->movie);
+      if (err == MuTFFErrorCompressed && buf != NULL) {
+        err = mutff_read_compressed_movie_atom(ctx, &bytes, &out->movie, buf,
+                                               buf_size);
+      }
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      *n += bytes;
+      *movie_present = true;
+      break;
+
+    case MuTFF_FOURCC('m', 'd', 'a', 't'):
+      if (out->movie_data_count >= MuTFF_MAX_MOVIE_DATA_ATOMS) {
+        return MuTFFErrorOutOfMemory;
+      }
+      MuTFF_FN(mutff_read_movie_data_atom,
+               &out->movie_data[out->movie_data_count]);
+      out->movie_data_count++;
+      break;
+
+    case MuTFF_FOURCC('m', 'o', 'o', 'f'):
+      if (out->movie_fragment_count >= MuTFF_MAX_MOVIE_FRAGMENT_ATOMS) {
+        return MuTFFErrorOutOfMemory;
+      }
+      MuTFF_FN(mutff_read_movie_fragment_atom,
+               &out->movie_fragment[out->movie_fragment_count]);
+      out->movie_fragment_count++;
+      break;
+
+    case MuTFF_FOURCC('f', 'r', 'e', 'e'):
+      if (out->free_count >= MuTFF_MAX_FREE_ATOMS) {
+        return MuTFFErrorOutOfMemory;
+      }
+      MuTFF_FN(mutff_read_free_atom, &out->free[out->free_count]);
+      out->free_count++;
+      break;
+
+    case MuTFF_FOURCC('s', 'k', 'i', 'p'):
+      if (out->skip_count >= MuTFF_MAX_SKIP_ATOMS) {
+        return MuTFFErrorOutOfMemory;
+      }
+      MuTFF_FN(mutff_read_skip_atom, &out->skip[out->skip_count]);
+      out->skip_count++;
+      break;
+
+    case MuTFF_FOURCC('w', 'i', 'd', 'e'):
+      if (out->wide_count >= MuTFF_MAX_WIDE_ATOMS) {
+        return MuTFFErrorOutOfMemory;
+      }
+      MuTFF_FN(mutff_read_wide_atom, &out->wide[out->wide_count]);
+      out->wide_count++;
+      break;
+
+    case MuTFF_FOURCC('p', 'n', 'o', 't'):
+      MuTFF_READ_CHILD(mutff_read_preview_atom, &out->preview,
+                       out->preview_present);
+      break;
+
+    default:
+      // unsupported basic type - skip as per spec
+      MuTFF_SEEK_CUR(size);
+      break;
+  }
+
+  return MuTFFErrorNone;
+}
+
 MuTFFError mutff_read_movie_file(MuTFFContext *ctx, size_t *n,
                                  MuTFFMovieFile *out) {
+  return mutff_read_movie_file_buffered(ctx, n, out, NULL, 0);
+}
+
+MuTFFError mutff_read_movie_file_buffered(MuTFFContext *ctx, size_t *n,
+                                          MuTFFMovieFile *out, void *buf,
+                                          size_t buf_size) {
   MuTFFError err;
   uint64_t size;
   uint32_t type;
@@ -5632,8 +6154,10 @@ MuTFFError mutff_read_movie_file(MuTFFContext *ctx, size_t *n,
   *n = 0;
   bool movie_present = false;
 
+  out->file_type_present = false;
   out->preview_present = false;
   out->movie_data_count = 0;
+  out->movie_fragment_count = 0;
   out->free_count = 0;
   out->skip_count = 0;
   out->wide_count = 0;
@@ -5645,74 +6169,92 @@ MuTFFError mutff_read_movie_file(MuTFFContext *ctx, size_t *n,
   }
 
   while (mutff_peek_atom_header(ctx, &bytes, &size, &type) == MuTFFErrorNone) {
-    if (size == 0U) {
-      return MuTFFErrorBadFormat;
-    }
-
-    switch (type) {
-      case MuTFF_FOURCC('f', 't', 'y', 'p'):
-        return MuTFFErrorBadFormat;
+    MuTFF_FN(mutff_read_movie_file_atom, out, &movie_present, buf, buf_size);
+  }
 
-      case MuTFF_FOURCC('m', 'o', 'o', 'v'):
-        MuTFF_READ_CHILD(mutff_read_movie_atom, &out->movie, movie_present);
-        break;
+  if (!movie_present) {
+    return MuTFFErrorBadFormat;
+  }
 
-      case MuTFF_FOURCC('m', 'd', 'a', 't'):
-        if (out->movie_data_count >= MuTFF_MAX_MOVIE_DATA_ATOMS) {
-          return MuTFFErrorOutOfMemory;
-        }
-        MuTFF_FN(mutff_read_movie_data_atom,
-                 &out->movie_data[out->movie_data_count]);
-        out->movie_data_count++;
-        break;
+  return MuTFFErrorNone;
+}
 
-      case MuTFF_FOURCC('m', 'o', 'o', 'f'):
-        if (out->movie_fragment_count >= MuTFF_MAX_MOVIE_FRAGMENT_ATOMS) {
-          return MuTFFErrorOutOfMemory;
-        }
-        MuTFF_FN(mutff_read_movie_fragment_atom,
-                 &out->movie_fragment[out->movie_fragment_count]);
-        out->movie_fragment_count++;
-        break;
+void mutff_init_movie_file_tail(MuTFFMovieFileTail *tail,
+                                MuTFFMovieFile *out) {
+  tail->offset = 0;
+  tail->movie_present = false;
+  out->file_type_present = false;
+  out->movie_data_count = 0;
+  out->movie_fragment_count = 0;
+  out->free_count = 0;
+  out->skip_count = 0;
+  out->wide_count = 0;
+  out->preview_present = false;
+}
 
-      case MuTFF_FOURCC('f', 'r', 'e', 'e'):
-        if (out->free_count >= MuTFF_MAX_FREE_ATOMS) {
-          return MuTFFErrorOutOfMemory;
-        }
-        MuTFF_FN(mutff_read_free_atom, &out->free[out->free_count]);
-        out->free_count++;
-        break;
+// check whether the whole of an atom starting at the current position has
+// been written, by reading its last byte
+static MuTFFError mutff_atom_complete(MuTFFContext *ctx, uint64_t size,
+                                      bool *out) {
+  MuTFFError err;
+  unsigned char last;
 
-      case MuTFF_FOURCC('s', 'k', 'i', 'p'):
-        if (out->skip_count >= MuTFF_MAX_SKIP_ATOMS) {
-          return MuTFFErrorOutOfMemory;
-        }
-        MuTFF_FN(mutff_read_skip_atom, &out->skip[out->skip_count]);
-        out->skip_count++;
-        break;
+  *out = false;
+  if (size == 0U || size - 1U > (uint64_t)LONG_MAX) {
+    return MuTFFErrorNone;
+  }
+  if (mutff_seek(ctx, (long)(size - 1U)) != MuTFFErrorNone) {
+    return MuTFFErrorNone;
+  }
+  *out = mutff_read(ctx, &last, 1) == MuTFFErrorNone;
+  err = mutff_seek(ctx, *out ? -(long)size : -(long)(size - 1U));
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  return MuTFFErrorNone;
+}
 
-      case MuTFF_FOURCC('w', 'i', 'd', 'e'):
-        if (out->wide_count >= MuTFF_MAX_WIDE_ATOMS) {
-          return MuTFFErrorOutOfMemory;
-        }
-        MuTFF_FN(mutff_read_wide_atom, &out->wide[out->wide_count]);
-        out->wide_count++;
-        break;
+MuTFFError mutff_read_movie_file_tail(MuTFFContext *ctx, size_t *n,
+                                      MuTFFMovieFileTail *tail,
+                                      MuTFFMovieFile *out) {
+  MuTFFError err;
+  uint64_t size;
+  uint32_t type;
+  size_t bytes;
+  unsigned int pos;
+  bool complete;
+  *n = 0;
 
-      case MuTFF_FOURCC('p', 'n', 'o', 't'):
-        MuTFF_READ_CHILD(mutff_read_preview_atom, &out->preview,
-                         out->preview_present);
-        break;
+  // resume from the end of the last complete atom
+  err = mutff_tell(ctx, &pos);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (tail->offset > (uint64_t)LONG_MAX) {
+    return MuTFFErrorIOError;
+  }
+  err = mutff_seek(ctx, (long)tail->offset - (long)pos);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
 
-      default:
-        // unsupported basic type - skip as per spec
-        MuTFF_SEEK_CUR(size);
-        break;
+  while (mutff_peek_atom_header(ctx, &bytes, &size, &type) == MuTFFErrorNone) {
+    err = mutff_atom_complete(ctx, size, &complete);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    if (!complete) {
+      break;
     }
-  }
 
-  if (!movie_present) {
-    return MuTFFErrorBadFormat;
+    if (type == MuTFF_FOURCC('f', 't', 'y', 'p') && tail->offset == 0U) {
+      MuTFF_FN(mutff_read_file_type_atom, &out->file_type);
+      out->file_type_present = true;
+    } else {
+      MuTFF_FN(mutff_read_movie_file_atom, out, &tail->movie_present, NULL,
+               0);
+    }
+    tail->offset += bytes;
   }
 
   return MuTFFErrorNone;
@@ -0,0 +1,100 @@
+///
+/// @file      mutff_dialect.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library file dialect source file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_dialect.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+static MuTFFDialect mutff_brand_dialect(uint32_t brand) {
+  switch (brand) {
+    case MuTFF_FOURCC('q', 't', ' ', ' '):
+      return MuTFFDialectQuickTime;
+    case MuTFF_FOURCC('i', 's', 'o', 'm'):
+    case MuTFF_FOURCC('i', 's', 'o', '2'):
+    case MuTFF_FOURCC('i', 's', 'o', '3'):
+    case MuTFF_FOURCC('i', 's', 'o', '4'):
+    case MuTFF_FOURCC('i', 's', 'o', '5'):
+    case MuTFF_FOURCC('i', 's', 'o', '6'):
+    case MuTFF_FOURCC('i', 's', 'o', '7'):
+    case MuTFF_FOURCC('i', 's', 'o', '8'):
+    case MuTFF_FOURCC('i', 's', 'o', '9'):
+    case MuTFF_FOURCC('m', 'p', '4', '1'):
+    case MuTFF_FOURCC('m', 'p', '4', '2'):
+    case MuTFF_FOURCC('a', 'v', 'c', '1'):
+    case MuTFF_FOURCC('d', 'a', 's', 'h'):
+    case MuTFF_FOURCC('M', '4', 'A', ' '):
+    case MuTFF_FOURCC('M', '4', 'V', ' '):
+    case MuTFF_FOURCC('3', 'g', 'p', '4'):
+    case MuTFF_FOURCC('3', 'g', 'p', '5'):
+    case MuTFF_FOURCC('3', 'g', 'p', '6'):
+      return MuTFFDialectISO;
+    case MuTFF_FOURCC('c', 'm', 'f', 'c'):
+    case MuTFF_FOURCC('c', 'm', 'f', '2'):
+      return MuTFFDialectCMAF;
+    default:
+      return MuTFFDialectUnknown;
+  }
+}
+
+void mutff_dialect_add_brand(MuTFFDialect *dialect, uint32_t brand) {
+  const MuTFFDialect brand_dialect = mutff_brand_dialect(brand);
+  if (brand_dialect == MuTFFDialectUnknown) {
+    return;
+  }
+  if (*dialect == MuTFFDialectUnknown ||
+      (*dialect == MuTFFDialectISO && brand_dialect == MuTFFDialectCMAF)) {
+    *dialect = brand_dialect;
+  }
+}
+
+void mutff_file_type_dialect(MuTFFDialect *out, const MuTFFFileTypeAtom *atom) {
+  *out = MuTFFDialectUnknown;
+  mutff_dialect_add_brand(out, atom->major_brand);
+  for (size_t i = 0; i < atom->compatible_brands_count; ++i) {
+    mutff_dialect_add_brand(out, atom->compatible_brands[i]);
+  }
+  if (*out == MuTFFDialectUnknown) {
+    *out = MuTFFDialectISO;
+  }
+}
+
+bool mutff_dialect_has_atom(MuTFFDialect dialect, uint32_t type) {
+  if (dialect != MuTFFDialectISO && dialect != MuTFFDialectCMAF) {
+    return true;
+  }
+  // quicktime-only atoms
+  switch (type) {
+    case MuTFF_FOURCC('w', 'i', 'd', 'e'):
+    case MuTFF_FOURCC('p', 'n', 'o', 't'):
+    case MuTFF_FOURCC('c', 'l', 'i', 'p'):
+    case MuTFF_FOURCC('c', 'r', 'g', 'n'):
+    case MuTFF_FOURCC('c', 't', 'a', 'b'):
+    case MuTFF_FOURCC('m', 'a', 't', 't'):
+    case MuTFF_FOURCC('k', 'm', 'a', 't'):
+    case MuTFF_FOURCC('l', 'o', 'a', 'd'):
+    case MuTFF_FOURCC('i', 'm', 'a', 'p'):
+    case MuTFF_FOURCC('t', 'a', 'p', 't'):
+    case MuTFF_FOURCC('g', 'm', 'h', 'd'):
+      return false;
+    default:
+      return true;
+  }
+}
+
+bool mutff_dialect_movie_first(MuTFFDialect dialect) {
+  // a CMAF header, containing the movie atom, precedes every CMAF fragment
+  return dialect == MuTFFDialectCMAF;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,395 @@
+///
+/// @file      mutff_drift.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library sync drift analysis source
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_drift.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_sample.h"
+
+#define MuTFF_EMPTY_EDIT UINT32_MAX
+
+// a run of media shown without interruption, `content` being how far into the
+// media the run starts, and `rate` the rate at which it is shown as a 16.16
+// fixed-point number
+typedef struct {
+  int64_t time;
+  int64_t content;
+  int64_t length;
+  int64_t rate;
+} MuTFFDriftSegment;
+
+typedef struct {
+  size_t segment_count;
+  MuTFFDriftSegment segment[MuTFF_MAX_EDIT_LIST_ENTRIES];
+  int64_t content_end;
+  // the movie time at which the track's last media stops being shown
+  int64_t end;
+
+  const MuTFFSampleTableAtom *stbl;
+  uint32_t media_time_scale;
+  int64_t media_start;
+  // the duration of most of the track's samples, which the drift is measured
+  // against
+  uint32_t nominal_duration;
+  uint64_t sample_count;
+
+  // cursors, moved forwards as the curve is drawn
+  size_t segment_index;
+  uint32_t stts_entry;
+  uint64_t stts_sample;
+  int64_t stts_time;
+  uint32_t ctts_entry;
+  uint64_t ctts_sample;
+} MuTFFDriftTimeline;
+
+// convert a time between time scales without overflowing the intermediate
+static int64_t mutff_rescale(int64_t time, uint32_t from, uint32_t to) {
+  return (time / from) * to + (time % from) * to / from;
+}
+
+static void mutff_drift_event(MuTFFDriftReport *report, size_t track,
+                              MuTFFDriftEventType type, int64_t time,
+                              int64_t duration) {
+  if (report->event_count < MuTFF_MAX_DRIFT_EVENTS) {
+    MuTFFDriftEvent *event = &report->event[report->event_count];
+    event->track = track;
+    event->type = type;
+    event->time = time;
+    event->duration = duration;
+  }
+  report->event_count++;
+}
+
+// the least composition offset of a track's samples, in the media time scale
+static int64_t mutff_composition_start(const MuTFFSampleTableAtom *stbl) {
+  if (stbl->composition_shift_least_greatest_present) {
+    return stbl->composition_shift_least_greatest.least_display_offset;
+  }
+  if (!stbl->composition_offset_present ||
+      stbl->composition_offset.entry_count == 0U) {
+    return 0;
+  }
+  const MuTFFCompositionOffsetAtom *ctts = &stbl->composition_offset;
+  int64_t least = INT64_MAX;
+  for (uint32_t i = 0; i < ctts->entry_count; ++i) {
+    const int32_t offset =
+        (int32_t)ctts->composition_offset_table[i].composition_offset;
+    if (offset < least) {
+      least = offset;
+    }
+  }
+  return least;
+}
+
+// add the part of an edit which shows media, [start, end) in the movie time
+// scale measured from the first composition time, which begins at `time`
+static void mutff_drift_add_media(MuTFFDriftTimeline *out,
+                                  MuTFFDriftReport *report, size_t track,
+                                  int64_t time, int64_t start, int64_t end,
+                                  int64_t rate) {
+  if (start < out->content_end) {
+    const int64_t repeat_end = end < out->content_end ? end : out->content_end;
+    mutff_drift_event(report, track, MuTFFDriftEventOverlap, time,
+                      (repeat_end - start) * 0x10000 / rate);
+    time += (repeat_end - start) * 0x10000 / rate;
+    start = repeat_end;
+  } else if (start > out->content_end) {
+    mutff_drift_event(report, track, MuTFFDriftEventSkip, time,
+                      start - out->content_end);
+  }
+  if (start >= end) {
+    return;
+  }
+  MuTFFDriftSegment *segment = &out->segment[out->segment_count++];
+  segment->time = time;
+  segment->content = start;
+  segment->length = end - start;
+  segment->rate = rate;
+  out->content_end = end;
+  out->end = time + (end - start) * 0x10000 / rate;
+}
+
+static MuTFFError mutff_drift_timeline(MuTFFDriftTimeline *out,
+                                       MuTFFDriftReport *report,
+                                       const MuTFFMovieAtom *movie,
+                                       size_t track) {
+  MuTFFError err;
+  const MuTFFSampleTableAtom *stbl;
+
+  if (track >= movie->track_count) {
+    return MuTFFErrorBadFormat;
+  }
+  const MuTFFTrackAtom *trak = &movie->track[track];
+  const uint32_t movie_time_scale = movie->movie_header.time_scale;
+  const uint32_t media_time_scale = trak->media.media_header.time_scale;
+  if (movie_time_scale == 0U || media_time_scale == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  err = mutff_media_atom_sample_table(&stbl, &trak->media);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+
+  // the media shown, in the media time scale, and the most common sample
+  // duration
+  int64_t duration = 0;
+  uint64_t sample_count = 0;
+  uint32_t nominal_count = 0;
+  out->nominal_duration = 0;
+  for (uint32_t i = 0; i < stbl->time_to_sample.number_of_entries; ++i) {
+    const MuTFFTimeToSampleTableEntry *entry =
+        &stbl->time_to_sample.time_to_sample_table[i];
+    duration += (int64_t)entry->sample_count * entry->sample_duration;
+    sample_count += entry->sample_count;
+    if (entry->sample_count > nominal_count && entry->sample_duration != 0U) {
+      nominal_count = entry->sample_count;
+      out->nominal_duration = entry->sample_duration;
+    }
+  }
+  const int64_t media_start = mutff_composition_start(stbl);
+  const int64_t media_end = media_start + duration;
+
+  out->stbl = stbl;
+  out->media_time_scale = media_time_scale;
+  out->media_start = media_start;
+  out->sample_count = sample_count;
+  out->segment_count = 0;
+  out->content_end = 0;
+  out->end = 0;
+  out->segment_index = 0;
+  out->stts_entry = 0;
+  out->stts_sample = 0;
+  out->stts_time = 0;
+  out->ctts_entry = 0;
+  out->ctts_sample = 0;
+
+  // without an edit list the media is shown from media time zero
+  MuTFFEditListEntry implicit_edit;
+  const MuTFFEditListEntry *edits = &implicit_edit;
+  uint32_t edit_count = 1;
+  if (trak->edit_present) {
+    edits = trak->edit.edit_list_atom.edit_list_table;
+    edit_count = trak->edit.edit_list_atom.number_of_entries;
+  } else {
+    implicit_edit.media_time = 0;
+    implicit_edit.track_duration = (uint32_t)mutff_rescale(
+        media_end > 0 ? media_end : 0, media_time_scale, movie_time_scale);
+    implicit_edit.media_rate.integral = 1;
+    implicit_edit.media_rate.fractional = 0;
+  }
+
+  int64_t time = 0;
+  for (uint32_t i = 0; i < edit_count; ++i) {
+    const MuTFFEditListEntry *edit = &edits[i];
+    const int64_t edit_duration = edit->track_duration;
+    const int64_t rate = (int64_t)edit->media_rate.integral * 0x10000 +
+                         edit->media_rate.fractional;
+    if (edit->media_time == MuTFF_EMPTY_EDIT) {
+      if (edit_duration > 0) {
+        mutff_drift_event(report, track, MuTFFDriftEventGap, time,
+                          edit_duration);
+      }
+      time += edit_duration;
+      continue;
+    }
+    if (rate < 0) {
+      return MuTFFErrorBadFormat;
+    }
+    if (rate == 0) {
+      // a dwell edit shows the same media for the whole edit
+      if (edit_duration > 0) {
+        mutff_drift_event(report, track, MuTFFDriftEventOverlap, time,
+                          edit_duration);
+      }
+      time += edit_duration;
+      continue;
+    }
+
+    // the media the edit asks for, measured from the first composition time
+    // and limited to the media there is
+    const int64_t start = mutff_rescale(
+        (int64_t)edit->media_time - media_start, media_time_scale,
+        movie_time_scale);
+    const int64_t end = start + edit_duration * rate / 0x10000;
+    const int64_t available = mutff_rescale(duration, media_time_scale,
+                                            movie_time_scale);
+    const int64_t shown_start = start < 0 ? 0 : start;
+    const int64_t shown_end = end > available ? available : end;
+    if (shown_start >= shown_end) {
+      mutff_drift_event(report, track, MuTFFDriftEventGap, time,
+                        edit_duration);
+      time += edit_duration;
+      continue;
+    }
+    const int64_t lead = (shown_start - start) * 0x10000 / rate;
+    if (lead > 0) {
+      mutff_drift_event(report, track, MuTFFDriftEventGap, time, lead);
+    }
+    mutff_drift_add_media(out, report, track, time + lead, shown_start,
+                          shown_end, rate);
+    const int64_t shown = time + (shown_end - start) * 0x10000 / rate;
+    if (shown < time + edit_duration) {
+      mutff_drift_event(report, track, MuTFFDriftEventGap, shown,
+                        time + edit_duration - shown);
+    }
+    time += edit_duration;
+  }
+  return MuTFFErrorNone;
+}
+
+// the outcome of looking up media in a timeline
+typedef enum {
+  MuTFFDriftShown,
+  MuTFFDriftHidden,
+  MuTFFDriftEnded,
+} MuTFFDriftLookup;
+
+// find the movie time at which a track shows the media `nominal` in, that is
+// the media which would be shown then if every sample had the nominal
+// duration. The cursors only move forwards, apart from the segment cursor
+// stepping back over reordered samples.
+static MuTFFDriftLookup mutff_drift_time(int64_t *out,
+                                         MuTFFDriftTimeline *timeline,
+                                         int64_t nominal,
+                                         uint32_t movie_time_scale) {
+  const MuTFFSampleTableAtom *stbl = timeline->stbl;
+  if (timeline->nominal_duration == 0U) {
+    return MuTFFDriftEnded;
+  }
+  const int64_t media = mutff_rescale(nominal, movie_time_scale,
+                                      timeline->media_time_scale);
+  const uint64_t sample = (uint64_t)media / timeline->nominal_duration;
+  const int64_t within = media % timeline->nominal_duration;
+  if (sample >= timeline->sample_count) {
+    return MuTFFDriftEnded;
+  }
+
+  // the decode time of the sample
+  const MuTFFTimeToSampleAtom *stts = &stbl->time_to_sample;
+  for (;;) {
+    const MuTFFTimeToSampleTableEntry *entry =
+        &stts->time_to_sample_table[timeline->stts_entry];
+    if (sample < timeline->stts_sample + entry->sample_count) {
+      break;
+    }
+    timeline->stts_sample += entry->sample_count;
+    timeline->stts_time +=
+        (int64_t)entry->sample_count * entry->sample_duration;
+    timeline->stts_entry++;
+  }
+  const MuTFFTimeToSampleTableEntry *entry =
+      &stts->time_to_sample_table[timeline->stts_entry];
+  int64_t time =
+      timeline->stts_time +
+      (int64_t)(sample - timeline->stts_sample) * entry->sample_duration;
+
+  // and its composition offset
+  if (stbl->composition_offset_present) {
+    const MuTFFCompositionOffsetAtom *ctts = &stbl->composition_offset;
+    while (timeline->ctts_entry < ctts->entry_count &&
+           sample >= timeline->ctts_sample +
+                         ctts->composition_offset_table[timeline->ctts_entry]
+                             .sample_count) {
+      timeline->ctts_sample +=
+          ctts->composition_offset_table[timeline->ctts_entry].sample_count;
+      timeline->ctts_entry++;
+    }
+    if (timeline->ctts_entry < ctts->entry_count) {
+      time += (int32_t)ctts->composition_offset_table[timeline->ctts_entry]
+                  .composition_offset;
+    }
+  }
+
+  const int64_t content =
+      mutff_rescale(time - timeline->media_start + within,
+                    timeline->media_time_scale, movie_time_scale);
+  if (content >= timeline->content_end) {
+    return MuTFFDriftEnded;
+  }
+  while (timeline->segment_index > 0U &&
+         timeline->segment[timeline->segment_index].content > content) {
+    timeline->segment_index--;
+  }
+  while (timeline->segment_index < timeline->segment_count &&
+         timeline->segment[timeline->segment_index].content +
+                 timeline->segment[timeline->segment_index].length <=
+             content) {
+    timeline->segment_index++;
+  }
+  if (timeline->segment_index >= timeline->segment_count) {
+    return MuTFFDriftEnded;
+  }
+  const MuTFFDriftSegment *s = &timeline->segment[timeline->segment_index];
+  if (content < s->content) {
+    return MuTFFDriftHidden;
+  }
+  *out = s->time + (content - s->content) * 0x10000 / s->rate;
+  return MuTFFDriftShown;
+}
+
+MuTFFError mutff_analyse_drift(MuTFFDriftPoint *curve, size_t *curve_count,
+                               size_t max_points, MuTFFDriftReport *report,
+                               const MuTFFMovieAtom *movie, size_t audio_track,
+                               size_t video_track, uint32_t interval) {
+  MuTFFError err;
+  MuTFFDriftTimeline audio;
+  MuTFFDriftTimeline video;
+  *curve_count = 0;
+  report->event_count = 0;
+
+  if (interval == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  err = mutff_drift_timeline(&audio, report, movie, audio_track);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  err = mutff_drift_timeline(&video, report, movie, video_track);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (audio.end < video.end) {
+    mutff_drift_event(report, audio_track, MuTFFDriftEventEnd, audio.end,
+                      video.end - audio.end);
+  } else if (video.end < audio.end) {
+    mutff_drift_event(report, video_track, MuTFFDriftEventEnd, video.end,
+                      audio.end - video.end);
+  }
+
+  // compare the tracks for as long as both have media
+  const uint32_t movie_time_scale = movie->movie_header.time_scale;
+  for (int64_t nominal = 0;; nominal += interval) {
+    int64_t audio_time;
+    int64_t video_time;
+    const MuTFFDriftLookup audio_lookup =
+        mutff_drift_time(&audio_time, &audio, nominal, movie_time_scale);
+    const MuTFFDriftLookup video_lookup =
+        mutff_drift_time(&video_time, &video, nominal, movie_time_scale);
+    if (audio_lookup == MuTFFDriftEnded || video_lookup == MuTFFDriftEnded) {
+      break;
+    }
+    if (audio_lookup == MuTFFDriftHidden || video_lookup == MuTFFDriftHidden) {
+      continue;
+    }
+    if (*curve_count >= max_points) {
+      return MuTFFErrorOutOfMemory;
+    }
+    curve[*curve_count].time = video_time;
+    curve[*curve_count].drift = audio_time - video_time;
+    ++*curve_count;
+  }
+  return MuTFFErrorNone;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
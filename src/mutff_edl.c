@@ -0,0 +1,193 @@
+///
+/// @file      mutff_edl.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library edit decision list source
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_edl.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+#define MuTFF_EMPTY_EDIT UINT32_MAX
+
+// convert a time between time scales without overflowing the intermediate
+static uint64_t mutff_rescale(uint64_t time, uint32_t from, uint32_t to) {
+  return (time / from) * to + (time % from) * to / from;
+}
+
+static MuTFFError mutff_edl_media_information(MuTFFDataInformationAtom **dinf,
+                                              MuTFFSampleTableAtom **stbl,
+                                              MuTFFMediaAtom *media) {
+  MuTFFError err;
+  MuTFFMediaType media_type;
+
+  if (!media->media_information_present) {
+    return MuTFFErrorBadFormat;
+  }
+  err = mutff_media_atom_type(&media_type, media);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  switch (mutff_media_information_type(media_type)) {
+    case MuTFFVideoMediaInformation:
+      media->video_media_information.data_information_present = true;
+      *dinf = &media->video_media_information.data_information;
+      *stbl = &media->video_media_information.sample_table;
+      return MuTFFErrorNone;
+    case MuTFFSoundMediaInformation:
+      media->sound_media_information.data_information_present = true;
+      *dinf = &media->sound_media_information.data_information;
+      *stbl = &media->sound_media_information.sample_table;
+      return MuTFFErrorNone;
+    default:
+      // base media information has no data references to redirect
+      return MuTFFErrorBadFormat;
+  }
+}
+
+// start a track of the new movie with the media of a source track
+static MuTFFError mutff_edl_track(MuTFFTrackAtom *out,
+                                  const MuTFFEDLSource *source, size_t track,
+                                  uint32_t track_id) {
+  MuTFFError err;
+  MuTFFDataInformationAtom *dinf;
+  MuTFFSampleTableAtom *stbl;
+
+  if (track >= source->movie->track_count) {
+    return MuTFFErrorBadFormat;
+  }
+  const size_t url_size = strlen(source->url) + 1U;
+  if (url_size > MuTFF_MAX_DATA_REFERENCE_DATA_SIZE) {
+    return MuTFFErrorOutOfMemory;
+  }
+
+  *out = source->movie->track[track];
+  out->track_header.track_id = track_id;
+  out->track_header.duration = 0;
+  out->edit_present = true;
+  out->edit.edit_list_atom.version = 0;
+  out->edit.edit_list_atom.flags = 0;
+  out->edit.edit_list_atom.number_of_entries = 0;
+  // references are to tracks of the source
+  out->track_reference_present = false;
+  out->track_input_map_present = false;
+
+  err = mutff_edl_media_information(&dinf, &stbl, &out->media);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  MuTFFDataReferenceAtom *dref = &dinf->data_reference;
+  dref->version = 0;
+  dref->flags = 0;
+  dref->number_of_entries = 1;
+  MuTFFDataReference *url = &dref->data_references[0];
+  url->type = MuTFF_FOURCC('u', 'r', 'l', ' ');
+  url->version = 0;
+  url->flags = 0;
+  url->data_size = url_size;
+  memcpy(url->data, source->url, url_size);
+  MuTFFSampleDescriptionAtom *stsd = &stbl->sample_description;
+  for (uint32_t i = 0; i < stsd->number_of_entries; ++i) {
+    stsd->sample_description_table[i].data_reference_index = 1;
+  }
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_edl_add_edit(MuTFFEditListAtom *elst,
+                                     uint32_t track_duration,
+                                     uint32_t media_time) {
+  if (elst->number_of_entries >= MuTFF_MAX_EDIT_LIST_ENTRIES) {
+    return MuTFFErrorOutOfMemory;
+  }
+  MuTFFEditListEntry *edit = &elst->edit_list_table[elst->number_of_entries++];
+  edit->track_duration = track_duration;
+  edit->media_time = media_time;
+  edit->media_rate.integral = 1;
+  edit->media_rate.fractional = 0;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_render_edl(MuTFFMovieAtom *out, const MuTFFEDLSource *sources,
+                            size_t source_count,
+                            const MuTFFEDLSegment *segments,
+                            size_t segment_count, uint32_t time_scale) {
+  MuTFFError err;
+  size_t track_source[MuTFF_MAX_TRACK_ATOMS];
+  size_t track_track[MuTFF_MAX_TRACK_ATOMS];
+
+  if (source_count == 0U || time_scale == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  memset(out, 0, sizeof(*out));
+  out->movie_header = sources[0].movie->movie_header;
+  out->movie_header.time_scale = time_scale;
+  out->movie_header.duration = 0;
+
+  for (size_t i = 0; i < segment_count; ++i) {
+    const MuTFFEDLSegment *segment = &segments[i];
+    if (segment->source >= source_count || segment->out < segment->in) {
+      return MuTFFErrorBadFormat;
+    }
+
+    // find the segment's track, adding it if it is the first to use it
+    size_t t = 0;
+    while (t < out->track_count && (track_source[t] != segment->source ||
+                                    track_track[t] != segment->track)) {
+      ++t;
+    }
+    if (t == out->track_count) {
+      if (t >= MuTFF_MAX_TRACK_ATOMS) {
+        return MuTFFErrorOutOfMemory;
+      }
+      err = mutff_edl_track(&out->track[t], &sources[segment->source],
+                            segment->track, (uint32_t)t + 1U);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      track_source[t] = segment->source;
+      track_track[t] = segment->track;
+      out->track_count++;
+    }
+    MuTFFTrackAtom *trak = &out->track[t];
+    MuTFFEditListAtom *elst = &trak->edit.edit_list_atom;
+
+    const uint32_t media_time_scale = trak->media.media_header.time_scale;
+    if (media_time_scale == 0U) {
+      return MuTFFErrorBadFormat;
+    }
+    const uint64_t duration =
+        mutff_rescale(segment->out - segment->in, media_time_scale, time_scale);
+    const uint32_t end = trak->track_header.duration;
+    if (segment->time < end ||
+        (uint64_t)segment->time + duration > UINT32_MAX) {
+      return MuTFFErrorBadFormat;
+    }
+    if (segment->time > end) {
+      err = mutff_edl_add_edit(elst, segment->time - end, MuTFF_EMPTY_EDIT);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+    }
+    err = mutff_edl_add_edit(elst, (uint32_t)duration, segment->in);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    trak->track_header.duration = segment->time + (uint32_t)duration;
+    if (trak->track_header.duration > out->movie_header.duration) {
+      out->movie_header.duration = trak->track_header.duration;
+    }
+  }
+  out->movie_header.next_track_id = (uint32_t)out->track_count + 1U;
+  return MuTFFErrorNone;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,299 @@
+///
+/// @file      mutff_faststart.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library movie-first view source
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_faststart.h"
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_io.h"
+#include "mutff_memory.h"
+#include "mutff_walk.h"
+
+static uint32_t mutff_faststart_get_u32(const unsigned char *p) {
+  return (uint32_t)p[0] << 24U | (uint32_t)p[1] << 16U | (uint32_t)p[2] << 8U |
+         (uint32_t)p[3];
+}
+
+static void mutff_faststart_put_u32(unsigned char *p, uint32_t x) {
+  p[0] = (unsigned char)(x >> 24U);
+  p[1] = (unsigned char)(x >> 16U);
+  p[2] = (unsigned char)(x >> 8U);
+  p[3] = (unsigned char)x;
+}
+
+// read bytes from an offset in the original file
+static MuTFFError mutff_faststart_source_read(MuTFFContext *ctx, void *dest,
+                                              uint64_t offset, size_t bytes) {
+  MuTFFError err;
+  unsigned int pos;
+  unsigned char *p = dest;
+
+  err = mutff_tell(ctx, &pos);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  const int64_t delta = (int64_t)offset - (int64_t)pos;
+  if (delta != 0) {
+    err = mutff_seek(ctx, (long)delta);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+  }
+  while (bytes > 0U) {
+    const unsigned int n = bytes > UINT_MAX ? UINT_MAX : (unsigned int)bytes;
+    err = mutff_read(ctx, p, n);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    p += n;
+    bytes -= n;
+  }
+  return MuTFFErrorNone;
+}
+
+// the offset in the view of a byte of media in the original file
+static uint64_t mutff_faststart_shift(const MuTFFFaststartView *view,
+                                      uint64_t offset) {
+  if (offset >= view->insert_offset && offset < view->movie_offset) {
+    return offset + view->movie_size;
+  }
+  return offset;
+}
+
+static MuTFFError mutff_faststart_patch(const MuTFFFaststartView *view,
+                                       const MuTFFAtomInfo *atom) {
+  unsigned char *data = view->movie + atom->offset + atom->header_size;
+  const uint64_t data_size = atom->size - atom->header_size;
+  const bool co64 = atom->type == MuTFF_FOURCC('c', 'o', '6', '4');
+  const uint64_t entry_size = co64 ? 8U : 4U;
+
+  if (data_size < 8U) {
+    return MuTFFErrorBadFormat;
+  }
+  const uint32_t entry_count = mutff_faststart_get_u32(data + 4);
+  if (entry_count > (data_size - 8U) / entry_size) {
+    return MuTFFErrorBadFormat;
+  }
+  unsigned char *entry = data + 8;
+  for (uint32_t i = 0; i < entry_count; ++i) {
+    uint64_t offset = mutff_faststart_get_u32(entry);
+    if (co64) {
+      offset = offset << 32U | mutff_faststart_get_u32(entry + 4);
+    }
+    offset = mutff_faststart_shift(view, offset);
+    if (co64) {
+      mutff_faststart_put_u32(entry, (uint32_t)(offset >> 32U));
+      mutff_faststart_put_u32(entry + 4, (uint32_t)offset);
+    } else {
+      if (offset > UINT32_MAX) {
+        return MuTFFErrorBadFormat;
+      }
+      mutff_faststart_put_u32(entry, (uint32_t)offset);
+    }
+    entry += entry_size;
+  }
+  return MuTFFErrorNone;
+}
+
+// whether an atom is on the path from the movie atom to the chunk offsets
+static bool mutff_faststart_is_path_atom(uint32_t type) {
+  switch (type) {
+    case MuTFF_FOURCC('m', 'o', 'o', 'v'):
+    case MuTFF_FOURCC('t', 'r', 'a', 'k'):
+    case MuTFF_FOURCC('m', 'd', 'i', 'a'):
+    case MuTFF_FOURCC('m', 'i', 'n', 'f'):
+    case MuTFF_FOURCC('s', 't', 'b', 'l'):
+      return true;
+    default:
+      return false;
+  }
+}
+
+MuTFFError mutff_faststart_view_init(MuTFFFaststartView *out,
+                                    MuTFFContext *source, void *buf,
+                                    size_t buf_size) {
+  MuTFFError err;
+  MuTFFAtomWalker walker;
+  MuTFFAtomInfo atom;
+  bool movie_present = false;
+
+  out->source = source;
+  out->movie = buf;
+  out->movie_size = 0;
+  out->movie_offset = 0;
+  out->insert_offset = 0;
+  out->pos = 0;
+
+  // find the movie atom and where it is to go
+  err = mutff_atom_walker_init(source, &walker, UINT64_MAX);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  while ((err = mutff_atom_walker_next(source, &walker, &atom)) ==
+         MuTFFErrorNone) {
+    if (atom.offset == 0U && atom.type == MuTFF_FOURCC('f', 't', 'y', 'p')) {
+      out->insert_offset = atom.size;
+    } else if (!movie_present && atom.type == MuTFF_FOURCC('m', 'o', 'o', 'v')) {
+      out->movie_offset = atom.offset;
+      out->movie_size = atom.size;
+      movie_present = true;
+    }
+  }
+  if (err != MuTFFErrorEOF) {
+    return err;
+  }
+  if (!movie_present) {
+    return MuTFFErrorBadFormat;
+  }
+  out->size = walker.next;
+  if (out->movie_offset < out->insert_offset) {
+    // already at the front
+    out->insert_offset = out->movie_offset;
+  }
+  if (out->movie_size > buf_size) {
+    return MuTFFErrorOutOfMemory;
+  }
+  err = mutff_faststart_source_read(source, buf, out->movie_offset,
+                                    (size_t)out->movie_size);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+
+  // adjust the chunk offsets of every track, descending only towards them so
+  // that user data with a legacy terminator is passed over
+  MuTFFMemoryBuffer movie_buf;
+  MuTFFContext movie_ctx;
+  movie_ctx.io = mutff_memory_driver;
+  movie_ctx.file = &movie_buf;
+  mutff_memory_buffer_init(&movie_buf, buf, (size_t)out->movie_size);
+  err = mutff_atom_walker_init(&movie_ctx, &walker, out->movie_size);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  while ((err = mutff_atom_walker_next(&movie_ctx, &walker, &atom)) ==
+         MuTFFErrorNone) {
+    if (atom.type == MuTFF_FOURCC('c', 'm', 'o', 'v')) {
+      // the chunk offsets are compressed out of reach
+      return MuTFFErrorBadFormat;
+    } else if (mutff_faststart_is_path_atom(atom.type)) {
+      err = mutff_atom_walker_enter(&walker, &atom, 0);
+    } else if (atom.type == MuTFF_FOURCC('s', 't', 'c', 'o') ||
+               atom.type == MuTFF_FOURCC('c', 'o', '6', '4')) {
+      err = mutff_faststart_patch(out, &atom);
+    }
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+  }
+  if (err != MuTFFErrorEOF) {
+    return err;
+  }
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_faststart_read_at(MuTFFFaststartView *view, void *dest,
+                                   uint64_t offset, size_t bytes) {
+  MuTFFError err;
+  unsigned char *p = dest;
+
+  if (offset > view->size || bytes > view->size - offset) {
+    return MuTFFErrorEOF;
+  }
+
+  // the view is the file type atom, the movie atom, the atoms the movie atom
+  // passed and the rest of the file, each read up to its end in turn
+  const uint64_t movie_end = view->insert_offset + view->movie_size;
+  const uint64_t passed_end = view->movie_offset + view->movie_size;
+  while (bytes > 0U) {
+    uint64_t end;
+    if (offset < view->insert_offset) {
+      end = view->insert_offset;
+    } else if (offset < movie_end) {
+      end = movie_end;
+    } else if (offset < passed_end) {
+      end = passed_end;
+    } else {
+      end = view->size;
+    }
+    const size_t n = end - offset < bytes ? (size_t)(end - offset) : bytes;
+
+    if (offset < view->insert_offset || offset >= passed_end) {
+      err = mutff_faststart_source_read(view->source, p, offset, n);
+    } else if (offset < movie_end) {
+      memcpy(p, &view->movie[offset - view->insert_offset], n);
+      err = MuTFFErrorNone;
+    } else {
+      err = mutff_faststart_source_read(view->source, p,
+                                        offset - view->movie_size, n);
+    }
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    p += n;
+    offset += n;
+    bytes -= n;
+  }
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_read_faststart(mutff_file_t *file, void *dest,
+                                unsigned int bytes) {
+  MuTFFFaststartView *view = file;
+  const MuTFFError err = mutff_faststart_read_at(view, dest, view->pos, bytes);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  view->pos += bytes;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_write_faststart(mutff_file_t *file, const void *src,
+                                 unsigned int bytes) {
+  return MuTFFErrorIOError;
+}
+
+MuTFFError mutff_tell_faststart(mutff_file_t *file, unsigned int *location) {
+  const MuTFFFaststartView *view = file;
+  if (view->pos > UINT_MAX) {
+    return MuTFFErrorIOError;
+  }
+  *location = (unsigned int)view->pos;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_seek_faststart(mutff_file_t *file, long delta) {
+  MuTFFFaststartView *view = file;
+  if (delta < 0) {
+    if ((unsigned long)-delta > view->pos) {
+      return MuTFFErrorIOError;
+    }
+    view->pos -= (unsigned long)-delta;
+  } else {
+    if ((unsigned long)delta > view->size - view->pos) {
+      return MuTFFErrorIOError;
+    }
+    view->pos += (unsigned long)delta;
+  }
+  return MuTFFErrorNone;
+}
+
+MuTFFIODriver mutff_faststart_driver = {
+    mutff_read_faststart,
+    mutff_write_faststart,
+    mutff_tell_faststart,
+    mutff_seek_faststart,
+};
+
+// vi:sw=2:ts=2:et:fdm=marker
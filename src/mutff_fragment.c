@@ -0,0 +1,138 @@
+///
+/// @file      mutff_fragment.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library fragmentation source
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_fragment.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_sample.h"
+
+// sum the durations of the next `samples` samples, moving the cursor forwards
+static MuTFFError mutff_fragment_duration(uint64_t *out,
+                                          const MuTFFTimeToSampleAtom *stts,
+                                          uint32_t *entry, uint32_t *sample,
+                                          uint32_t samples) {
+  *out = 0;
+  while (samples > 0U) {
+    if (*entry >= stts->number_of_entries) {
+      return MuTFFErrorBadFormat;
+    }
+    const MuTFFTimeToSampleTableEntry *e = &stts->time_to_sample_table[*entry];
+    uint32_t run = e->sample_count - *sample;
+    if (run > samples) {
+      run = samples;
+    }
+    *out += (uint64_t)run * e->sample_duration;
+    *sample += run;
+    samples -= run;
+    if (*sample >= e->sample_count) {
+      ++*entry;
+      *sample = 0;
+    }
+  }
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_fragment_emit(MuTFFFragmentRange *out, size_t *count,
+                                      size_t max_count,
+                                      const MuTFFFragmentRange *fragment) {
+  if (*count >= max_count) {
+    return MuTFFErrorOutOfMemory;
+  }
+  out[(*count)++] = *fragment;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_plan_fragments(MuTFFFragmentRange *out, size_t *count,
+                                size_t max_count,
+                                const MuTFFSampleTableAtom *sample_table,
+                                const MuTFFFragmentPolicy *policy) {
+  MuTFFError err;
+  uint32_t sample_count;
+  const MuTFFSampleSizeAtom *stsz = &sample_table->sample_size;
+  const MuTFFSyncSampleAtom *stss = &sample_table->sync_sample;
+  *count = 0;
+
+  err = mutff_sample_table_sample_count(&sample_count, sample_table);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (stsz->sample_size == 0U &&
+      (stsz->number_of_entries < sample_count ||
+       sample_count > MuTFF_MAX_SAMPLE_SIZE_TABLE_LEN)) {
+    return MuTFFErrorBadFormat;
+  }
+
+  MuTFFFragmentRange fragment = {0, 0, 0, 0};
+  uint32_t stts_entry = 0;
+  uint32_t stts_sample = 0;
+  uint32_t sync_index = 0;
+  uint32_t start = 0;
+  while (start < sample_count) {
+    // the run of samples up to the next sync sample
+    uint32_t end = start + 1U;
+    if (sample_table->sync_sample_present) {
+      while (sync_index < stss->number_of_entries &&
+             stss->sync_sample_table[sync_index] <= end) {
+        ++sync_index;
+      }
+      end = sync_index < stss->number_of_entries
+                ? stss->sync_sample_table[sync_index] - 1U
+                : sample_count;
+      if (end > sample_count) {
+        end = sample_count;
+      }
+    }
+    uint64_t size;
+    if (stsz->sample_size != 0U) {
+      size = (uint64_t)stsz->sample_size * (end - start);
+    } else {
+      size = 0;
+      for (uint32_t i = start; i < end; ++i) {
+        size += stsz->sample_size_table[i];
+      }
+    }
+    uint64_t duration;
+    err = mutff_fragment_duration(&duration, &sample_table->time_to_sample,
+                                  &stts_entry, &stts_sample, end - start);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+
+    // start a new fragment if the run does not fit in this one
+    const bool too_large = policy->max_size != 0U &&
+                           fragment.size + size > policy->max_size;
+    const bool too_long = policy->max_duration != 0U &&
+                          fragment.duration + duration > policy->max_duration;
+    if (fragment.sample_count > 0U && (too_large || too_long)) {
+      err = mutff_fragment_emit(out, count, max_count, &fragment);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      fragment.first_sample = start;
+      fragment.sample_count = 0;
+      fragment.size = 0;
+      fragment.duration = 0;
+    }
+    fragment.sample_count += end - start;
+    fragment.size += size;
+    fragment.duration += duration;
+    start = end;
+  }
+  if (fragment.sample_count > 0U) {
+    return mutff_fragment_emit(out, count, max_count, &fragment);
+  }
+  return MuTFFErrorNone;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
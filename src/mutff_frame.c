@@ -0,0 +1,126 @@
+///
+/// @file      mutff_frame.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library uncompressed video source
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_frame.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_memory.h"
+#include "mutff_sample.h"
+
+MuTFFError mutff_video_pixel_format(MuTFFPixelFormat *format, size_t *row_size,
+                                    const MuTFFSampleDescription *desc) {
+  const MuTFFVideoSampleDescription *video = &desc->data.video;
+  const size_t width = video->width;
+  switch (desc->data_format) {
+    case MuTFF_FOURCC('r', 'a', 'w', ' '):
+      switch (video->depth) {
+        case 16:
+          *format = MuTFFPixelFormatRGB555;
+          *row_size = width * 2U;
+          return MuTFFErrorNone;
+        case 24:
+          *format = MuTFFPixelFormatRGB24;
+          *row_size = width * 3U;
+          return MuTFFErrorNone;
+        case 32:
+          *format = MuTFFPixelFormatARGB32;
+          *row_size = width * 4U;
+          return MuTFFErrorNone;
+        default:
+          return MuTFFErrorBadFormat;
+      }
+    case MuTFF_FOURCC('2', 'v', 'u', 'y'):
+      *format = MuTFFPixelFormatCbYCrY;
+      *row_size = (width + 1U) / 2U * 4U;
+      return MuTFFErrorNone;
+    case MuTFF_FOURCC('y', 'u', 'v', '2'):
+      *format = MuTFFPixelFormatYUYV;
+      *row_size = (width + 1U) / 2U * 4U;
+      return MuTFFErrorNone;
+    case MuTFF_FOURCC('v', '2', '1', '0'):
+      *format = MuTFFPixelFormatV210;
+      *row_size = (width + 5U) / 6U * 16U;
+      return MuTFFErrorNone;
+    default:
+      return MuTFFErrorBadFormat;
+  }
+}
+
+static MuTFFError mutff_frame_view_sample(
+    MuTFFFrameView *out, const MuTFFMemoryBuffer *buf,
+    const MuTFFSampleTableAtom *sample_table, const MuTFFSample *sample) {
+  MuTFFError err;
+  size_t row_size;
+
+  if (sample->sample_description_id == 0U ||
+      sample->sample_description_id >
+          sample_table->sample_description.number_of_entries) {
+    return MuTFFErrorBadFormat;
+  }
+  const MuTFFSampleDescription *desc =
+      &sample_table->sample_description
+           .sample_description_table[sample->sample_description_id - 1U];
+  err = mutff_video_pixel_format(&out->pixel_format, &row_size, desc);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+
+  out->width = desc->data.video.width;
+  out->height = desc->data.video.height;
+  if (out->height == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  out->stride = sample->size / out->height;
+  if (out->pixel_format == MuTFFPixelFormatV210) {
+    // v210 rows are padded to a multiple of 128 bytes
+    row_size = (row_size + 127U) / 128U * 128U;
+  }
+  if (out->stride < row_size) {
+    return MuTFFErrorBadFormat;
+  }
+
+  if (sample->offset > buf->size ||
+      sample->size > buf->size - sample->offset) {
+    return MuTFFErrorEOF;
+  }
+  out->data = &buf->data[sample->offset];
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_frame_view(MuTFFFrameView *out, const MuTFFMemoryBuffer *buf,
+                            const MuTFFSampleTableAtom *sample_table,
+                            uint32_t index) {
+  MuTFFError err;
+  MuTFFSample sample;
+
+  err = mutff_sample_table_sample(&sample, sample_table, index);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  return mutff_frame_view_sample(out, buf, sample_table, &sample);
+}
+
+MuTFFError mutff_frame_view_next(MuTFFFrameView *out,
+                                 const MuTFFMemoryBuffer *buf,
+                                 MuTFFSampleCursor *cursor) {
+  MuTFFError err;
+  MuTFFSample sample;
+
+  err = mutff_sample_cursor_next(&sample, cursor);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  return mutff_frame_view_sample(out, buf, cursor->sample_table, &sample);
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
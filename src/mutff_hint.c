@@ -0,0 +1,337 @@
+///
+/// @file      mutff_hint.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library RTP hint track source file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_hint.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_sample.h"
+#include "mutff_util.h"
+
+#define MuTFF_RTP_EXTRA_INFORMATION 0x4U
+
+static MuTFFError mutff_read_rtp_constructor(MuTFFContext *ctx, size_t *n,
+                                             MuTFFRTPConstructor *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint8_t type;
+  uint8_t length;
+  uint32_t reserved;
+
+  MuTFF_FN(mutff_read_u8, &type);
+  switch (type) {
+    case MuTFFRTPConstructorNoOp:
+      MuTFF_SEEK_CUR(15U);
+      break;
+    case MuTFFRTPConstructorImmediate:
+      MuTFF_FN(mutff_read_u8, &length);
+      if (length > sizeof(out->data)) {
+        return MuTFFErrorBadFormat;
+      }
+      out->length = length;
+      for (size_t i = 0; i < sizeof(out->data); ++i) {
+        MuTFF_FN(mutff_read_u8, &out->data[i]);
+      }
+      break;
+    case MuTFFRTPConstructorSample:
+      MuTFF_FN(mutff_read_i8, &out->track_reference_index);
+      MuTFF_FN(mutff_read_u16, &out->length);
+      MuTFF_FN(mutff_read_u32, &out->sample);
+      MuTFF_FN(mutff_read_u32, &out->offset);
+      MuTFF_FN(mutff_read_u16, &out->bytes_per_block);
+      MuTFF_FN(mutff_read_u16, &out->samples_per_block);
+      break;
+    case MuTFFRTPConstructorSampleDescription:
+      MuTFF_FN(mutff_read_i8, &out->track_reference_index);
+      MuTFF_FN(mutff_read_u16, &out->length);
+      MuTFF_FN(mutff_read_u32, &out->sample);
+      MuTFF_FN(mutff_read_u32, &out->offset);
+      MuTFF_FN(mutff_read_u32, &reserved);
+      break;
+    default:
+      return MuTFFErrorBadFormat;
+  }
+  out->type = type;
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_rtp_packet(MuTFFContext *ctx, size_t *n,
+                                        MuTFFRTPPacket *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint16_t header_info;
+  uint16_t entry_count;
+
+  MuTFF_FN(mutff_read_i32, &out->relative_time);
+  MuTFF_FN(mutff_read_u16, &header_info);
+  out->padding = (header_info & 0x2000U) != 0U;
+  out->extension = (header_info & 0x1000U) != 0U;
+  out->marker = (header_info & 0x0080U) != 0U;
+  out->payload_type = header_info & 0x007FU;
+  MuTFF_FN(mutff_read_u16, &out->sequence_number);
+  MuTFF_FN(mutff_read_u16, &out->flags);
+  MuTFF_FN(mutff_read_u16, &entry_count);
+  if (entry_count > MuTFF_MAX_RTP_CONSTRUCTORS) {
+    return MuTFFErrorOutOfMemory;
+  }
+
+  // skip the extra information TLV atoms
+  if ((out->flags & MuTFF_RTP_EXTRA_INFORMATION) != 0U) {
+    uint32_t extra_information_length;
+    MuTFF_FN(mutff_read_u32, &extra_information_length);
+    if (extra_information_length < 4U) {
+      return MuTFFErrorBadFormat;
+    }
+    MuTFF_SEEK_CUR(extra_information_length - 4U);
+  }
+
+  out->constructor_count = entry_count;
+  for (uint16_t i = 0; i < entry_count; ++i) {
+    MuTFF_FN(mutff_read_rtp_constructor, &out->constructor[i]);
+  }
+
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_read_rtp_hint_sample(MuTFFContext *ctx, size_t *n,
+                                      MuTFFRTPHintSample *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint16_t entry_count;
+  uint16_t reserved;
+
+  MuTFF_FN(mutff_read_u16, &entry_count);
+  MuTFF_FN(mutff_read_u16, &reserved);
+  if (entry_count > MuTFF_MAX_RTP_PACKETS) {
+    return MuTFFErrorOutOfMemory;
+  }
+  out->packet_count = entry_count;
+  for (uint16_t i = 0; i < entry_count; ++i) {
+    MuTFF_FN(mutff_read_rtp_packet, &out->packet[i]);
+  }
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_movie_track_sample_table(
+    const MuTFFSampleTableAtom **out, const MuTFFMovieAtom *movie,
+    uint32_t track_id) {
+  for (size_t i = 0; i < movie->track_count; ++i) {
+    if (movie->track[i].track_header.track_id == track_id) {
+      return mutff_media_atom_sample_table(out, &movie->track[i].media);
+    }
+  }
+  return MuTFFErrorBadFormat;
+}
+
+MuTFFError mutff_hint_track_init(MuTFFHintTrack *out,
+                                 const MuTFFMovieAtom *movie, size_t track) {
+  MuTFFError err;
+  MuTFFMediaType media_type;
+
+  if (track >= movie->track_count) {
+    return MuTFFErrorBadFormat;
+  }
+  const MuTFFTrackAtom *hint = &movie->track[track];
+  err = mutff_media_atom_type(&media_type, &hint->media);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (media_type != MuTFFMediaTypeHintMedia) {
+    return MuTFFErrorBadFormat;
+  }
+  err = mutff_media_atom_sample_table(&out->sample_table, &hint->media);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  const MuTFFSampleDescriptionAtom *descriptions =
+      &out->sample_table->sample_description;
+  if (descriptions->number_of_entries == 0U ||
+      descriptions->sample_description_table[0].data_format !=
+          MuTFF_FOURCC('r', 't', 'p', ' ')) {
+    return MuTFFErrorBadFormat;
+  }
+  out->description = &descriptions->sample_description_table[0].data.hint;
+
+  out->reference_count = 0;
+  if (!hint->track_reference_present) {
+    return MuTFFErrorNone;
+  }
+  for (size_t i = 0; i < hint->track_reference.track_reference_type_count;
+       ++i) {
+    const MuTFFTrackReferenceTypeAtom *reference =
+        &hint->track_reference.track_reference_type[i];
+    if (reference->type != MuTFF_FOURCC('h', 'i', 'n', 't')) {
+      continue;
+    }
+    for (size_t j = 0; j < reference->track_id_count; ++j) {
+      err = mutff_movie_track_sample_table(&out->reference[j], movie,
+                                           reference->track_ids[j]);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+    }
+    out->reference_count = reference->track_id_count;
+    break;
+  }
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_rtp_sample_segment(MuTFFRTPSegment *out,
+                                           const MuTFFHintTrack *track,
+                                           const MuTFFRTPConstructor *in) {
+  MuTFFError err;
+  const MuTFFSampleTableAtom *sample_table;
+  MuTFFSample sample;
+
+  if (in->track_reference_index == -1) {
+    sample_table = track->sample_table;
+  } else if (in->track_reference_index >= 0 &&
+             (size_t)in->track_reference_index < track->reference_count) {
+    sample_table = track->reference[in->track_reference_index];
+  } else {
+    return MuTFFErrorBadFormat;
+  }
+  // data of compressed audio spans blocks of several samples
+  if (in->bytes_per_block > 1U || in->samples_per_block > 1U) {
+    return MuTFFErrorBadFormat;
+  }
+  // sample numbers are one-based
+  if (in->sample == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  err = mutff_sample_table_sample(&sample, sample_table, in->sample - 1U);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (in->offset > sample.size || in->length > sample.size - in->offset) {
+    return MuTFFErrorBadFormat;
+  }
+  out->data = NULL;
+  out->offset = sample.offset + in->offset;
+  out->length = in->length;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_rtp_packet_segments(
+    MuTFFRTPSegment out[MuTFF_MAX_RTP_CONSTRUCTORS], size_t *count,
+    const MuTFFHintTrack *track, const MuTFFRTPPacket *packet) {
+  MuTFFError err;
+
+  *count = 0;
+  for (size_t i = 0; i < packet->constructor_count; ++i) {
+    const MuTFFRTPConstructor *constructor = &packet->constructor[i];
+    switch (constructor->type) {
+      case MuTFFRTPConstructorNoOp:
+        break;
+      case MuTFFRTPConstructorImmediate:
+        out[*count].data = constructor->data;
+        out[*count].offset = 0;
+        out[*count].length = constructor->length;
+        (*count)++;
+        break;
+      case MuTFFRTPConstructorSample:
+        err = mutff_rtp_sample_segment(&out[*count], track, constructor);
+        if (err != MuTFFErrorNone) {
+          return err;
+        }
+        (*count)++;
+        break;
+      default:
+        return MuTFFErrorBadFormat;
+    }
+  }
+
+  return MuTFFErrorNone;
+}
+
+void mutff_rtp_packet_header(unsigned char out[MuTFF_RTP_HEADER_SIZE],
+                             const MuTFFHintTrack *track,
+                             const MuTFFRTPPacket *packet,
+                             uint32_t sample_time, uint32_t ssrc) {
+  const MuTFFHintSampleDescription *description = track->description;
+  uint16_t sequence_number = packet->sequence_number;
+  uint32_t timestamp = sample_time + (uint32_t)packet->relative_time;
+
+  if (description->sequence_offset_present) {
+    sequence_number += (uint16_t)description->sequence_offset;
+  }
+  if (description->time_offset_present) {
+    timestamp += (uint32_t)description->time_offset;
+  }
+
+  // version 2, no contributing sources
+  out[0] = 0x80U | (packet->padding ? 0x20U : 0U) |
+           (packet->extension ? 0x10U : 0U);
+  out[1] = (packet->marker ? 0x80U : 0U) | (packet->payload_type & 0x7FU);
+  mutff_hton_16(&out[2], sequence_number);
+  mutff_hton_32(&out[4], timestamp);
+  mutff_hton_32(&out[8], ssrc);
+}
+
+MuTFFError mutff_write_rtp_packet(MuTFFContext *ctx, size_t *n, void *dest,
+                                  size_t size, const MuTFFHintTrack *track,
+                                  const MuTFFRTPPacket *packet,
+                                  uint32_t sample_time, uint32_t ssrc) {
+  MuTFFError err;
+  MuTFFRTPSegment segments[MuTFF_MAX_RTP_CONSTRUCTORS];
+  size_t segment_count;
+  unsigned char *out = dest;
+  unsigned int pos;
+  *n = 0;
+
+  err = mutff_rtp_packet_segments(segments, &segment_count, track, packet);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  size_t packet_size = MuTFF_RTP_HEADER_SIZE;
+  for (size_t i = 0; i < segment_count; ++i) {
+    packet_size += segments[i].length;
+  }
+  if (packet_size > size) {
+    return MuTFFErrorOutOfMemory;
+  }
+
+  mutff_rtp_packet_header(out, track, packet, sample_time, ssrc);
+  *n = MuTFF_RTP_HEADER_SIZE;
+  for (size_t i = 0; i < segment_count; ++i) {
+    const MuTFFRTPSegment *segment = &segments[i];
+    if (segment->data != NULL) {
+      memcpy(&out[*n], segment->data, segment->length);
+    } else {
+      err = mutff_tell(ctx, &pos);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      err = mutff_seek(ctx, (long)((int64_t)segment->offset - (int64_t)pos));
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      err = mutff_read(ctx, &out[*n], segment->length);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+    }
+    *n += segment->length;
+  }
+
+  return MuTFFErrorNone;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
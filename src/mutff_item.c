@@ -0,0 +1,732 @@
+///
+/// @file      mutff_item.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library HEIF item source file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_item.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_util.h"
+
+// find an item by ID, adding it if it is not yet known
+static MuTFFError mutff_meta_item_entry(MuTFFItem **out, MuTFFMetaAtom *atom,
+                                        uint32_t item_id) {
+  for (size_t i = 0; i < atom->item_count; ++i) {
+    if (atom->item[i].item_id == item_id) {
+      *out = &atom->item[i];
+      return MuTFFErrorNone;
+    }
+  }
+  if (atom->item_count >= MuTFF_MAX_ITEMS) {
+    return MuTFFErrorOutOfMemory;
+  }
+  *out = &atom->item[atom->item_count];
+  **out = (MuTFFItem){0};
+  (*out)->item_id = item_id;
+  atom->item_count++;
+  return MuTFFErrorNone;
+}
+
+// whether an item is stored, which is only the primary item and its
+// thumbnails, or every item if there is no primary item
+static bool mutff_meta_item_wanted(const MuTFFMetaAtom *atom,
+                                   uint32_t item_id) {
+  if (!atom->primary_item_present || item_id == atom->primary_item_id) {
+    return true;
+  }
+  // only thumbnail references to the primary item are stored
+  for (size_t i = 0; i < atom->reference_count; ++i) {
+    if (atom->reference[i].from_item_id == item_id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// read a big-endian integer of 0, 4 or 8 bytes
+static MuTFFError mutff_read_item_uint(MuTFFContext *ctx, size_t *n,
+                                       uint8_t size, uint64_t *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+
+  if (size == 0U) {
+    *out = 0;
+  } else if (size == 4U) {
+    uint32_t value;
+    MuTFF_FN(mutff_read_u32, &value);
+    *out = value;
+  } else if (size == 8U) {
+    MuTFF_FN(mutff_read_u64, out);
+  } else {
+    return MuTFFErrorBadFormat;
+  }
+
+  return MuTFFErrorNone;
+}
+
+// read an item ID which is 16 bits wide if short_id and 32 bits otherwise
+static MuTFFError mutff_read_item_id(MuTFFContext *ctx, size_t *n,
+                                     bool short_id, uint32_t *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+
+  if (short_id) {
+    uint16_t id;
+    MuTFF_FN(mutff_read_u16, &id);
+    *out = id;
+  } else {
+    MuTFF_FN(mutff_read_u32, out);
+  }
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_item_handler(MuTFFContext *ctx, size_t *n,
+                                          MuTFFMetaAtom *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  // version, flags and pre-defined
+  MuTFF_SEEK_CUR(8);
+  MuTFF_FN(mutff_read_u32, &out->handler_type);
+  if (*n > size) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_SEEK_CUR(size - *n);
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_primary_item(MuTFFContext *ctx, size_t *n,
+                                          MuTFFMetaAtom *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint8_t version;
+  mutff_uint24_t flags;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  MuTFF_FN(mutff_read_u8, &version);
+  MuTFF_FN(mutff_read_u24, &flags);
+  MuTFF_FN(mutff_read_item_id, version == 0U, &out->primary_item_id);
+  if (*n > size) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_SEEK_CUR(size - *n);
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_item_info_entry(MuTFFContext *ctx, size_t *n,
+                                             MuTFFMetaAtom *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint8_t version;
+  mutff_uint24_t flags;
+  uint32_t item_id;
+  uint16_t protection_index;
+  uint32_t item_type = 0;
+  MuTFFItem *item;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  MuTFF_FN(mutff_read_u8, &version);
+  MuTFF_FN(mutff_read_u24, &flags);
+  MuTFF_FN(mutff_read_item_id, version < 3U, &item_id);
+  MuTFF_FN(mutff_read_u16, &protection_index);
+  // versions 0 and 1 have no item type
+  if (version >= 2U) {
+    MuTFF_FN(mutff_read_u32, &item_type);
+  }
+  if (*n > size) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_SEEK_CUR(size - *n);
+
+  if (!mutff_meta_item_wanted(out, item_id)) {
+    return MuTFFErrorNone;
+  }
+  err = mutff_meta_item_entry(&item, out, item_id);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  item->item_type = item_type;
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_item_info(MuTFFContext *ctx, size_t *n,
+                                       MuTFFMetaAtom *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint8_t version;
+  mutff_uint24_t flags;
+  uint32_t entry_count;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  MuTFF_FN(mutff_read_u8, &version);
+  MuTFF_FN(mutff_read_u24, &flags);
+  MuTFF_FN(mutff_read_item_id, version == 0U, &entry_count);
+
+  uint64_t child_size;
+  uint32_t child_type;
+  while (*n < size) {
+    MuTFF_FN(mutff_peek_atom_header, &child_size, &child_type);
+    if (child_size == 0U || *n + child_size > size) {
+      return MuTFFErrorBadFormat;
+    }
+    if (child_type == MuTFF_FOURCC('i', 'n', 'f', 'e')) {
+      MuTFF_FN(mutff_read_item_info_entry, out);
+    } else {
+      MuTFF_SEEK_CUR(child_size);
+    }
+  }
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_item_location(MuTFFContext *ctx, size_t *n,
+                                           MuTFFMetaAtom *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint8_t version;
+  mutff_uint24_t flags;
+  uint8_t sizes[2];
+  uint32_t item_count;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  MuTFF_FN(mutff_read_u8, &version);
+  MuTFF_FN(mutff_read_u24, &flags);
+  if (version > 2U) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_FN(mutff_read_u8, &sizes[0]);
+  MuTFF_FN(mutff_read_u8, &sizes[1]);
+  const uint8_t offset_size = sizes[0] >> 4;
+  const uint8_t length_size = sizes[0] & 0xFU;
+  const uint8_t base_offset_size = sizes[1] >> 4;
+  const uint8_t index_size = version == 0U ? 0U : sizes[1] & 0xFU;
+  MuTFF_FN(mutff_read_item_id, version < 2U, &item_count);
+
+  for (uint32_t i = 0; i < item_count; ++i) {
+    uint32_t item_id;
+    uint16_t construction_method = 0;
+    uint16_t data_reference_index;
+    uint64_t base_offset;
+    uint16_t extent_count;
+    MuTFFItem *item = NULL;
+    MuTFF_FN(mutff_read_item_id, version < 2U, &item_id);
+    if (version > 0U) {
+      MuTFF_FN(mutff_read_u16, &construction_method);
+    }
+    MuTFF_FN(mutff_read_u16, &data_reference_index);
+    MuTFF_FN(mutff_read_item_uint, base_offset_size, &base_offset);
+    MuTFF_FN(mutff_read_u16, &extent_count);
+    if (mutff_meta_item_wanted(out, item_id)) {
+      err = mutff_meta_item_entry(&item, out, item_id);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      if (extent_count > MuTFF_MAX_ITEM_EXTENTS) {
+        return MuTFFErrorOutOfMemory;
+      }
+      item->construction_method = construction_method & 0xFU;
+      item->data_reference_index = data_reference_index;
+      item->base_offset = base_offset;
+      item->extent_count = extent_count;
+    }
+    for (uint16_t j = 0; j < extent_count; ++j) {
+      uint64_t extent_index;
+      MuTFFItemExtent extent;
+      MuTFF_FN(mutff_read_item_uint, index_size, &extent_index);
+      MuTFF_FN(mutff_read_item_uint, offset_size, &extent.offset);
+      MuTFF_FN(mutff_read_item_uint, length_size, &extent.length);
+      if (item != NULL) {
+        item->extent[j] = extent;
+      }
+    }
+    if (*n > size) {
+      return MuTFFErrorBadFormat;
+    }
+  }
+  MuTFF_SEEK_CUR(size - *n);
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_item_reference(MuTFFContext *ctx, size_t *n,
+                                            MuTFFMetaAtom *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint8_t version;
+  mutff_uint24_t flags;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  MuTFF_FN(mutff_read_u8, &version);
+  MuTFF_FN(mutff_read_u24, &flags);
+
+  while (*n < size) {
+    const size_t start = *n;
+    uint64_t child_size;
+    uint16_t reference_count;
+    MuTFFItemReference reference;
+
+    MuTFF_FN(mutff_read_header, &child_size, &reference.type);
+    MuTFF_FN(mutff_read_item_id, version == 0U, &reference.from_item_id);
+    MuTFF_FN(mutff_read_u16, &reference_count);
+    reference.to_item_count = 0;
+    for (uint16_t i = 0; i < reference_count; ++i) {
+      uint32_t to_item_id;
+      MuTFF_FN(mutff_read_item_id, version == 0U, &to_item_id);
+      // only thumbnails of the primary item are kept
+      if (reference.type != MuTFF_ITEM_REFERENCE_THUMBNAIL ||
+          (out->primary_item_present &&
+           to_item_id != out->primary_item_id)) {
+        continue;
+      }
+      if (reference.to_item_count >= MuTFF_MAX_ITEM_REFERENCE_TARGETS) {
+        return MuTFFErrorOutOfMemory;
+      }
+      reference.to_item_id[reference.to_item_count++] = to_item_id;
+    }
+    if (*n - start > child_size || start + child_size > size) {
+      return MuTFFErrorBadFormat;
+    }
+    MuTFF_SEEK_CUR(child_size - (*n - start));
+    if (reference.to_item_count > 0U) {
+      if (out->reference_count >= MuTFF_MAX_ITEM_REFERENCES) {
+        return MuTFFErrorOutOfMemory;
+      }
+      out->reference[out->reference_count++] = reference;
+    }
+  }
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_item_property_container(MuTFFContext *ctx,
+                                                     size_t *n,
+                                                     MuTFFMetaAtom *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  unsigned int pos;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+
+  uint64_t child_size;
+  uint32_t child_type;
+  while (*n < size) {
+    MuTFF_FN(mutff_peek_atom_header, &child_size, &child_type);
+    if (child_size == 0U || *n + child_size > size) {
+      return MuTFFErrorBadFormat;
+    }
+    if (out->property_count >= MuTFF_MAX_ITEM_PROPERTIES) {
+      // later properties are not stored
+      MuTFF_SEEK_CUR(child_size);
+      continue;
+    }
+    err = mutff_tell(ctx, &pos);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    MuTFFItemProperty *property = &out->property[out->property_count];
+    property->type = child_type;
+    property->extent.offset = pos;
+    property->extent.size = child_size;
+    out->property_count++;
+    MuTFF_SEEK_CUR(child_size);
+  }
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_item_property_association(MuTFFContext *ctx,
+                                                       size_t *n,
+                                                       MuTFFMetaAtom *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint8_t version;
+  mutff_uint24_t flags;
+  uint32_t entry_count;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  MuTFF_FN(mutff_read_u8, &version);
+  MuTFF_FN(mutff_read_u24, &flags);
+  MuTFF_FN(mutff_read_u32, &entry_count);
+
+  for (uint32_t i = 0; i < entry_count; ++i) {
+    uint32_t item_id;
+    uint8_t association_count;
+    MuTFFItem *item;
+    MuTFF_FN(mutff_read_item_id, version < 1U, &item_id);
+    MuTFF_FN(mutff_read_u8, &association_count);
+    if (!mutff_meta_item_wanted(out, item_id)) {
+      MuTFF_SEEK_CUR(association_count * ((flags & 0x1U) != 0U ? 2U : 1U));
+      continue;
+    }
+    err = mutff_meta_item_entry(&item, out, item_id);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    if (association_count > MuTFF_MAX_ITEM_PROPERTY_ASSOCIATIONS) {
+      return MuTFFErrorOutOfMemory;
+    }
+    item->property_count = association_count;
+    for (uint8_t j = 0; j < association_count; ++j) {
+      MuTFFItemPropertyAssociation *association = &item->property[j];
+      if ((flags & 0x1U) != 0U) {
+        uint16_t value;
+        MuTFF_FN(mutff_read_u16, &value);
+        association->essential = (value & 0x8000U) != 0U;
+        association->index = value & 0x7FFFU;
+      } else {
+        uint8_t value;
+        MuTFF_FN(mutff_read_u8, &value);
+        association->essential = (value & 0x80U) != 0U;
+        association->index = value & 0x7FU;
+      }
+    }
+    if (*n > size) {
+      return MuTFFErrorBadFormat;
+    }
+  }
+  MuTFF_SEEK_CUR(size - *n);
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_item_properties(MuTFFContext *ctx, size_t *n,
+                                             MuTFFMetaAtom *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  bool property_container_present = false;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+
+  uint64_t child_size;
+  uint32_t child_type;
+  while (*n < size) {
+    MuTFF_FN(mutff_peek_atom_header, &child_size, &child_type);
+    if (child_size == 0U || *n + child_size > size) {
+      return MuTFFErrorBadFormat;
+    }
+    switch (child_type) {
+      case MuTFF_FOURCC('i', 'p', 'c', 'o'):
+        MuTFF_READ_CHILD(mutff_read_item_property_container, out,
+                         property_container_present);
+        break;
+      case MuTFF_FOURCC('i', 'p', 'm', 'a'):
+        MuTFF_FN(mutff_read_item_property_association, out);
+        break;
+      default:
+        MuTFF_SEEK_CUR(child_size);
+        break;
+    }
+  }
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_item_data(MuTFFContext *ctx, size_t *n,
+                                       MuTFFMetaAtom *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  unsigned int pos;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  err = mutff_tell(ctx, &pos);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  out->item_data.offset = pos;
+  out->item_data.size = size - *n;
+  MuTFF_SEEK_CUR(size - *n);
+
+  return MuTFFErrorNone;
+}
+
+// read a child of the meta atom at an offset from the start of the meta atom,
+// where pos is the offset of the context, which is left after the child
+static MuTFFError mutff_read_meta_child(
+    MuTFFContext *ctx, uint64_t *pos, uint64_t offset,
+    MuTFFError (*read)(MuTFFContext *, size_t *, MuTFFMetaAtom *),
+    MuTFFMetaAtom *out) {
+  MuTFFError err;
+  size_t bytes;
+
+  err = mutff_seek(ctx, (long)((int64_t)offset - (int64_t)*pos));
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  err = read(ctx, &bytes, out);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *pos = offset + bytes;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_read_meta_atom(MuTFFContext *ctx, size_t *n,
+                                MuTFFMetaAtom *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint8_t version;
+  mutff_uint24_t flags;
+  bool handler_present = false;
+  // the offsets of the children describing items, or zero if absent
+  uint64_t item_info_offset = 0;
+  uint64_t item_location_offset = 0;
+  uint64_t item_reference_offset = 0;
+  uint64_t item_properties_offset = 0;
+
+  out->handler_type = 0;
+  out->primary_item_present = false;
+  out->item_count = 0;
+  out->reference_count = 0;
+  out->property_count = 0;
+  out->item_data_present = false;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  MuTFF_FN(mutff_read_u8, &version);
+  MuTFF_FN(mutff_read_u24, &flags);
+
+  uint64_t child_size;
+  uint32_t child_type;
+  while (*n < size) {
+    MuTFF_FN(mutff_peek_atom_header, &child_size, &child_type);
+    if (child_size == 0U || *n + child_size > size) {
+      return MuTFFErrorBadFormat;
+    }
+    switch (child_type) {
+      case MuTFF_FOURCC('h', 'd', 'l', 'r'):
+        MuTFF_READ_CHILD(mutff_read_item_handler, out, handler_present);
+        break;
+      case MuTFF_FOURCC('p', 'i', 't', 'm'):
+        MuTFF_READ_CHILD(mutff_read_primary_item, out,
+                         out->primary_item_present);
+        break;
+      case MuTFF_FOURCC('i', 'i', 'n', 'f'):
+        if (item_info_offset != 0U) {
+          return MuTFFErrorBadFormat;
+        }
+        item_info_offset = *n;
+        MuTFF_SEEK_CUR(child_size);
+        break;
+      case MuTFF_FOURCC('i', 'l', 'o', 'c'):
+        if (item_location_offset != 0U) {
+          return MuTFFErrorBadFormat;
+        }
+        item_location_offset = *n;
+        MuTFF_SEEK_CUR(child_size);
+        break;
+      case MuTFF_FOURCC('i', 'r', 'e', 'f'):
+        if (item_reference_offset != 0U) {
+          return MuTFFErrorBadFormat;
+        }
+        item_reference_offset = *n;
+        MuTFF_SEEK_CUR(child_size);
+        break;
+      case MuTFF_FOURCC('i', 'p', 'r', 'p'):
+        if (item_properties_offset != 0U) {
+          return MuTFFErrorBadFormat;
+        }
+        item_properties_offset = *n;
+        MuTFF_SEEK_CUR(child_size);
+        break;
+      case MuTFF_FOURCC('i', 'd', 'a', 't'):
+        MuTFF_READ_CHILD(mutff_read_item_data, out, out->item_data_present);
+        break;
+      default:
+        MuTFF_SEEK_CUR(child_size);
+        break;
+    }
+  }
+
+  // only image items are understood
+  if (!handler_present ||
+      out->handler_type != MuTFF_FOURCC('p', 'i', 'c', 't')) {
+    return MuTFFErrorBadFormat;
+  }
+
+  // read the items once the primary item is known, and its thumbnails before
+  // the rest, so that only those items need be stored
+  uint64_t pos = *n;
+  if (item_reference_offset != 0U) {
+    err = mutff_read_meta_child(ctx, &pos, item_reference_offset,
+                                mutff_read_item_reference, out);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+  }
+  if (item_info_offset != 0U) {
+    err = mutff_read_meta_child(ctx, &pos, item_info_offset,
+                                mutff_read_item_info, out);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+  }
+  if (item_location_offset != 0U) {
+    err = mutff_read_meta_child(ctx, &pos, item_location_offset,
+                                mutff_read_item_location, out);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+  }
+  if (item_properties_offset != 0U) {
+    err = mutff_read_meta_child(ctx, &pos, item_properties_offset,
+                                mutff_read_item_properties, out);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+  }
+  return mutff_seek(ctx, (long)(*n - pos));
+}
+
+MuTFFError mutff_read_heif_file(MuTFFContext *ctx, size_t *n,
+                                MuTFFMetaAtom *out) {
+  MuTFFError err;
+  uint64_t size;
+  uint32_t type;
+  size_t bytes;
+  *n = 0;
+  bool meta_present = false;
+
+  while (mutff_peek_atom_header(ctx, &bytes, &size, &type) == MuTFFErrorNone) {
+    if (size == 0U) {
+      // the last atom extends to the end of the file
+      if (type == MuTFF_FOURCC('m', 'e', 't', 'a')) {
+        return MuTFFErrorBadFormat;
+      }
+      break;
+    }
+    if (type == MuTFF_FOURCC('m', 'e', 't', 'a')) {
+      MuTFF_READ_CHILD(mutff_read_meta_atom, out, meta_present);
+    } else {
+      MuTFF_SEEK_CUR(size);
+    }
+  }
+
+  if (!meta_present) {
+    return MuTFFErrorBadFormat;
+  }
+
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_meta_item(const MuTFFItem **out, const MuTFFMetaAtom *atom,
+                           uint32_t item_id) {
+  for (size_t i = 0; i < atom->item_count; ++i) {
+    if (atom->item[i].item_id == item_id) {
+      *out = &atom->item[i];
+      return MuTFFErrorNone;
+    }
+  }
+  return MuTFFErrorBadFormat;
+}
+
+MuTFFError mutff_meta_primary_item(const MuTFFItem **out,
+                                   const MuTFFMetaAtom *atom) {
+  if (!atom->primary_item_present) {
+    return MuTFFErrorBadFormat;
+  }
+  return mutff_meta_item(out, atom, atom->primary_item_id);
+}
+
+MuTFFError mutff_meta_item_thumbnail(const MuTFFItem **out,
+                                     const MuTFFMetaAtom *atom,
+                                     const MuTFFItem *item) {
+  // thumbnails refer to the image they depict
+  for (size_t i = 0; i < atom->reference_count; ++i) {
+    const MuTFFItemReference *reference = &atom->reference[i];
+    if (reference->type != MuTFF_ITEM_REFERENCE_THUMBNAIL) {
+      continue;
+    }
+    for (size_t j = 0; j < reference->to_item_count; ++j) {
+      if (reference->to_item_id[j] == item->item_id) {
+        return mutff_meta_item(out, atom, reference->from_item_id);
+      }
+    }
+  }
+  return MuTFFErrorEOF;
+}
+
+MuTFFError mutff_meta_item_extents(MuTFFItemExtent out[MuTFF_MAX_ITEM_EXTENTS],
+                                   const MuTFFMetaAtom *atom,
+                                   const MuTFFItem *item) {
+  uint64_t base = item->base_offset;
+
+  if (item->data_reference_index != 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  if (item->construction_method == 1U) {
+    if (!atom->item_data_present) {
+      return MuTFFErrorBadFormat;
+    }
+    base += atom->item_data.offset;
+  } else if (item->construction_method != 0U) {
+    return MuTFFErrorBadFormat;
+  }
+
+  for (size_t i = 0; i < item->extent_count; ++i) {
+    const MuTFFItemExtent *extent = &item->extent[i];
+    out[i].offset = base + extent->offset;
+    out[i].length = extent->length;
+    if (item->construction_method == 1U) {
+      // extents in the item data atom must lie within it
+      const uint64_t end = atom->item_data.offset + atom->item_data.size;
+      if (out[i].length == 0U) {
+        out[i].length = out[i].offset <= end ? end - out[i].offset : 0;
+      }
+      if (out[i].offset > end || out[i].length > end - out[i].offset) {
+        return MuTFFErrorBadFormat;
+      }
+    }
+  }
+
+  return MuTFFErrorNone;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
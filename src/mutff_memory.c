@@ -0,0 +1,80 @@
+///
+/// @file      mutff_memory.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF MP4/QTFF library memory buffer I/O driver source file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_memory.h"
+
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "mutff.h"
+#include "mutff_io.h"
+
+void mutff_memory_buffer_init(MuTFFMemoryBuffer *buf, void *data,
+                              size_t size) {
+  buf->data = data;
+  buf->size = size;
+  buf->pos = 0;
+}
+
+MuTFFError mutff_read_memory(mutff_file_t *file, void *dest,
+                             unsigned int bytes) {
+  MuTFFMemoryBuffer *buf = file;
+  if (bytes > buf->size - buf->pos) {
+    return MuTFFErrorEOF;
+  }
+  memcpy(dest, &buf->data[buf->pos], bytes);
+  buf->pos += bytes;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_write_memory(mutff_file_t *file, const void *src,
+                              unsigned int bytes) {
+  MuTFFMemoryBuffer *buf = file;
+  if (bytes > buf->size - buf->pos) {
+    return MuTFFErrorEOF;
+  }
+  memcpy(&buf->data[buf->pos], src, bytes);
+  buf->pos += bytes;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_tell_memory(mutff_file_t *file, unsigned int *location) {
+  const MuTFFMemoryBuffer *buf = file;
+  if (buf->pos > UINT_MAX) {
+    return MuTFFErrorIOError;
+  }
+  *location = buf->pos;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_seek_memory(mutff_file_t *file, long delta) {
+  MuTFFMemoryBuffer *buf = file;
+  if (delta < 0) {
+    if ((unsigned long)-delta > buf->pos) {
+      return MuTFFErrorIOError;
+    }
+    buf->pos -= (unsigned long)-delta;
+  } else {
+    if ((unsigned long)delta > buf->size - buf->pos) {
+      return MuTFFErrorIOError;
+    }
+    buf->pos += (unsigned long)delta;
+  }
+  return MuTFFErrorNone;
+}
+
+MuTFFIODriver mutff_memory_driver = {
+    mutff_read_memory,
+    mutff_write_memory,
+    mutff_tell_memory,
+    mutff_seek_memory,
+};
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,615 @@
+///
+/// @file      mutff_pcm.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library uncompressed sound source
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_pcm.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+#define MuTFF_LPCM_FLAG_FLOAT 0x1U
+#define MuTFF_LPCM_FLAG_BIG_ENDIAN 0x2U
+#define MuTFF_LPCM_FLAG_SIGNED_INTEGER 0x4U
+
+MuTFFError mutff_pcm_format(MuTFFPCMFormat *out,
+                            const MuTFFSampleDescription *desc) {
+  const MuTFFSoundSampleDescription *sound = &desc->data.sound;
+  if (mutff_media_type(desc->data_format) != MuTFFMediaTypeSound) {
+    return MuTFFErrorBadFormat;
+  }
+
+  // version 2 descriptions hold fixed values in the version 0 fields
+  uint32_t bits;
+  if (sound->version == 2U) {
+    out->channels = sound->audio_channels;
+    bits = sound->bits_per_channel;
+  } else {
+    out->channels = sound->number_of_channels;
+    bits = sound->sample_size;
+  }
+  out->floating_point = false;
+  out->big_endian = !sound->little_endian;
+
+  switch (desc->data_format) {
+    case MuTFF_FOURCC('t', 'w', 'o', 's'):
+      out->bytes_per_sample = bits / 8U;
+      out->big_endian = true;
+      break;
+    case MuTFF_FOURCC('s', 'o', 'w', 't'):
+      out->bytes_per_sample = bits / 8U;
+      out->big_endian = false;
+      break;
+    case MuTFF_FOURCC('i', 'n', '2', '4'):
+      out->bytes_per_sample = 3U;
+      break;
+    case MuTFF_FOURCC('i', 'n', '3', '2'):
+      out->bytes_per_sample = 4U;
+      break;
+    case MuTFF_FOURCC('f', 'l', '3', '2'):
+      out->floating_point = true;
+      out->bytes_per_sample = 4U;
+      break;
+    case MuTFF_FOURCC('f', 'l', '6', '4'):
+      out->floating_point = true;
+      out->bytes_per_sample = 8U;
+      break;
+    case MuTFF_FOURCC('l', 'p', 'c', 'm'):
+      if (sound->version != 2U) {
+        return MuTFFErrorBadFormat;
+      }
+      out->floating_point =
+          (sound->format_specific_flags & MuTFF_LPCM_FLAG_FLOAT) != 0U;
+      out->big_endian =
+          (sound->format_specific_flags & MuTFF_LPCM_FLAG_BIG_ENDIAN) != 0U;
+      if (!out->floating_point && (sound->format_specific_flags &
+                                   MuTFF_LPCM_FLAG_SIGNED_INTEGER) == 0U) {
+        return MuTFFErrorBadFormat;
+      }
+      out->bytes_per_sample = bits / 8U;
+      break;
+    default:
+      return MuTFFErrorBadFormat;
+  }
+
+  if (out->channels == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  if (out->floating_point) {
+    if (out->bytes_per_sample != 4U && out->bytes_per_sample != 8U) {
+      return MuTFFErrorBadFormat;
+    }
+  } else if (out->bytes_per_sample < 1U || out->bytes_per_sample > 4U) {
+    return MuTFFErrorBadFormat;
+  }
+  return MuTFFErrorNone;
+}
+
+static inline float mutff_pcm_s8(const unsigned char *p) {
+  return (float)(int8_t)p[0] / 128.0F;
+}
+
+static inline float mutff_pcm_s16be(const unsigned char *p) {
+  return (float)(int16_t)((uint16_t)p[0] << 8 | p[1]) / 32768.0F;
+}
+
+static inline float mutff_pcm_s16le(const unsigned char *p) {
+  return (float)(int16_t)((uint16_t)p[1] << 8 | p[0]) / 32768.0F;
+}
+
+// 24-bit samples are placed in the top bits of an int32_t to sign extend them
+static inline float mutff_pcm_s24be(const unsigned char *p) {
+  return (float)(int32_t)((uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 |
+                          (uint32_t)p[2] << 8) /
+         2147483648.0F;
+}
+
+static inline float mutff_pcm_s24le(const unsigned char *p) {
+  return (float)(int32_t)((uint32_t)p[2] << 24 | (uint32_t)p[1] << 16 |
+                          (uint32_t)p[0] << 8) /
+         2147483648.0F;
+}
+
+static inline uint32_t mutff_pcm_u32be(const unsigned char *p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 |
+         p[3];
+}
+
+static inline uint32_t mutff_pcm_u32le(const unsigned char *p) {
+  return (uint32_t)p[3] << 24 | (uint32_t)p[2] << 16 | (uint32_t)p[1] << 8 |
+         p[0];
+}
+
+static inline float mutff_pcm_s32be(const unsigned char *p) {
+  return (float)(int32_t)mutff_pcm_u32be(p) / 2147483648.0F;
+}
+
+static inline float mutff_pcm_s32le(const unsigned char *p) {
+  return (float)(int32_t)mutff_pcm_u32le(p) / 2147483648.0F;
+}
+
+static inline float mutff_pcm_f32be(const unsigned char *p) {
+  const uint32_t bits = mutff_pcm_u32be(p);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static inline float mutff_pcm_f32le(const unsigned char *p) {
+  const uint32_t bits = mutff_pcm_u32le(p);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static inline float mutff_pcm_f64be(const unsigned char *p) {
+  const uint64_t bits = (uint64_t)mutff_pcm_u32be(p) << 32 |
+                        mutff_pcm_u32be(&p[4]);
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return (float)value;
+}
+
+static inline float mutff_pcm_f64le(const unsigned char *p) {
+  const uint64_t bits = (uint64_t)mutff_pcm_u32le(&p[4]) << 32 |
+                        mutff_pcm_u32le(p);
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return (float)value;
+}
+
+typedef struct {
+  MuTFFPCMPeak *out;
+  size_t *count;
+  size_t max_count;
+  uint32_t bucket_frames;
+  uint32_t frames;
+  float min;
+  float max;
+  double sum_squares;
+} MuTFFPCMPeakState;
+
+typedef void (*MuTFFPCMPeaksKernel)(MuTFFPCMPeakState *state,
+                                    const unsigned char *data, size_t samples);
+
+typedef void (*MuTFFPCMConvertKernel)(float *out, const unsigned char *data,
+                                      size_t samples);
+
+typedef void (*MuTFFPCMPlanarKernel)(float *const out[], size_t offset,
+                                     const unsigned char *data, size_t frames,
+                                     uint16_t channels);
+
+typedef struct {
+  MuTFFPCMPeaksKernel peaks;
+  MuTFFPCMConvertKernel convert;
+  MuTFFPCMPlanarKernel planar;
+} MuTFFPCMKernels;
+
+// one set of kernels per sample layout, so that the inner loops have no
+// branches on the format and may be vectorised by the compiler
+#define MuTFF_PCM_KERNELS(name, size, decode)                                 \
+  static void name##_peaks(MuTFFPCMPeakState *state,                          \
+                           const unsigned char *data, size_t samples) {       \
+    float min = state->min;                                                   \
+    float max = state->max;                                                   \
+    double sum_squares = 0.0;                                                 \
+    for (size_t i = 0; i < samples; ++i) {                                    \
+      const float value = decode(&data[i * (size)]);                          \
+      min = value < min ? value : min;                                        \
+      max = value > max ? value : max;                                        \
+      sum_squares += (double)value * value;                                   \
+    }                                                                         \
+    state->min = min;                                                         \
+    state->max = max;                                                         \
+    state->sum_squares += sum_squares;                                        \
+  }                                                                           \
+                                                                              \
+  static void name##_convert(float *out, const unsigned char *data,           \
+                             size_t samples) {                                \
+    for (size_t i = 0; i < samples; ++i) {                                    \
+      out[i] = decode(&data[i * (size)]);                                     \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  static void name##_planar(float *const out[], size_t offset,                \
+                            const unsigned char *data, size_t frames,         \
+                            uint16_t channels) {                              \
+    for (uint16_t c = 0; c < channels; ++c) {                                 \
+      float *plane = &out[c][offset];                                         \
+      for (size_t i = 0; i < frames; ++i) {                                   \
+        plane[i] = decode(&data[((size_t)i * channels + c) * (size)]);        \
+      }                                                                       \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  static const MuTFFPCMKernels name = {name##_peaks, name##_convert,          \
+                                       name##_planar};
+
+MuTFF_PCM_KERNELS(mutff_pcm_kernels_s8, 1U, mutff_pcm_s8)
+MuTFF_PCM_KERNELS(mutff_pcm_kernels_s16be, 2U, mutff_pcm_s16be)
+MuTFF_PCM_KERNELS(mutff_pcm_kernels_s16le, 2U, mutff_pcm_s16le)
+MuTFF_PCM_KERNELS(mutff_pcm_kernels_s24be, 3U, mutff_pcm_s24be)
+MuTFF_PCM_KERNELS(mutff_pcm_kernels_s24le, 3U, mutff_pcm_s24le)
+MuTFF_PCM_KERNELS(mutff_pcm_kernels_s32be, 4U, mutff_pcm_s32be)
+MuTFF_PCM_KERNELS(mutff_pcm_kernels_s32le, 4U, mutff_pcm_s32le)
+MuTFF_PCM_KERNELS(mutff_pcm_kernels_f32be, 4U, mutff_pcm_f32be)
+MuTFF_PCM_KERNELS(mutff_pcm_kernels_f32le, 4U, mutff_pcm_f32le)
+MuTFF_PCM_KERNELS(mutff_pcm_kernels_f64be, 8U, mutff_pcm_f64be)
+MuTFF_PCM_KERNELS(mutff_pcm_kernels_f64le, 8U, mutff_pcm_f64le)
+
+static const MuTFFPCMKernels *mutff_pcm_kernels(const MuTFFPCMFormat *format) {
+  if (format->floating_point) {
+    if (format->bytes_per_sample == 4U) {
+      return format->big_endian ? &mutff_pcm_kernels_f32be
+                                : &mutff_pcm_kernels_f32le;
+    }
+    return format->big_endian ? &mutff_pcm_kernels_f64be
+                              : &mutff_pcm_kernels_f64le;
+  }
+  switch (format->bytes_per_sample) {
+    case 1:
+      return &mutff_pcm_kernels_s8;
+    case 2:
+      return format->big_endian ? &mutff_pcm_kernels_s16be
+                                : &mutff_pcm_kernels_s16le;
+    case 3:
+      return format->big_endian ? &mutff_pcm_kernels_s24be
+                                : &mutff_pcm_kernels_s24le;
+    default:
+      return format->big_endian ? &mutff_pcm_kernels_s32be
+                                : &mutff_pcm_kernels_s32le;
+  }
+}
+
+static void mutff_pcm_peaks_reset(MuTFFPCMPeakState *state) {
+  state->frames = 0;
+  state->min = 1.0F;
+  state->max = -1.0F;
+  state->sum_squares = 0.0;
+}
+
+static MuTFFError mutff_pcm_peaks_emit(MuTFFPCMPeakState *state,
+                                       uint16_t channels) {
+  if (*state->count >= state->max_count) {
+    return MuTFFErrorOutOfMemory;
+  }
+  MuTFFPCMPeak *peak = &state->out[*state->count];
+  peak->min = state->min;
+  peak->max = state->max;
+  peak->rms = (float)sqrt(state->sum_squares /
+                          ((double)state->frames * channels));
+  ++*state->count;
+  mutff_pcm_peaks_reset(state);
+  return MuTFFErrorNone;
+}
+
+// summarise whole frames, splitting them between buckets
+static MuTFFError mutff_pcm_peaks_update(MuTFFPCMPeakState *state,
+                                         const MuTFFPCMFormat *format,
+                                         const unsigned char *data,
+                                         size_t frames) {
+  MuTFFError err;
+  const MuTFFPCMPeaksKernel kernel = mutff_pcm_kernels(format)->peaks;
+  const size_t frame_size = (size_t)format->bytes_per_sample * format->channels;
+  while (frames > 0U) {
+    size_t run = state->bucket_frames - state->frames;
+    if (run > frames) {
+      run = frames;
+    }
+    kernel(state, data, run * format->channels);
+    state->frames += run;
+    data += run * frame_size;
+    frames -= run;
+    if (state->frames == state->bucket_frames) {
+      err = mutff_pcm_peaks_emit(state, format->channels);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+    }
+  }
+  return MuTFFErrorNone;
+}
+
+// read and summarise a contiguous run of frames
+static MuTFFError mutff_pcm_peaks_range(MuTFFContext *ctx,
+                                        MuTFFPCMPeakState *state,
+                                        const MuTFFPCMFormat *format,
+                                        uint64_t offset, uint64_t frames,
+                                        void *buf, size_t buf_size) {
+  MuTFFError err;
+  unsigned int pos;
+  const size_t frame_size = (size_t)format->bytes_per_sample * format->channels;
+  size_t read_frames = buf_size / frame_size;
+  if (read_frames > UINT_MAX / frame_size) {
+    read_frames = UINT_MAX / frame_size;
+  }
+  if (read_frames == 0U) {
+    return MuTFFErrorOutOfMemory;
+  }
+
+  err = mutff_tell(ctx, &pos);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  err = mutff_seek(ctx, (long)((int64_t)offset - (int64_t)pos));
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  while (frames > 0U) {
+    const size_t run = frames < read_frames ? (size_t)frames : read_frames;
+    err = mutff_read(ctx, buf, (unsigned int)(run * frame_size));
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    err = mutff_pcm_peaks_update(state, format, buf, run);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    frames -= run;
+  }
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_pcm_peaks(MuTFFContext *ctx, MuTFFPCMPeak *out, size_t *count,
+                           size_t max_count,
+                           const MuTFFSampleTableAtom *sample_table,
+                           uint32_t bucket_frames, void *buf, size_t buf_size) {
+  MuTFFError err;
+  const MuTFFSampleToChunkAtom *stsc = &sample_table->sample_to_chunk;
+  const MuTFFChunkOffsetAtom *stco = &sample_table->chunk_offset;
+  const MuTFFSampleDescriptionAtom *stsd = &sample_table->sample_description;
+  *count = 0;
+
+  if (bucket_frames == 0U || !sample_table->sample_to_chunk_present ||
+      !sample_table->chunk_offset_present) {
+    return MuTFFErrorBadFormat;
+  }
+
+  MuTFFPCMPeakState state;
+  state.out = out;
+  state.count = count;
+  state.max_count = max_count;
+  state.bucket_frames = bucket_frames;
+  mutff_pcm_peaks_reset(&state);
+
+  // the run of chunks waiting to be read
+  MuTFFPCMFormat format;
+  uint32_t run_description = 0;
+  uint64_t run_offset = 0;
+  uint64_t run_frames = 0;
+
+  for (uint32_t i = 0; i < stsc->number_of_entries; ++i) {
+    const MuTFFSampleToChunkTableEntry *entry =
+        &stsc->sample_to_chunk_table[i];
+    const uint32_t end_chunk =
+        i + 1U < stsc->number_of_entries
+            ? stsc->sample_to_chunk_table[i + 1U].first_chunk
+            : stco->number_of_entries + 1U;
+    if (entry->first_chunk == 0U || end_chunk < entry->first_chunk ||
+        end_chunk > stco->number_of_entries + 1U ||
+        entry->sample_description_id == 0U ||
+        entry->sample_description_id > stsd->number_of_entries) {
+      return MuTFFErrorBadFormat;
+    }
+
+    for (uint32_t chunk = entry->first_chunk; chunk < end_chunk; ++chunk) {
+      const uint64_t offset = stco->chunk_offset_table[chunk - 1U];
+      if (run_frames > 0U &&
+          entry->sample_description_id == run_description &&
+          offset == run_offset + run_frames * format.bytes_per_sample *
+                                     format.channels) {
+        run_frames += entry->samples_per_chunk;
+        continue;
+      }
+
+      if (run_frames > 0U) {
+        err = mutff_pcm_peaks_range(ctx, &state, &format, run_offset,
+                                    run_frames, buf, buf_size);
+        if (err != MuTFFErrorNone) {
+          return err;
+        }
+      }
+      if (entry->sample_description_id != run_description) {
+        err = mutff_pcm_format(
+            &format,
+            &stsd->sample_description_table[entry->sample_description_id -
+                                            1U]);
+        if (err != MuTFFErrorNone) {
+          return err;
+        }
+        run_description = entry->sample_description_id;
+      }
+      run_offset = offset;
+      run_frames = entry->samples_per_chunk;
+    }
+  }
+
+  if (run_frames > 0U) {
+    err = mutff_pcm_peaks_range(ctx, &state, &format, run_offset, run_frames,
+                                buf, buf_size);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+  }
+  if (state.frames > 0U) {
+    return mutff_pcm_peaks_emit(&state, format.channels);
+  }
+  return MuTFFErrorNone;
+}
+
+void mutff_pcm_to_float(float *out, const void *data, size_t frames,
+                        const MuTFFPCMFormat *format) {
+  mutff_pcm_kernels(format)->convert(out, data, frames * format->channels);
+}
+
+void mutff_pcm_to_float_planar(float *const out[], const void *data,
+                               size_t frames, const MuTFFPCMFormat *format) {
+  mutff_pcm_kernels(format)->planar(out, 0, data, frames, format->channels);
+}
+
+MuTFFError mutff_pcm_reader_init(MuTFFPCMReader *out,
+                                 const MuTFFSampleTableAtom *sample_table) {
+  if (!sample_table->sample_to_chunk_present ||
+      !sample_table->chunk_offset_present ||
+      sample_table->sample_to_chunk.number_of_entries == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  out->sample_table = sample_table;
+  out->sample_description_id = 0;
+  out->entry = 0;
+  out->chunk = sample_table->sample_to_chunk.sample_to_chunk_table[0]
+                   .first_chunk;
+  out->chunk_frame = 0;
+  return MuTFFErrorNone;
+}
+
+// move the reader on to a chunk with frames left in it
+static MuTFFError mutff_pcm_reader_seek_chunk(MuTFFPCMReader *reader) {
+  const MuTFFSampleToChunkAtom *stsc = &reader->sample_table->sample_to_chunk;
+  const MuTFFChunkOffsetAtom *stco = &reader->sample_table->chunk_offset;
+  const MuTFFSampleDescriptionAtom *stsd =
+      &reader->sample_table->sample_description;
+  MuTFFError err;
+
+  while (reader->entry < stsc->number_of_entries) {
+    const MuTFFSampleToChunkTableEntry *entry =
+        &stsc->sample_to_chunk_table[reader->entry];
+    const uint32_t end_chunk =
+        reader->entry + 1U < stsc->number_of_entries
+            ? stsc->sample_to_chunk_table[reader->entry + 1U].first_chunk
+            : stco->number_of_entries + 1U;
+    if (entry->first_chunk == 0U || end_chunk > stco->number_of_entries + 1U ||
+        entry->sample_description_id == 0U ||
+        entry->sample_description_id > stsd->number_of_entries) {
+      return MuTFFErrorBadFormat;
+    }
+    if (reader->chunk_frame >= entry->samples_per_chunk) {
+      reader->chunk++;
+      reader->chunk_frame = 0;
+    }
+    if (reader->chunk < entry->first_chunk) {
+      reader->chunk = entry->first_chunk;
+    }
+    if (reader->chunk >= end_chunk) {
+      reader->entry++;
+      continue;
+    }
+    if (entry->sample_description_id != reader->sample_description_id) {
+      err = mutff_pcm_format(
+          &reader->format,
+          &stsd->sample_description_table[entry->sample_description_id - 1U]);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      reader->sample_description_id = entry->sample_description_id;
+    }
+    return MuTFFErrorNone;
+  }
+  return MuTFFErrorEOF;
+}
+
+static MuTFFError mutff_pcm_read(MuTFFContext *ctx, size_t *frames, float *out,
+                                 float *const planes[], size_t max_frames,
+                                 MuTFFPCMReader *reader, void *buf,
+                                 size_t buf_size) {
+  MuTFFError err;
+  unsigned int pos;
+  *frames = 0;
+
+  while (*frames < max_frames) {
+    const uint32_t sample_description_id = reader->sample_description_id;
+    const MuTFFPCMFormat previous_format = reader->format;
+    err = mutff_pcm_reader_seek_chunk(reader);
+    if (err == MuTFFErrorEOF && *frames > 0U) {
+      break;
+    }
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    // a read never spans a change of layout, the new layout is picked up again
+    // by the next read
+    if (*frames > 0U &&
+        reader->sample_description_id != sample_description_id) {
+      reader->sample_description_id = sample_description_id;
+      reader->format = previous_format;
+      break;
+    }
+
+    const MuTFFPCMFormat *format = &reader->format;
+    const size_t frame_size =
+        (size_t)format->bytes_per_sample * format->channels;
+    const uint32_t samples_per_chunk =
+        reader->sample_table->sample_to_chunk
+            .sample_to_chunk_table[reader->entry]
+            .samples_per_chunk;
+    size_t run = samples_per_chunk - reader->chunk_frame;
+    if (run > max_frames - *frames) {
+      run = max_frames - *frames;
+    }
+    if (run > buf_size / frame_size) {
+      run = buf_size / frame_size;
+    }
+    if (run > UINT_MAX / frame_size) {
+      run = UINT_MAX / frame_size;
+    }
+    if (run == 0U) {
+      return MuTFFErrorOutOfMemory;
+    }
+
+    const uint64_t offset =
+        (uint64_t)reader->sample_table->chunk_offset
+            .chunk_offset_table[reader->chunk - 1U] +
+        (uint64_t)reader->chunk_frame * frame_size;
+    err = mutff_tell(ctx, &pos);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    err = mutff_seek(ctx, (long)((int64_t)offset - (int64_t)pos));
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    err = mutff_read(ctx, buf, (unsigned int)(run * frame_size));
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+
+    const MuTFFPCMKernels *kernels = mutff_pcm_kernels(format);
+    if (out != NULL) {
+      kernels->convert(&out[*frames * format->channels], buf,
+                       run * format->channels);
+    } else {
+      kernels->planar(planes, *frames, buf, run, format->channels);
+    }
+    reader->chunk_frame += run;
+    *frames += run;
+  }
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_pcm_read_float(MuTFFContext *ctx, size_t *frames, float *out,
+                                size_t max_frames, MuTFFPCMReader *reader,
+                                void *buf, size_t buf_size) {
+  return mutff_pcm_read(ctx, frames, out, NULL, max_frames, reader, buf,
+                        buf_size);
+}
+
+MuTFFError mutff_pcm_read_float_planar(MuTFFContext *ctx, size_t *frames,
+                                       float *const out[], size_t max_frames,
+                                       MuTFFPCMReader *reader, void *buf,
+                                       size_t buf_size) {
+  return mutff_pcm_read(ctx, frames, NULL, out, max_frames, reader, buf,
+                        buf_size);
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,85 @@
+///
+/// @file      mutff_pool.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library parse context pool source
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_pool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+
+#define MuTFF_ARENA_ALIGN sizeof(uint64_t)
+
+void mutff_parse_pool_init(MuTFFParsePool *pool, MuTFFParseContext *contexts,
+                           size_t context_count, void *arena,
+                           size_t arena_size) {
+  unsigned char *base = arena;
+  size_t share = 0;
+
+  // align the start of the arena, then give each context an aligned share
+  const size_t misalign = (uintptr_t)base % MuTFF_ARENA_ALIGN;
+  if (misalign != 0U) {
+    const size_t skip = MuTFF_ARENA_ALIGN - misalign;
+    base += skip;
+    arena_size = arena_size > skip ? arena_size - skip : 0;
+  }
+  if (context_count > 0U) {
+    share = arena_size / context_count;
+    share -= share % MuTFF_ARENA_ALIGN;
+  }
+
+  pool->free = NULL;
+  pool->free_count = 0;
+  for (size_t i = context_count; i > 0U; --i) {
+    MuTFFParseContext *context = &contexts[i - 1U];
+    context->arena = share == 0U ? NULL : &base[(i - 1U) * share];
+    context->arena_size = share;
+    mutff_parse_pool_release(pool, context);
+  }
+}
+
+MuTFFError mutff_parse_pool_acquire(MuTFFParseContext **out,
+                                    MuTFFParsePool *pool) {
+  if (pool->free == NULL) {
+    return MuTFFErrorOutOfMemory;
+  }
+  *out = pool->free;
+  pool->free = (*out)->next;
+  pool->free_count--;
+  (*out)->next = NULL;
+  return MuTFFErrorNone;
+}
+
+void mutff_parse_pool_release(MuTFFParsePool *pool,
+                              MuTFFParseContext *context) {
+  mutff_parse_context_reset(context);
+  context->next = pool->free;
+  pool->free = context;
+  pool->free_count++;
+}
+
+MuTFFError mutff_parse_context_alloc(void **out, MuTFFParseContext *context,
+                                     size_t size) {
+  const size_t available = context->arena_size - context->arena_used;
+  if (size > available) {
+    return MuTFFErrorOutOfMemory;
+  }
+  *out = &context->arena[context->arena_used];
+  // keep the next allocation aligned, shares are a multiple of the alignment
+  // so this never overruns the arena
+  context->arena_used +=
+      size + (MuTFF_ARENA_ALIGN - size % MuTFF_ARENA_ALIGN) % MuTFF_ARENA_ALIGN;
+  return MuTFFErrorNone;
+}
+
+void mutff_parse_context_reset(MuTFFParseContext *context) {
+  context->arena_used = 0;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,321 @@
+///
+/// @file      mutff_query.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library index query source file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_query.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_sample.h"
+#include "mutff_util.h"
+
+// size of the fixed part of a request
+#define MuTFF_QUERY_REQUEST_HEADER_SIZE 24U
+
+// size of the fixed part of a response
+#define MuTFF_QUERY_RESPONSE_HEADER_SIZE 16U
+
+// size of a sync sample in a sync samples response
+#define MuTFF_QUERY_SYNC_SAMPLE_SIZE 20U
+
+MuTFFError mutff_read_query_request(MuTFFContext *ctx, size_t *n,
+                                    MuTFFQueryRequest *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint32_t size;
+
+  MuTFF_FN(mutff_read_u32, &size);
+  MuTFF_FN(mutff_read_u32, &out->type);
+  MuTFF_FN(mutff_read_u32, &out->request_id);
+  MuTFF_FN(mutff_read_u32, &out->track);
+  MuTFF_FN(mutff_read_u64, &out->argument);
+  if (size < MuTFF_QUERY_REQUEST_HEADER_SIZE) {
+    return MuTFFErrorBadFormat;
+  }
+  out->name_length = size - MuTFF_QUERY_REQUEST_HEADER_SIZE;
+  if (out->name_length > MuTFF_MAX_QUERY_NAME_LEN) {
+    return MuTFFErrorOutOfMemory;
+  }
+  err = mutff_read(ctx, out->name, out->name_length);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *n += out->name_length;
+
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_write_query_request(MuTFFContext *ctx, size_t *n,
+                                     const MuTFFQueryRequest *in) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+
+  if (in->name_length > MuTFF_MAX_QUERY_NAME_LEN) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_FN(mutff_write_u32,
+           MuTFF_QUERY_REQUEST_HEADER_SIZE + in->name_length);
+  MuTFF_FN(mutff_write_u32, in->type);
+  MuTFF_FN(mutff_write_u32, in->request_id);
+  MuTFF_FN(mutff_write_u32, in->track);
+  MuTFF_FN(mutff_write_u64, in->argument);
+  err = mutff_write(ctx, in->name, in->name_length);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *n += in->name_length;
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_query_response_size(uint32_t *out,
+                                            const MuTFFQueryResponse *in) {
+  *out = MuTFF_QUERY_RESPONSE_HEADER_SIZE;
+  if (in->status != MuTFFErrorNone) {
+    return MuTFFErrorNone;
+  }
+  switch (in->type) {
+    case MuTFF_QUERY_TRACK_SUMMARY:
+      *out += 20U;
+      return MuTFFErrorNone;
+    case MuTFF_QUERY_BYTE_RANGE:
+      *out += 32U;
+      return MuTFFErrorNone;
+    case MuTFF_QUERY_SYNC_SAMPLES:
+      if (in->data.sync_samples.sample_count > MuTFF_MAX_QUERY_SYNC_SAMPLES) {
+        return MuTFFErrorBadFormat;
+      }
+      *out += 8U + in->data.sync_samples.sample_count *
+                       MuTFF_QUERY_SYNC_SAMPLE_SIZE;
+      return MuTFFErrorNone;
+    default:
+      return MuTFFErrorBadFormat;
+  }
+}
+
+MuTFFError mutff_read_query_response(MuTFFContext *ctx, size_t *n,
+                                     MuTFFQueryResponse *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint32_t size;
+  uint32_t status;
+
+  MuTFF_FN(mutff_read_u32, &size);
+  MuTFF_FN(mutff_read_u32, &out->type);
+  MuTFF_FN(mutff_read_u32, &out->request_id);
+  MuTFF_FN(mutff_read_u32, &status);
+  if (status > (uint32_t)MuTFFErrorCompressed) {
+    return MuTFFErrorBadFormat;
+  }
+  out->status = (MuTFFError)status;
+
+  if (out->status == MuTFFErrorNone) {
+    switch (out->type) {
+      case MuTFF_QUERY_TRACK_SUMMARY: {
+        MuTFFQueryTrackSummary *summary = &out->data.track_summary;
+        MuTFF_FN(mutff_read_u32, &summary->track_id);
+        MuTFF_FN(mutff_read_u32, &summary->handler_type);
+        MuTFF_FN(mutff_read_u32, &summary->time_scale);
+        MuTFF_FN(mutff_read_u32, &summary->duration);
+        MuTFF_FN(mutff_read_u32, &summary->sample_count);
+        break;
+      }
+      case MuTFF_QUERY_BYTE_RANGE: {
+        MuTFFQueryByteRange *range = &out->data.byte_range;
+        MuTFF_FN(mutff_read_u32, &range->sample);
+        MuTFF_FN(mutff_read_u32, &range->sync_sample);
+        MuTFF_FN(mutff_read_u64, &range->offset);
+        MuTFF_FN(mutff_read_u32, &range->size);
+        MuTFF_FN(mutff_read_u64, &range->decode_time);
+        MuTFF_FN(mutff_read_u32, &range->duration);
+        break;
+      }
+      case MuTFF_QUERY_SYNC_SAMPLES: {
+        MuTFFQuerySyncSamples *samples = &out->data.sync_samples;
+        MuTFF_FN(mutff_read_u32, &samples->next);
+        MuTFF_FN(mutff_read_u32, &samples->sample_count);
+        if (samples->sample_count > MuTFF_MAX_QUERY_SYNC_SAMPLES) {
+          return MuTFFErrorOutOfMemory;
+        }
+        for (uint32_t i = 0; i < samples->sample_count; ++i) {
+          MuTFF_FN(mutff_read_u32, &samples->sample[i].sample);
+          MuTFF_FN(mutff_read_u64, &samples->sample[i].decode_time);
+          MuTFF_FN(mutff_read_u64, &samples->sample[i].offset);
+        }
+        break;
+      }
+      default:
+        return MuTFFErrorBadFormat;
+    }
+  }
+  if (*n != size) {
+    return MuTFFErrorBadFormat;
+  }
+
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_write_query_response(MuTFFContext *ctx, size_t *n,
+                                      const MuTFFQueryResponse *in) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint32_t size;
+
+  err = mutff_query_response_size(&size, in);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  MuTFF_FN(mutff_write_u32, size);
+  MuTFF_FN(mutff_write_u32, in->type);
+  MuTFF_FN(mutff_write_u32, in->request_id);
+  MuTFF_FN(mutff_write_u32, in->status);
+  if (in->status != MuTFFErrorNone) {
+    return MuTFFErrorNone;
+  }
+
+  switch (in->type) {
+    case MuTFF_QUERY_TRACK_SUMMARY: {
+      const MuTFFQueryTrackSummary *summary = &in->data.track_summary;
+      MuTFF_FN(mutff_write_u32, summary->track_id);
+      MuTFF_FN(mutff_write_u32, summary->handler_type);
+      MuTFF_FN(mutff_write_u32, summary->time_scale);
+      MuTFF_FN(mutff_write_u32, summary->duration);
+      MuTFF_FN(mutff_write_u32, summary->sample_count);
+      break;
+    }
+    case MuTFF_QUERY_BYTE_RANGE: {
+      const MuTFFQueryByteRange *range = &in->data.byte_range;
+      MuTFF_FN(mutff_write_u32, range->sample);
+      MuTFF_FN(mutff_write_u32, range->sync_sample);
+      MuTFF_FN(mutff_write_u64, range->offset);
+      MuTFF_FN(mutff_write_u32, range->size);
+      MuTFF_FN(mutff_write_u64, range->decode_time);
+      MuTFF_FN(mutff_write_u32, range->duration);
+      break;
+    }
+    default: {
+      const MuTFFQuerySyncSamples *samples = &in->data.sync_samples;
+      MuTFF_FN(mutff_write_u32, samples->next);
+      MuTFF_FN(mutff_write_u32, samples->sample_count);
+      for (uint32_t i = 0; i < samples->sample_count; ++i) {
+        MuTFF_FN(mutff_write_u32, samples->sample[i].sample);
+        MuTFF_FN(mutff_write_u64, samples->sample[i].decode_time);
+        MuTFF_FN(mutff_write_u64, samples->sample[i].offset);
+      }
+      break;
+    }
+  }
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_answer_byte_range_query(
+    MuTFFQueryByteRange *out, const MuTFFSampleIndex *index,
+    const MuTFFQueryRequest *request) {
+  MuTFFError err;
+  const MuTFFSampleIndexEntry *entry;
+
+  err = mutff_sample_index_find_time(&out->sample, index, request->track,
+                                     request->argument);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  err = mutff_sample_index_entry(&entry, index, request->track, out->sample);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  out->offset = entry->offset;
+  out->size = entry->size;
+  out->decode_time = entry->decode_time;
+  out->duration = entry->duration;
+
+  // find the sync sample to start decoding from
+  const MuTFFSampleIndexEntry *sync_entry = entry;
+  out->sync_sample = out->sample;
+  while ((sync_entry->flags & MuTFF_SAMPLE_INDEX_SYNC) == 0U) {
+    if (out->sync_sample == 0U) {
+      return MuTFFErrorBadFormat;
+    }
+    --out->sync_sample;
+    --sync_entry;
+  }
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_answer_sync_samples_query(
+    MuTFFQuerySyncSamples *out, const MuTFFSampleIndex *index,
+    const MuTFFQueryRequest *request) {
+  MuTFFError err;
+  const MuTFFSampleIndexTrack *track = &index->track[request->track];
+
+  out->sample_count = 0;
+  out->next = track->sample_count;
+  for (uint64_t i = request->argument; i < track->sample_count; ++i) {
+    const MuTFFSampleIndexEntry *entry;
+    err = mutff_sample_index_entry(&entry, index, request->track, i);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    if ((entry->flags & MuTFF_SAMPLE_INDEX_SYNC) == 0U) {
+      continue;
+    }
+    if (out->sample_count == MuTFF_MAX_QUERY_SYNC_SAMPLES) {
+      out->next = i;
+      break;
+    }
+    MuTFFQuerySyncSample *sample = &out->sample[out->sample_count];
+    sample->sample = i;
+    sample->decode_time = entry->decode_time;
+    sample->offset = entry->offset;
+    ++out->sample_count;
+  }
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_answer_query_data(MuTFFQueryResponseData *out,
+                                          const MuTFFSampleIndex *index,
+                                          const MuTFFQueryRequest *request) {
+  if (request->track >= index->track_count) {
+    return MuTFFErrorBadFormat;
+  }
+  const MuTFFSampleIndexTrack *track = &index->track[request->track];
+
+  switch (request->type) {
+    case MuTFF_QUERY_TRACK_SUMMARY:
+      out->track_summary.track_id = track->track_id;
+      out->track_summary.handler_type = track->handler_type;
+      out->track_summary.time_scale = track->time_scale;
+      out->track_summary.duration = track->duration;
+      out->track_summary.sample_count = track->sample_count;
+      return MuTFFErrorNone;
+    case MuTFF_QUERY_BYTE_RANGE:
+      return mutff_answer_byte_range_query(&out->byte_range, index, request);
+    case MuTFF_QUERY_SYNC_SAMPLES:
+      return mutff_answer_sync_samples_query(&out->sync_samples, index,
+                                             request);
+    default:
+      return MuTFFErrorBadFormat;
+  }
+}
+
+void mutff_answer_query(MuTFFQueryResponse *out, const MuTFFSampleIndex *index,
+                        const MuTFFQueryRequest *request) {
+  out->type = request->type;
+  out->request_id = request->request_id;
+  out->status = mutff_answer_query_data(&out->data, index, request);
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
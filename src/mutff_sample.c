@@ -0,0 +1,767 @@
+///
+/// @file      mutff_sample.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library sample table source file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_sample.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+// the kind of media information holding a media atom's sample table
+static MuTFFError mutff_sample_table_location(MuTFFMediaInformationType *out,
+                                              const MuTFFMediaAtom *atom) {
+  MuTFFError err;
+  MuTFFMediaType media_type;
+
+  if (!atom->media_information_present) {
+    return MuTFFErrorBadFormat;
+  }
+  err = mutff_media_atom_type(&media_type, atom);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *out = mutff_media_information_type(media_type);
+  switch (*out) {
+    case MuTFFVideoMediaInformation:
+      return atom->video_media_information.sample_table_present
+                 ? MuTFFErrorNone
+                 : MuTFFErrorBadFormat;
+    case MuTFFSoundMediaInformation:
+      return atom->sound_media_information.sample_table_present
+                 ? MuTFFErrorNone
+                 : MuTFFErrorBadFormat;
+    case MuTFFBaseMediaInformation:
+      return atom->base_media_information.sample_table_present
+                 ? MuTFFErrorNone
+                 : MuTFFErrorBadFormat;
+    default:
+      return MuTFFErrorBadFormat;
+  }
+}
+
+MuTFFError mutff_media_atom_sample_table(const MuTFFSampleTableAtom **out,
+                                         const MuTFFMediaAtom *atom) {
+  MuTFFError err;
+  MuTFFMediaInformationType type;
+
+  err = mutff_sample_table_location(&type, atom);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  switch (type) {
+    case MuTFFVideoMediaInformation:
+      *out = &atom->video_media_information.sample_table;
+      return MuTFFErrorNone;
+    case MuTFFSoundMediaInformation:
+      *out = &atom->sound_media_information.sample_table;
+      return MuTFFErrorNone;
+    default:
+      *out = &atom->base_media_information.sample_table;
+      return MuTFFErrorNone;
+  }
+}
+
+MuTFFError mutff_media_atom_mutable_sample_table(MuTFFSampleTableAtom **out,
+                                                 MuTFFMediaAtom *atom) {
+  const MuTFFSampleTableAtom *table;
+  const MuTFFError err = mutff_media_atom_sample_table(&table, atom);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *out = (MuTFFSampleTableAtom *)table;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_sample_table_sample_count(uint32_t *out,
+                                           const MuTFFSampleTableAtom *atom) {
+  if (!atom->sample_size_present) {
+    return MuTFFErrorBadFormat;
+  }
+  *out = atom->sample_size.number_of_entries;
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_sample_size(uint32_t *out,
+                                    const MuTFFSampleSizeAtom *atom,
+                                    uint32_t index) {
+  if (atom->sample_size != 0U) {
+    *out = atom->sample_size;
+    return MuTFFErrorNone;
+  }
+  if (index >= atom->number_of_entries ||
+      index >= MuTFF_MAX_SAMPLE_SIZE_TABLE_LEN) {
+    return MuTFFErrorBadFormat;
+  }
+  *out = atom->sample_size_table[index];
+  return MuTFFErrorNone;
+}
+
+// the number of samples in a run of the sample-to-chunk table
+static MuTFFError mutff_chunk_run_length(uint64_t *out,
+                                         const MuTFFSampleTableAtom *atom,
+                                         uint32_t entry) {
+  const MuTFFSampleToChunkAtom *stsc = &atom->sample_to_chunk;
+  const MuTFFSampleToChunkTableEntry *run = &stsc->sample_to_chunk_table[entry];
+  const uint32_t end_chunk =
+      entry + 1U < stsc->number_of_entries
+          ? stsc->sample_to_chunk_table[entry + 1U].first_chunk
+          : atom->chunk_offset.number_of_entries + 1U;
+  if (run->first_chunk == 0U || end_chunk < run->first_chunk ||
+      run->samples_per_chunk == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  *out = (uint64_t)(end_chunk - run->first_chunk) * run->samples_per_chunk;
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_chunk_offset(uint64_t *out,
+                                     const MuTFFChunkOffsetAtom *atom,
+                                     uint32_t chunk) {
+  if (chunk == 0U || chunk > atom->number_of_entries ||
+      chunk > MuTFF_MAX_CHUNK_OFFSET_TABLE_LEN) {
+    return MuTFFErrorBadFormat;
+  }
+  *out = atom->chunk_offset_table[chunk - 1U];
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_sample_cursor_init(MuTFFSampleCursor *out,
+                                    const MuTFFSampleTableAtom *atom,
+                                    uint32_t index) {
+  MuTFFError err;
+
+  err = mutff_sample_table_sample_count(&out->sample_count, atom);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (index > out->sample_count) {
+    return MuTFFErrorEOF;
+  }
+  if (!atom->sample_to_chunk_present || !atom->chunk_offset_present) {
+    return MuTFFErrorBadFormat;
+  }
+  out->sample_table = atom;
+  out->index = index;
+
+  // times
+  const MuTFFTimeToSampleAtom *stts = &atom->time_to_sample;
+  uint32_t before = index;
+  out->time_to_sample_entry = 0;
+  out->decode_time = 0;
+  while (out->time_to_sample_entry < stts->number_of_entries) {
+    const MuTFFTimeToSampleTableEntry *entry =
+        &stts->time_to_sample_table[out->time_to_sample_entry];
+    if (before < entry->sample_count) {
+      break;
+    }
+    before -= entry->sample_count;
+    out->decode_time += (uint64_t)entry->sample_count * entry->sample_duration;
+    out->time_to_sample_entry++;
+  }
+  out->time_to_sample_used = before;
+  if (out->time_to_sample_entry < stts->number_of_entries) {
+    out->decode_time +=
+        (uint64_t)before *
+        stts->time_to_sample_table[out->time_to_sample_entry].sample_duration;
+  }
+  out->composition_offset_entry = 0;
+  out->composition_offset_used = 0;
+  if (atom->composition_offset_present) {
+    const MuTFFCompositionOffsetAtom *ctts = &atom->composition_offset;
+    before = index;
+    while (out->composition_offset_entry < ctts->entry_count) {
+      const uint32_t count =
+          ctts->composition_offset_table[out->composition_offset_entry]
+              .sample_count;
+      if (before < count) {
+        break;
+      }
+      before -= count;
+      out->composition_offset_entry++;
+    }
+    out->composition_offset_used = before;
+  }
+
+  // the chunk containing the sample, and the sizes of the samples before it
+  // in the chunk
+  const MuTFFSampleToChunkAtom *stsc = &atom->sample_to_chunk;
+  uint64_t run_length = 0;
+  before = index;
+  out->sample_to_chunk_entry = 0;
+  while (out->sample_to_chunk_entry < stsc->number_of_entries) {
+    err = mutff_chunk_run_length(&run_length, atom, out->sample_to_chunk_entry);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    if (before < run_length) {
+      break;
+    }
+    before -= (uint32_t)run_length;
+    out->sample_to_chunk_entry++;
+  }
+  out->chunk = 0;
+  out->chunk_used = 0;
+  out->offset = 0;
+  if (out->sample_to_chunk_entry < stsc->number_of_entries) {
+    const MuTFFSampleToChunkTableEntry *run =
+        &stsc->sample_to_chunk_table[out->sample_to_chunk_entry];
+    out->chunk = run->first_chunk + before / run->samples_per_chunk;
+    out->chunk_used = before % run->samples_per_chunk;
+    err = mutff_chunk_offset(&out->offset, &atom->chunk_offset, out->chunk);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    for (uint32_t i = index - out->chunk_used; i < index; ++i) {
+      uint32_t size;
+      err = mutff_sample_size(&size, &atom->sample_size, i);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      out->offset += size;
+    }
+  } else if (index < out->sample_count) {
+    return MuTFFErrorBadFormat;
+  }
+
+  out->sync_sample_entry = 0;
+  if (atom->sync_sample_present) {
+    while (out->sync_sample_entry < atom->sync_sample.number_of_entries &&
+           atom->sync_sample.sync_sample_table[out->sync_sample_entry] <=
+               index) {
+      out->sync_sample_entry++;
+    }
+  }
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_sample_cursor_next(MuTFFSample *out,
+                                    MuTFFSampleCursor *cursor) {
+  MuTFFError err;
+  const MuTFFSampleTableAtom *atom = cursor->sample_table;
+
+  if (cursor->index >= cursor->sample_count) {
+    return MuTFFErrorEOF;
+  }
+
+  err = mutff_sample_size(&out->size, &atom->sample_size, cursor->index);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+
+  // times
+  const MuTFFTimeToSampleAtom *stts = &atom->time_to_sample;
+  while (cursor->time_to_sample_entry < stts->number_of_entries &&
+         cursor->time_to_sample_used >=
+             stts->time_to_sample_table[cursor->time_to_sample_entry]
+                 .sample_count) {
+    cursor->time_to_sample_entry++;
+    cursor->time_to_sample_used = 0;
+  }
+  if (cursor->time_to_sample_entry >= stts->number_of_entries) {
+    return MuTFFErrorBadFormat;
+  }
+  out->decode_time = cursor->decode_time;
+  out->duration =
+      stts->time_to_sample_table[cursor->time_to_sample_entry].sample_duration;
+  out->composition_offset = 0;
+  if (atom->composition_offset_present) {
+    const MuTFFCompositionOffsetAtom *ctts = &atom->composition_offset;
+    while (cursor->composition_offset_entry < ctts->entry_count &&
+           cursor->composition_offset_used >=
+               ctts->composition_offset_table[cursor->composition_offset_entry]
+                   .sample_count) {
+      cursor->composition_offset_entry++;
+      cursor->composition_offset_used = 0;
+    }
+    if (cursor->composition_offset_entry < ctts->entry_count) {
+      out->composition_offset =
+          (int32_t)ctts
+              ->composition_offset_table[cursor->composition_offset_entry]
+              .composition_offset;
+    }
+  }
+
+  // the chunk, moving to the next when this one is full
+  const MuTFFSampleToChunkAtom *stsc = &atom->sample_to_chunk;
+  const MuTFFSampleToChunkTableEntry *run =
+      &stsc->sample_to_chunk_table[cursor->sample_to_chunk_entry];
+  if (cursor->chunk_used >= run->samples_per_chunk) {
+    cursor->chunk++;
+    cursor->chunk_used = 0;
+    while (cursor->sample_to_chunk_entry + 1U < stsc->number_of_entries &&
+           cursor->chunk >=
+               stsc->sample_to_chunk_table[cursor->sample_to_chunk_entry + 1U]
+                   .first_chunk) {
+      cursor->sample_to_chunk_entry++;
+    }
+    run = &stsc->sample_to_chunk_table[cursor->sample_to_chunk_entry];
+    if (run->samples_per_chunk == 0U) {
+      return MuTFFErrorBadFormat;
+    }
+    err = mutff_chunk_offset(&cursor->offset, &atom->chunk_offset,
+                             cursor->chunk);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+  }
+  out->offset = cursor->offset;
+  out->sample_description_id = run->sample_description_id;
+
+  // every sample is a sync sample if there is no sync sample atom
+  out->sync = true;
+  if (atom->sync_sample_present) {
+    const MuTFFSyncSampleAtom *stss = &atom->sync_sample;
+    while (cursor->sync_sample_entry < stss->number_of_entries &&
+           stss->sync_sample_table[cursor->sync_sample_entry] <=
+               cursor->index) {
+      cursor->sync_sample_entry++;
+    }
+    out->sync = cursor->sync_sample_entry < stss->number_of_entries &&
+                stss->sync_sample_table[cursor->sync_sample_entry] ==
+                    cursor->index + 1U;
+  }
+
+  cursor->index++;
+  cursor->time_to_sample_used++;
+  cursor->decode_time += out->duration;
+  cursor->composition_offset_used++;
+  cursor->chunk_used++;
+  cursor->offset += out->size;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_sample_table_sample(MuTFFSample *out,
+                                     const MuTFFSampleTableAtom *atom,
+                                     uint32_t index) {
+  MuTFFError err;
+  MuTFFSampleCursor cursor;
+
+  err = mutff_sample_cursor_init(&cursor, atom, index);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  return mutff_sample_cursor_next(out, &cursor);
+}
+
+// whether a run may start at a sample, given the samples are visited in order
+// and state starts at zero
+typedef bool (*MuTFFRunStart)(const MuTFFSampleTableAtom *atom, uint32_t index,
+                              uint32_t *state);
+
+static bool mutff_any_sample(const MuTFFSampleTableAtom *atom, uint32_t index,
+                             uint32_t *state) {
+  return true;
+}
+
+static bool mutff_sync_sample(const MuTFFSampleTableAtom *atom, uint32_t index,
+                              uint32_t *state) {
+  // every sample is a sync sample if there is no sync sample atom
+  if (!atom->sync_sample_present) {
+    return true;
+  }
+  const MuTFFSyncSampleAtom *stss = &atom->sync_sample;
+  while (*state < stss->number_of_entries &&
+         stss->sync_sample_table[*state] <= index) {
+    (*state)++;
+  }
+  return *state < stss->number_of_entries &&
+         stss->sync_sample_table[*state] == index + 1U;
+}
+
+static MuTFFError mutff_sample_table_runs(uint32_t *out, size_t count,
+                                          const MuTFFSampleTableAtom *atom,
+                                          MuTFFRunStart may_start) {
+  MuTFFError err;
+  uint32_t sample_count;
+  uint32_t size;
+  uint64_t total = 0;
+
+  if (count == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  err = mutff_sample_table_sample_count(&sample_count, atom);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  for (uint32_t i = 0; i < sample_count; ++i) {
+    err = mutff_sample_size(&size, &atom->sample_size, i);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    total += size;
+  }
+
+  // run i starts at the first sample it may start at which is at least
+  // i / count of the way through
+  uint64_t before = 0;
+  uint32_t state = 0;
+  size_t run = 1;
+  out[0] = 0;
+  for (uint32_t i = 0; i < sample_count && run < count; ++i) {
+    if (may_start(atom, i, &state)) {
+      while (run < count && before * count >= total * run) {
+        out[run++] = i;
+      }
+    }
+    err = mutff_sample_size(&size, &atom->sample_size, i);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    before += size;
+  }
+  while (run < count) {
+    out[run++] = sample_count;
+  }
+  out[count] = sample_count;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_sample_table_partition(uint32_t *out, size_t count,
+                                        const MuTFFSampleTableAtom *atom) {
+  return mutff_sample_table_runs(out, count, atom, mutff_any_sample);
+}
+
+MuTFFError mutff_sample_table_split(uint32_t *out, size_t count,
+                                    const MuTFFSampleTableAtom *atom) {
+  return mutff_sample_table_runs(out, count, atom, mutff_sync_sample);
+}
+
+MuTFFError mutff_sample_table_trim(MuTFFSampleTableAtom *out,
+                                   const MuTFFSampleTableAtom *atom,
+                                   uint32_t first, uint32_t count,
+                                   uint32_t offset) {
+  MuTFFError err;
+  uint32_t sample_count;
+  MuTFFSample sample;
+  const uint32_t end = first + count;
+
+  err = mutff_sample_table_sample_count(&sample_count, atom);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (first > sample_count || count > sample_count - first) {
+    return MuTFFErrorBadFormat;
+  }
+  *out = *atom;
+  out->composition_shift_least_greatest_present = false;
+
+  // sizes
+  out->sample_size.number_of_entries = count;
+  if (atom->sample_size.sample_size == 0U) {
+    for (uint32_t i = 0; i < count; ++i) {
+      err = mutff_sample_size(&out->sample_size.sample_size_table[i],
+                              &atom->sample_size, first + i);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+    }
+  }
+
+  // runs of samples are clipped to the samples kept
+  const MuTFFTimeToSampleAtom *stts = &atom->time_to_sample;
+  out->time_to_sample.number_of_entries = 0;
+  uint32_t run_start = 0;
+  for (uint32_t i = 0; i < stts->number_of_entries; ++i) {
+    const MuTFFTimeToSampleTableEntry *entry = &stts->time_to_sample_table[i];
+    const uint32_t run_end = run_start + entry->sample_count;
+    const uint32_t lo = run_start > first ? run_start : first;
+    const uint32_t hi = run_end < end ? run_end : end;
+    if (lo < hi) {
+      MuTFFTimeToSampleTableEntry *trimmed =
+          &out->time_to_sample
+               .time_to_sample_table[out->time_to_sample.number_of_entries++];
+      trimmed->sample_count = hi - lo;
+      trimmed->sample_duration = entry->sample_duration;
+    }
+    run_start = run_end;
+  }
+  if (atom->composition_offset_present) {
+    const MuTFFCompositionOffsetAtom *ctts = &atom->composition_offset;
+    out->composition_offset.entry_count = 0;
+    run_start = 0;
+    for (uint32_t i = 0; i < ctts->entry_count; ++i) {
+      const MuTFFCompositionOffsetTableEntry *entry =
+          &ctts->composition_offset_table[i];
+      const uint32_t run_end = run_start + entry->sample_count;
+      const uint32_t lo = run_start > first ? run_start : first;
+      const uint32_t hi = run_end < end ? run_end : end;
+      if (lo < hi) {
+        MuTFFCompositionOffsetTableEntry *trimmed =
+            &out->composition_offset
+                 .composition_offset_table[out->composition_offset
+                                               .entry_count++];
+        trimmed->sample_count = hi - lo;
+        trimmed->composition_offset = entry->composition_offset;
+      }
+      run_start = run_end;
+    }
+  }
+
+  // sample numbers are renumbered from the first sample kept
+  if (atom->sync_sample_present) {
+    out->sync_sample.number_of_entries = 0;
+    for (uint32_t i = 0; i < atom->sync_sample.number_of_entries; ++i) {
+      const uint32_t number = atom->sync_sample.sync_sample_table[i];
+      if (number > first && number <= end) {
+        out->sync_sample
+            .sync_sample_table[out->sync_sample.number_of_entries++] =
+            number - first;
+      }
+    }
+  }
+  if (atom->partial_sync_sample_present) {
+    out->partial_sync_sample.entry_count = 0;
+    for (uint32_t i = 0; i < atom->partial_sync_sample.entry_count; ++i) {
+      const uint32_t number =
+          atom->partial_sync_sample.partial_sync_sample_table[i];
+      if (number > first && number <= end) {
+        out->partial_sync_sample
+            .partial_sync_sample_table[out->partial_sync_sample
+                                           .entry_count++] = number - first;
+      }
+    }
+  }
+  if (atom->sample_dependency_flags_present) {
+    const MuTFFSampleDependencyFlagsAtom *sdtp =
+        &atom->sample_dependency_flags;
+    out->sample_dependency_flags.data_size = 0;
+    for (uint32_t i = first; i < end && i < sdtp->data_size; ++i) {
+      out->sample_dependency_flags.sample_dependency_flags_table
+          [out->sample_dependency_flags.data_size++] =
+          sdtp->sample_dependency_flags_table[i];
+    }
+  }
+
+  // a chunk for each run of samples with the same sample description
+  MuTFFSampleToChunkAtom *stsc = &out->sample_to_chunk;
+  MuTFFChunkOffsetAtom *stco = &out->chunk_offset;
+  out->sample_to_chunk_present = true;
+  out->chunk_offset_present = true;
+  stsc->number_of_entries = 0;
+  stco->number_of_entries = 0;
+  uint64_t chunk_offset = offset;
+  MuTFFSampleCursor cursor;
+  err = mutff_sample_cursor_init(&cursor, atom, first);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  for (uint32_t i = first; i < end; ++i) {
+    err = mutff_sample_cursor_next(&sample, &cursor);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    MuTFFSampleToChunkTableEntry *entry =
+        stsc->number_of_entries > 0U
+            ? &stsc->sample_to_chunk_table[stsc->number_of_entries - 1U]
+            : NULL;
+    if (entry != NULL &&
+        entry->sample_description_id == sample.sample_description_id) {
+      entry->samples_per_chunk++;
+    } else {
+      if (stco->number_of_entries >= MuTFF_MAX_CHUNK_OFFSET_TABLE_LEN ||
+          stsc->number_of_entries >= MuTFF_MAX_SAMPLE_TO_CHUNK_TABLE_LEN) {
+        return MuTFFErrorOutOfMemory;
+      }
+      if (chunk_offset > UINT32_MAX) {
+        return MuTFFErrorBadFormat;
+      }
+      stco->chunk_offset_table[stco->number_of_entries++] =
+          (uint32_t)chunk_offset;
+      entry = &stsc->sample_to_chunk_table[stsc->number_of_entries++];
+      entry->first_chunk = stco->number_of_entries;
+      entry->samples_per_chunk = 1;
+      entry->sample_description_id = sample.sample_description_id;
+    }
+    chunk_offset += sample.size;
+  }
+  return MuTFFErrorNone;
+}
+
+// the number of samples in a track, or zero if it has no sample table
+static uint32_t mutff_track_sample_count(const MuTFFTrackAtom *track) {
+  const MuTFFSampleTableAtom *sample_table;
+  uint32_t sample_count;
+  if (mutff_media_atom_sample_table(&sample_table, &track->media) !=
+      MuTFFErrorNone) {
+    return 0;
+  }
+  if (mutff_sample_table_sample_count(&sample_count, sample_table) !=
+      MuTFFErrorNone) {
+    return 0;
+  }
+  return sample_count;
+}
+
+MuTFFError mutff_sample_index_size(uint64_t *out, const MuTFFMovieAtom *movie) {
+  if (movie->track_count > MuTFF_MAX_TRACK_ATOMS) {
+    return MuTFFErrorOutOfMemory;
+  }
+  *out = sizeof(MuTFFSampleIndex);
+  for (size_t i = 0; i < movie->track_count; ++i) {
+    *out += (uint64_t)mutff_track_sample_count(&movie->track[i]) *
+            sizeof(MuTFFSampleIndexEntry);
+  }
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_build_sample_index(void *dest, uint64_t size,
+                                    const MuTFFMovieAtom *movie) {
+  MuTFFError err;
+  uint64_t index_size;
+
+  err = mutff_sample_index_size(&index_size, movie);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (index_size > size) {
+    return MuTFFErrorOutOfMemory;
+  }
+
+  MuTFFSampleIndex *index = dest;
+  memset(index, 0, sizeof(MuTFFSampleIndex));
+  index->magic = MuTFF_SAMPLE_INDEX_MAGIC;
+  index->time_scale = movie->movie_header.time_scale;
+  index->duration = movie->movie_header.duration;
+  index->track_count = movie->track_count;
+  index->size = index_size;
+
+  uint64_t offset = sizeof(MuTFFSampleIndex);
+  for (size_t i = 0; i < movie->track_count; ++i) {
+    const MuTFFTrackAtom *track = &movie->track[i];
+    MuTFFSampleIndexTrack *index_track = &index->track[i];
+    index_track->track_id = track->track_header.track_id;
+    index_track->handler_type =
+        track->media.handler_reference_present
+            ? track->media.handler_reference.component_subtype
+            : 0U;
+    index_track->time_scale = track->media.media_header.time_scale;
+    index_track->duration = track->media.media_header.duration;
+    index_track->sample_count = mutff_track_sample_count(track);
+    index_track->entries = offset;
+
+    if (index_track->sample_count == 0U) {
+      continue;
+    }
+    const MuTFFSampleTableAtom *sample_table;
+    err = mutff_media_atom_sample_table(&sample_table, &track->media);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    MuTFFSampleIndexEntry *entries =
+        (MuTFFSampleIndexEntry *)((unsigned char *)dest + offset);
+    MuTFFSampleCursor cursor;
+    err = mutff_sample_cursor_init(&cursor, sample_table, 0);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    for (uint32_t j = 0; j < index_track->sample_count; ++j) {
+      MuTFFSample sample;
+      err = mutff_sample_cursor_next(&sample, &cursor);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      entries[j].offset = sample.offset;
+      entries[j].decode_time = sample.decode_time;
+      entries[j].size = sample.size;
+      entries[j].duration = sample.duration;
+      entries[j].sample_description_id = sample.sample_description_id;
+      entries[j].flags = sample.sync ? MuTFF_SAMPLE_INDEX_SYNC : 0U;
+      entries[j].composition_offset = sample.composition_offset;
+      entries[j].reserved = 0;
+    }
+    offset +=
+        (uint64_t)index_track->sample_count * sizeof(MuTFFSampleIndexEntry);
+  }
+
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_check_sample_index(const MuTFFSampleIndex *index,
+                                    uint64_t size) {
+  if (size < sizeof(MuTFFSampleIndex)) {
+    return MuTFFErrorBadFormat;
+  }
+  if (index->magic != MuTFF_SAMPLE_INDEX_MAGIC) {
+    return MuTFFErrorBadFormat;
+  }
+  if (index->size > size || index->size < sizeof(MuTFFSampleIndex)) {
+    return MuTFFErrorBadFormat;
+  }
+  if (index->track_count > MuTFF_MAX_TRACK_ATOMS) {
+    return MuTFFErrorBadFormat;
+  }
+  for (size_t i = 0; i < index->track_count; ++i) {
+    const MuTFFSampleIndexTrack *track = &index->track[i];
+    if (track->entries < sizeof(MuTFFSampleIndex) ||
+        track->entries % sizeof(uint64_t) != 0U ||
+        track->entries > index->size) {
+      return MuTFFErrorBadFormat;
+    }
+    if ((uint64_t)track->sample_count > (index->size - track->entries) /
+                                            sizeof(MuTFFSampleIndexEntry)) {
+      return MuTFFErrorBadFormat;
+    }
+  }
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_sample_index_entry(const MuTFFSampleIndexEntry **out,
+                                    const MuTFFSampleIndex *index,
+                                    size_t track, uint32_t sample) {
+  if (track >= index->track_count) {
+    return MuTFFErrorBadFormat;
+  }
+  if (sample >= index->track[track].sample_count) {
+    return MuTFFErrorEOF;
+  }
+  const MuTFFSampleIndexEntry *entries =
+      (const MuTFFSampleIndexEntry *)((const unsigned char *)index +
+                                      index->track[track].entries);
+  *out = &entries[sample];
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_sample_index_find_time(uint32_t *out,
+                                        const MuTFFSampleIndex *index,
+                                        size_t track, uint64_t time) {
+  if (track >= index->track_count) {
+    return MuTFFErrorBadFormat;
+  }
+  const uint32_t sample_count = index->track[track].sample_count;
+  const MuTFFSampleIndexEntry *entries =
+      (const MuTFFSampleIndexEntry *)((const unsigned char *)index +
+                                      index->track[track].entries);
+
+  // binary search for the last sample starting at or before time
+  uint32_t lo = 0;
+  uint32_t hi = sample_count;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2U;
+    if (entries[mid].decode_time <= time) {
+      lo = mid + 1U;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == 0U) {
+    return MuTFFErrorEOF;
+  }
+  const MuTFFSampleIndexEntry *entry = &entries[lo - 1U];
+  if (time - entry->decode_time >= entry->duration) {
+    return MuTFFErrorEOF;
+  }
+  *out = lo - 1U;
+  return MuTFFErrorNone;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
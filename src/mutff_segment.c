@@ -0,0 +1,304 @@
+///
+/// @file      mutff_segment.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library on-demand segment source
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_segment.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_memory.h"
+#include "mutff_sample.h"
+#include "mutff_util.h"
+
+// sample_depends_on 2
+#define MuTFF_SEGMENT_SYNC_FLAGS 0x02000000U
+// sample_depends_on 1, sample_is_non_sync_sample
+#define MuTFF_SEGMENT_NON_SYNC_FLAGS 0x01010000U
+
+// find the first sync sample decoded at or after a time
+static MuTFFError mutff_segment_boundary(uint32_t *out,
+                                         const MuTFFSampleIndex *index,
+                                         size_t track, uint64_t time) {
+  MuTFFError err;
+  const MuTFFSampleIndexEntry *entry;
+  const uint32_t sample_count = index->track[track].sample_count;
+  uint32_t sample;
+
+  if (sample_count == 0U) {
+    *out = 0;
+    return MuTFFErrorNone;
+  }
+  err = mutff_sample_index_find_time(&sample, index, track, time);
+  if (err == MuTFFErrorEOF) {
+    err = mutff_sample_index_entry(&entry, index, track, 0);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    sample = time < entry->decode_time ? 0 : sample_count;
+  } else if (err != MuTFFErrorNone) {
+    return err;
+  }
+
+  while (sample < sample_count) {
+    err = mutff_sample_index_entry(&entry, index, track, sample);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    if (entry->decode_time >= time &&
+        (entry->flags & MuTFF_SAMPLE_INDEX_SYNC) != 0U) {
+      break;
+    }
+    ++sample;
+  }
+  *out = sample;
+  return MuTFFErrorNone;
+}
+
+// overwrite a 32-bit field of the header already written
+static MuTFFError mutff_segment_patch(unsigned char *header, size_t offset,
+                                      uint32_t value) {
+  size_t bytes;
+  MuTFFMemoryBuffer mem;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &mem;
+  mutff_memory_buffer_init(&mem, &header[offset], 4);
+  return mutff_write_u32(&ctx, &bytes, value);
+}
+
+// write the movie fragment and movie data atom header of the samples [first,
+// last), an atom at a time rather than building the movie fragment whole, and
+// fill in the sizes of its containers and the data offsets of its runs once
+// they are known
+static MuTFFError mutff_write_segment_header(MuTFFContext *ctx, size_t *n,
+                                             MuTFFSegment *out,
+                                             const MuTFFSampleIndex *index,
+                                             size_t track, uint32_t first,
+                                             uint32_t last, uint32_t number) {
+  MuTFFError err;
+  size_t bytes;
+  const MuTFFSampleIndexEntry *entry;
+  *n = 0;
+
+  err = mutff_sample_index_entry(&entry, index, track, first);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  out->decode_time = entry->decode_time;
+
+  MuTFFMovieFragmentHeaderAtom mfhd;
+  MuTFFTrackFragmentHeaderAtom tfhd;
+  MuTFFTrackFragmentDecodeTimeAtom tfdt;
+  memset(&mfhd, 0, sizeof(mfhd));
+  mfhd.sequence_number = number + 1U;
+  memset(&tfhd, 0, sizeof(tfhd));
+  tfhd.track_id = index->track[track].track_id;
+  tfhd.default_base_is_moof = true;
+  tfdt.version = 1;
+  tfdt.base_media_decode_time = entry->decode_time;
+
+  MuTFF_FN(mutff_write_header, 0U, MuTFF_FOURCC('m', 'o', 'o', 'f'));
+  MuTFF_FN(mutff_write_movie_fragment_header_atom, &mfhd);
+  const size_t traf_offset = *n;
+  MuTFF_FN(mutff_write_header, 0U, MuTFF_FOURCC('t', 'r', 'a', 'f'));
+  MuTFF_FN(mutff_write_track_fragment_header_atom, &tfhd);
+  MuTFF_FN(mutff_write_track_fragment_decode_time_atom, &tfdt);
+  const size_t trun_offset = *n;
+
+  // write runs of samples, coalescing samples which follow one another in
+  // the file into a single range
+  MuTFFTrackFragmentRunAtom trun;
+  uint64_t data_size = 0;
+  for (uint32_t i = first; i < last;) {
+    memset(&trun, 0, sizeof(trun));
+    trun.data_offset_present = true;
+    trun.sample_duration_present = true;
+    trun.sample_size_present = true;
+    trun.sample_flags_present = true;
+    for (; i < last && trun.sample_count < MUTFF_MAX_TRACK_FRAGMENT_RUN_RECORDS;
+         ++i) {
+      err = mutff_sample_index_entry(&entry, index, track, i);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      MuTFFTrackFragmentRunRecord *record = &trun.records[trun.sample_count++];
+      record->sample_duration = entry->duration;
+      record->sample_size = entry->size;
+      record->sample_flags = (entry->flags & MuTFF_SAMPLE_INDEX_SYNC) != 0U
+                                 ? MuTFF_SEGMENT_SYNC_FLAGS
+                                 : MuTFF_SEGMENT_NON_SYNC_FLAGS;
+      record->sample_composition_time_offset = entry->composition_offset;
+      if (entry->composition_offset != 0) {
+        trun.sample_composition_time_offset_present = true;
+      }
+      if (entry->composition_offset < 0) {
+        trun.version = 1;
+      }
+
+      MuTFFAtomExtent *range =
+          out->range_count > 0U ? &out->range[out->range_count - 1U] : NULL;
+      if (range != NULL && range->offset + range->size == entry->offset) {
+        range->size += entry->size;
+      } else {
+        if (out->range_count >= MuTFF_MAX_SEGMENT_RANGES) {
+          return MuTFFErrorOutOfMemory;
+        }
+        range = &out->range[out->range_count++];
+        range->offset = entry->offset;
+        range->size = entry->size;
+      }
+      data_size += entry->size;
+    }
+    MuTFF_FN(mutff_write_track_fragment_run_atom, &trun);
+  }
+  const size_t moof_size = *n;
+
+  err = mutff_segment_patch(out->header, 0, (uint32_t)moof_size);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  err = mutff_segment_patch(out->header, traf_offset,
+                            (uint32_t)(moof_size - traf_offset));
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+
+  // each run's data offset follows its size, version, flags and sample count
+  const uint64_t mdat_header_size = data_size + 8U > UINT32_MAX ? 16U : 8U;
+  uint64_t data_offset = moof_size + mdat_header_size;
+  size_t offset = trun_offset;
+  for (uint32_t i = first; i < last;) {
+    if (data_offset > INT32_MAX) {
+      return MuTFFErrorBadFormat;
+    }
+    err = mutff_segment_patch(out->header, offset + 16U, (uint32_t)data_offset);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    const unsigned char *size = &out->header[offset];
+    offset += (size_t)size[0] << 24U | (size_t)size[1] << 16U |
+              (size_t)size[2] << 8U | size[3];
+    for (uint32_t j = 0; i < last && j < MUTFF_MAX_TRACK_FRAGMENT_RUN_RECORDS;
+         ++i, ++j) {
+      err = mutff_sample_index_entry(&entry, index, track, i);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      data_offset += entry->size;
+    }
+  }
+
+  MuTFF_FN(mutff_write_header, mdat_header_size + data_size,
+           MuTFF_FOURCC('m', 'd', 'a', 't'));
+  out->size = *n + data_size;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_make_segment(MuTFFSegment *out, void *buf, size_t buf_size,
+                              const MuTFFSampleIndex *index, size_t track,
+                              uint32_t number, uint64_t duration) {
+  MuTFFError err;
+  uint32_t first;
+  uint32_t last;
+
+  if (track >= index->track_count || duration == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  const uint64_t start = (uint64_t)number * duration;
+  err = mutff_segment_boundary(&first, index, track, start);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  err = mutff_segment_boundary(&last, index, track, start + duration);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (first >= last) {
+    return first >= index->track[track].sample_count ? MuTFFErrorEOF
+                                                     : MuTFFErrorBadFormat;
+  }
+
+  out->header = buf;
+  out->first_sample = first;
+  out->sample_count = last - first;
+  out->range_count = 0;
+
+  MuTFFMemoryBuffer mem;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &mem;
+  mutff_memory_buffer_init(&mem, buf, buf_size);
+  err = mutff_write_segment_header(&ctx, &out->header_size, out, index, track,
+                                   first, last, number);
+  if (err == MuTFFErrorEOF) {
+    return MuTFFErrorOutOfMemory;
+  }
+  return err;
+}
+
+void mutff_segment_cache_init(MuTFFSegmentCache *cache,
+                              MuTFFSegmentCacheEntry *entries,
+                              size_t entry_count, void *buf, size_t buf_size) {
+  cache->entries = entries;
+  cache->entry_count = entry_count;
+  cache->buf = buf;
+  cache->header_size = entry_count > 0U ? buf_size / entry_count : 0U;
+  cache->clock = 0;
+  for (size_t i = 0; i < entry_count; ++i) {
+    entries[i].valid = false;
+  }
+}
+
+MuTFFError mutff_segment_cache_get(const MuTFFSegment **out,
+                                   MuTFFSegmentCache *cache,
+                                   const MuTFFSampleIndex *index, size_t track,
+                                   uint32_t number, uint64_t duration) {
+  MuTFFError err;
+  MuTFFSegmentCacheEntry *victim = NULL;
+
+  if (cache->entry_count == 0U) {
+    return MuTFFErrorOutOfMemory;
+  }
+  cache->clock++;
+  for (size_t i = 0; i < cache->entry_count; ++i) {
+    MuTFFSegmentCacheEntry *entry = &cache->entries[i];
+    if (entry->valid && entry->track == track && entry->number == number) {
+      entry->last_used = cache->clock;
+      *out = &entry->segment;
+      return MuTFFErrorNone;
+    }
+    // prefer an unused entry, then the one used least recently
+    if (victim == NULL ||
+        (victim->valid &&
+         (!entry->valid || entry->last_used < victim->last_used))) {
+      victim = entry;
+    }
+  }
+
+  const size_t slot = (size_t)(victim - cache->entries);
+  victim->valid = false;
+  err = mutff_make_segment(&victim->segment,
+                           cache->buf + slot * cache->header_size,
+                           cache->header_size, index, track, number, duration);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  victim->valid = true;
+  victim->track = track;
+  victim->number = number;
+  victim->last_used = cache->clock;
+  *out = &victim->segment;
+  return MuTFFErrorNone;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,348 @@
+///
+/// @file      mutff_summary.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library movie summary source file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_summary.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_dialect.h"
+#include "mutff_util.h"
+#include "mutff_walk.h"
+
+// skip the creation and modification times of a version 0 or 1 header atom
+static MuTFFError mutff_read_summary_times(MuTFFContext *ctx, size_t *n,
+                                           uint8_t version) {
+  MuTFFError err;
+  *n = 0;
+  MuTFF_SEEK_CUR(version == 1U ? 16 : 8);
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_summary_duration(MuTFFContext *ctx, size_t *n,
+                                              uint8_t version,
+                                              uint32_t *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  if (version == 1U) {
+    uint64_t duration;
+    MuTFF_FN(mutff_read_u64, &duration);
+    *out = duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration;
+  } else {
+    MuTFF_FN(mutff_read_u32, out);
+  }
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_file_type_summary(MuTFFContext *ctx, size_t *n,
+                                               MuTFFMovieSummary *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  MuTFF_FN(mutff_read_u32, &out->major_brand);
+  MuTFF_FN(mutff_read_u32, &out->minor_version);
+  out->dialect = MuTFFDialectUnknown;
+  mutff_dialect_add_brand(&out->dialect, out->major_brand);
+  out->compatible_brands_count = 0;
+  // every brand is needed to find the dialect, even those which are not stored
+  while (size - *n >= 4U) {
+    uint32_t brand;
+    MuTFF_FN(mutff_read_u32, &brand);
+    mutff_dialect_add_brand(&out->dialect, brand);
+    if (out->compatible_brands_count < MuTFF_MAX_COMPATIBLE_BRANDS) {
+      out->compatible_brands[out->compatible_brands_count] = brand;
+      out->compatible_brands_count++;
+    }
+  }
+  if (out->dialect == MuTFFDialectUnknown) {
+    out->dialect = MuTFFDialectISO;
+  }
+  MuTFF_SEEK_CUR(size - *n);
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_movie_header_summary(MuTFFContext *ctx, size_t *n,
+                                                  MuTFFMovieSummary *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint8_t version;
+  mutff_uint24_t flags;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  MuTFF_FN(mutff_read_u8, &version);
+  MuTFF_FN(mutff_read_u24, &flags);
+  MuTFF_FN(mutff_read_summary_times, version);
+  MuTFF_FN(mutff_read_u32, &out->time_scale);
+  MuTFF_FN(mutff_read_summary_duration, version, &out->duration);
+  if (*n > size) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_SEEK_CUR(size - *n);
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_track_header_summary(MuTFFContext *ctx, size_t *n,
+                                                  MuTFFTrackSummary *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint8_t version;
+  mutff_uint24_t flags;
+  uint32_t duration;
+  uint16_t fractional;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  MuTFF_FN(mutff_read_u8, &version);
+  MuTFF_FN(mutff_read_u24, &flags);
+  MuTFF_FN(mutff_read_summary_times, version);
+  MuTFF_FN(mutff_read_u32, &out->track_id);
+  MuTFF_SEEK_CUR(4);
+  MuTFF_FN(mutff_read_summary_duration, version, &duration);
+  // reserved, layer, alternate group, volume, reserved and matrix
+  MuTFF_SEEK_CUR(52);
+  MuTFF_FN(mutff_read_u16, &out->width);
+  MuTFF_FN(mutff_read_u16, &fractional);
+  MuTFF_FN(mutff_read_u16, &out->height);
+  MuTFF_FN(mutff_read_u16, &fractional);
+  if (*n > size) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_SEEK_CUR(size - *n);
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_media_header_summary(MuTFFContext *ctx, size_t *n,
+                                                  MuTFFTrackSummary *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint8_t version;
+  mutff_uint24_t flags;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  MuTFF_FN(mutff_read_u8, &version);
+  MuTFF_FN(mutff_read_u24, &flags);
+  MuTFF_FN(mutff_read_summary_times, version);
+  MuTFF_FN(mutff_read_u32, &out->time_scale);
+  MuTFF_FN(mutff_read_summary_duration, version, &out->duration);
+  MuTFF_FN(mutff_read_u16, &out->language);
+  if (*n > size) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_SEEK_CUR(size - *n);
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_handler_reference_summary(MuTFFContext *ctx,
+                                                       size_t *n,
+                                                       MuTFFTrackSummary *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  // version, flags and component type
+  MuTFF_SEEK_CUR(8);
+  MuTFF_FN(mutff_read_u32, &out->handler_type);
+  if (*n > size) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_SEEK_CUR(size - *n);
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_sample_description_summary(
+    MuTFFContext *ctx, size_t *n, MuTFFTrackSummary *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint32_t number_of_entries;
+  uint32_t description_size;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  // version and flags
+  MuTFF_SEEK_CUR(4);
+  MuTFF_FN(mutff_read_u32, &number_of_entries);
+  if (number_of_entries > 0U) {
+    MuTFF_FN(mutff_read_u32, &description_size);
+    MuTFF_FN(mutff_read_u32, &out->codec);
+  }
+  if (*n > size) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_SEEK_CUR(size - *n);
+
+  return MuTFFErrorNone;
+}
+
+static MuTFFError mutff_read_sample_size_summary(MuTFFContext *ctx, size_t *n,
+                                                 MuTFFTrackSummary *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint64_t size;
+  uint32_t type;
+  uint32_t sample_size;
+
+  MuTFF_FN(mutff_read_header, &size, &type);
+  // version and flags
+  MuTFF_SEEK_CUR(4);
+  MuTFF_FN(mutff_read_u32, &sample_size);
+  MuTFF_FN(mutff_read_u32, &out->sample_count);
+  if (*n > size) {
+    return MuTFFErrorBadFormat;
+  }
+  MuTFF_SEEK_CUR(size - *n);
+
+  return MuTFFErrorNone;
+}
+
+// read an atom beneath a trak atom which is needed for a track summary
+static MuTFFError mutff_read_track_summary_atom(MuTFFContext *ctx,
+                                                MuTFFAtomWalker *walker,
+                                                const MuTFFAtomInfo *atom,
+                                                MuTFFTrackSummary *out) {
+  size_t bytes;
+
+  switch (atom->type) {
+    case MuTFF_FOURCC('t', 'k', 'h', 'd'):
+      return mutff_read_track_header_summary(ctx, &bytes, out);
+    case MuTFF_FOURCC('m', 'd', 'h', 'd'):
+      return mutff_read_media_header_summary(ctx, &bytes, out);
+    case MuTFF_FOURCC('h', 'd', 'l', 'r'):
+      // the media handler precedes the data handler in the media atom
+      if (out->handler_type == 0U) {
+        return mutff_read_handler_reference_summary(ctx, &bytes, out);
+      }
+      return MuTFFErrorNone;
+    case MuTFF_FOURCC('s', 't', 's', 'd'):
+      return mutff_read_sample_description_summary(ctx, &bytes, out);
+    case MuTFF_FOURCC('s', 't', 's', 'z'):
+      return mutff_read_sample_size_summary(ctx, &bytes, out);
+    case MuTFF_FOURCC('m', 'd', 'i', 'a'):
+    case MuTFF_FOURCC('m', 'i', 'n', 'f'):
+    case MuTFF_FOURCC('s', 't', 'b', 'l'):
+      return mutff_atom_walker_enter(walker, atom, 0);
+    default:
+      return MuTFFErrorNone;
+  }
+}
+
+MuTFFError mutff_read_movie_summary(MuTFFContext *ctx, size_t *n,
+                                    MuTFFMovieSummary *out) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  MuTFFAtomWalker walker;
+  MuTFFAtomInfo atom;
+  MuTFFTrackSummary *track = NULL;
+  bool file_type_present = false;
+  bool movie_present = false;
+  bool movie_header_present = false;
+
+  out->major_brand = 0;
+  out->minor_version = 0;
+  out->compatible_brands_count = 0;
+  out->dialect = MuTFFDialectQuickTime;
+  out->track_count = 0;
+
+  err = mutff_atom_walker_init(ctx, &walker, UINT64_MAX);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+
+  // only moov and trak atoms are entered at the first two levels, so the depth
+  // of an atom determines its parent
+  while ((err = mutff_atom_walker_next(ctx, &walker, &atom)) ==
+         MuTFFErrorNone) {
+    if (!mutff_dialect_has_atom(out->dialect, atom.type)) {
+      continue;
+    }
+    if (atom.depth == 0U) {
+      if (movie_present && mutff_dialect_movie_first(out->dialect)) {
+        // nothing after the movie atom is needed
+        *n = atom.offset;
+        break;
+      }
+      if (atom.type == MuTFF_FOURCC('f', 't', 'y', 'p')) {
+        if (file_type_present) {
+          return MuTFFErrorBadFormat;
+        }
+        err = mutff_read_file_type_summary(ctx, &bytes, out);
+        file_type_present = true;
+      } else if (atom.type == MuTFF_FOURCC('m', 'o', 'o', 'v')) {
+        if (movie_present) {
+          return MuTFFErrorBadFormat;
+        }
+        err = mutff_atom_walker_enter(&walker, &atom, 0);
+        movie_present = true;
+      }
+    } else if (atom.depth == 1U) {
+      if (atom.type == MuTFF_FOURCC('m', 'v', 'h', 'd')) {
+        if (movie_header_present) {
+          return MuTFFErrorBadFormat;
+        }
+        err = mutff_read_movie_header_summary(ctx, &bytes, out);
+        movie_header_present = true;
+      } else if (atom.type == MuTFF_FOURCC('t', 'r', 'a', 'k')) {
+        if (out->track_count >= MuTFF_MAX_TRACK_ATOMS) {
+          return MuTFFErrorOutOfMemory;
+        }
+        track = &out->track[out->track_count];
+        *track = (MuTFFTrackSummary){0};
+        out->track_count++;
+        err = mutff_atom_walker_enter(&walker, &atom, 0);
+      }
+    } else {
+      err = mutff_read_track_summary_atom(ctx, &walker, &atom, track);
+    }
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+  }
+  if (err != MuTFFErrorNone && err != MuTFFErrorEOF) {
+    return err;
+  }
+
+  if (!movie_present || !movie_header_present) {
+    return MuTFFErrorBadFormat;
+  }
+
+  // if reading stopped early the context is already at the first unread atom
+  if (err == MuTFFErrorNone) {
+    return MuTFFErrorNone;
+  }
+  return mutff_atom_walker_finish(ctx, n, &walker);
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,256 @@
+///
+/// @file      mutff_sync.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library sync sample alignment source
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_sync.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_sample.h"
+
+#define MuTFF_EMPTY_EDIT UINT32_MAX
+
+// convert a time between time scales without overflowing the intermediate
+static int64_t mutff_rescale(int64_t time, uint32_t from, uint32_t to) {
+  return (time / from) * to + (time % from) * to / from;
+}
+
+MuTFFError mutff_sync_time_iterator_init(MuTFFSyncTimeIterator *out,
+                                         const MuTFFMovieAtom *movie,
+                                         size_t track, uint32_t time_scale) {
+  MuTFFError err;
+
+  if (track >= movie->track_count || time_scale == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  const MuTFFTrackAtom *trak = &movie->track[track];
+  err = mutff_media_atom_sample_table(&out->sample_table, &trak->media);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  err = mutff_sample_table_sample_count(&out->sample_count, out->sample_table);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  out->media_time_scale = trak->media.media_header.time_scale;
+  if (out->media_time_scale == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  out->time_scale = time_scale;
+
+  // empty edits delay the start of the media, the first other edit gives the
+  // media time shown first
+  uint64_t empty_duration = 0;
+  out->media_start = 0;
+  if (trak->edit_present) {
+    const MuTFFEditListAtom *edit_list = &trak->edit.edit_list_atom;
+    for (uint32_t i = 0; i < edit_list->number_of_entries; ++i) {
+      const MuTFFEditListEntry *entry = &edit_list->edit_list_table[i];
+      if (entry->media_time != MuTFF_EMPTY_EDIT) {
+        out->media_start = entry->media_time;
+        break;
+      }
+      empty_duration += entry->track_duration;
+    }
+  }
+  out->start = 0;
+  if (empty_duration > 0U) {
+    if (movie->movie_header.time_scale == 0U) {
+      return MuTFFErrorBadFormat;
+    }
+    out->start = mutff_rescale((int64_t)empty_duration,
+                               movie->movie_header.time_scale, time_scale);
+  }
+
+  out->sync_index = 0;
+  out->sample = 0;
+  out->decode_time = 0;
+  out->stts_entry = 0;
+  out->stts_sample = 0;
+  out->pending = false;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_sync_time_next(int64_t *out, MuTFFSyncTimeIterator *it) {
+  const MuTFFSampleTableAtom *sample_table = it->sample_table;
+  uint32_t target;
+
+  if (sample_table->sync_sample_present) {
+    const MuTFFSyncSampleAtom *stss = &sample_table->sync_sample;
+    if (it->sync_index >= stss->number_of_entries) {
+      return MuTFFErrorEOF;
+    }
+    // sample numbers are one-based
+    target = stss->sync_sample_table[it->sync_index];
+    if (target == 0U || target > it->sample_count) {
+      return MuTFFErrorBadFormat;
+    }
+    target--;
+  } else {
+    if (it->sync_index >= it->sample_count) {
+      return MuTFFErrorEOF;
+    }
+    target = it->sync_index;
+  }
+  if (target < it->sample) {
+    return MuTFFErrorBadFormat;
+  }
+
+  // advance through the time-to-sample table a whole entry at a time
+  const MuTFFTimeToSampleAtom *stts = &sample_table->time_to_sample;
+  while (it->sample < target) {
+    if (it->stts_entry >= stts->number_of_entries) {
+      return MuTFFErrorBadFormat;
+    }
+    const MuTFFTimeToSampleTableEntry *entry =
+        &stts->time_to_sample_table[it->stts_entry];
+    uint32_t steps = entry->sample_count - it->stts_sample;
+    if (steps > target - it->sample) {
+      steps = target - it->sample;
+    }
+    it->decode_time += (uint64_t)steps * entry->sample_duration;
+    it->sample += steps;
+    it->stts_sample += steps;
+    if (it->stts_sample >= entry->sample_count) {
+      it->stts_entry++;
+      it->stts_sample = 0;
+    }
+  }
+
+  *out = it->start + mutff_rescale((int64_t)it->decode_time -
+                                       (int64_t)it->media_start,
+                                   it->media_time_scale, it->time_scale);
+  it->sync_index++;
+  return MuTFFErrorNone;
+}
+
+// read the next time of an iterator into its pending time, if there is one
+static MuTFFError mutff_sync_time_fill(MuTFFSyncTimeIterator *it) {
+  const MuTFFError err = mutff_sync_time_next(&it->pending_time, it);
+  if (err == MuTFFErrorEOF) {
+    it->pending = false;
+    return MuTFFErrorNone;
+  }
+  it->pending = err == MuTFFErrorNone;
+  return err;
+}
+
+// whether one rendition's pending time comes before another's, breaking ties
+// by index so that renditions are visited in a fixed order
+static bool mutff_sync_before(const MuTFFSyncTimeIterator *its, size_t a,
+                              size_t b) {
+  return its[a].pending_time < its[b].pending_time ||
+         (its[a].pending_time == its[b].pending_time && a < b);
+}
+
+// add a rendition to a min-heap of renditions ordered by pending time
+static void mutff_sync_heap_push(size_t *heap, size_t *size,
+                                 const MuTFFSyncTimeIterator *its,
+                                 size_t rendition) {
+  size_t i = (*size)++;
+  while (i > 0U && mutff_sync_before(its, rendition, heap[(i - 1U) / 2U])) {
+    heap[i] = heap[(i - 1U) / 2U];
+    i = (i - 1U) / 2U;
+  }
+  heap[i] = rendition;
+}
+
+// remove the rendition with the earliest pending time from a min-heap
+static size_t mutff_sync_heap_pop(size_t *heap, size_t *size,
+                                  const MuTFFSyncTimeIterator *its) {
+  const size_t top = heap[0];
+  const size_t last = heap[--(*size)];
+  size_t i = 0;
+  for (;;) {
+    size_t child = 2U * i + 1U;
+    if (child >= *size) {
+      break;
+    }
+    if (child + 1U < *size && mutff_sync_before(its, heap[child + 1U],
+                                                heap[child])) {
+      child++;
+    }
+    if (!mutff_sync_before(its, heap[child], last)) {
+      break;
+    }
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = last;
+  return top;
+}
+
+MuTFFError mutff_check_sync_alignment(MuTFFSyncAlignment *out,
+                                      MuTFFSyncTimeIterator *its, size_t count,
+                                      uint64_t tolerance, size_t *heap) {
+  MuTFFError err;
+  size_t heap_size = 0;
+
+  out->aligned_count = 0;
+  out->misalignment_count = 0;
+  for (size_t i = 0; i < count; ++i) {
+    err = mutff_sync_time_fill(&its[i]);
+    if (err != MuTFFErrorNone) {
+      return err;
+    }
+    if (its[i].pending) {
+      mutff_sync_heap_push(heap, &heap_size, its, i);
+    }
+  }
+
+  while (heap_size > 0U) {
+    // take the renditions with a sync sample close enough to the earliest
+    // one into the space the heap frees at the end of it
+    const int64_t earliest = its[heap[0]].pending_time;
+    size_t matched = 0;
+    while (heap_size > 0U &&
+           (uint64_t)(its[heap[0]].pending_time - earliest) <= tolerance) {
+      const size_t rendition = mutff_sync_heap_pop(heap, &heap_size, its);
+      heap[count - ++matched] = rendition;
+    }
+    // put them in order of time, so each is read before a push reuses its slot
+    const size_t first = count - matched;
+    for (size_t j = 0; j < matched / 2U; ++j) {
+      const size_t rendition = heap[first + j];
+      heap[first + j] = heap[count - 1U - j];
+      heap[count - 1U - j] = rendition;
+    }
+
+    if (matched == count) {
+      out->aligned_count++;
+    }
+    for (size_t j = 0; j < matched; ++j) {
+      const size_t i = heap[first + j];
+      MuTFFSyncTimeIterator *it = &its[i];
+      if (matched != count) {
+        if (out->misalignment_count < MuTFF_MAX_SYNC_MISALIGNMENTS) {
+          MuTFFSyncMisalignment *misalignment =
+              &out->misalignment[out->misalignment_count];
+          misalignment->time = it->pending_time;
+          misalignment->rendition = i;
+          misalignment->sync_index = it->sync_index - 1U;
+        }
+        out->misalignment_count++;
+      }
+      err = mutff_sync_time_fill(it);
+      if (err != MuTFFErrorNone) {
+        return err;
+      }
+      if (it->pending) {
+        mutff_sync_heap_push(heap, &heap_size, its, i);
+      }
+    }
+  }
+  return MuTFFErrorNone;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,356 @@
+///
+/// @file      mutff_util.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF MP4/QTFF library internal serialisation helpers
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_UTIL_H_
+#define MUTFF_UTIL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+#define MuTFF_FN(func, ...)               \
+  do {                                    \
+    err = func(ctx, &bytes, __VA_ARGS__); \
+    if (err != MuTFFErrorNone) {          \
+      return err;                         \
+    }                                     \
+    *(n) += (bytes);                      \
+  } while (0);
+
+#define MuTFF_READ_CHILD(func, field, flag) \
+  do {                                      \
+    if (flag == true) {                     \
+      return MuTFFErrorBadFormat;           \
+    }                                       \
+    MuTFF_FN(func, field);                  \
+    (flag) = true;                          \
+  } while (0);
+
+#define MuTFF_SEEK_CUR(offset)     \
+  do {                             \
+    err = mutff_seek(ctx, offset); \
+    if (err != MuTFFErrorNone) {   \
+      return err;                  \
+    }                              \
+    *(n) += (offset);              \
+  } while (0);
+
+// Convert a number from network (big) endian to host endian.
+// These must be implemented here as newlib does not provide the
+// standard library implementations ntohs & ntohl (arpa/inet.h).
+//
+// taken from:
+// https://stackoverflow.com/questions/2100331/macro-definition-to-determine-big-endian-or-little-endian-machine
+static inline uint16_t mutff_ntoh_16(unsigned char *no) {
+  return ((uint16_t)no[0] << 8) | (uint16_t)no[1];
+}
+
+static inline void mutff_hton_16(unsigned char *dest, uint16_t n) {
+  dest[0] = n >> 8;
+  dest[1] = n;
+}
+
+static inline mutff_uint24_t mutff_ntoh_24(unsigned char *no) {
+  return ((mutff_uint24_t)no[0] << 16) | ((mutff_uint24_t)no[1] << 8) |
+         (mutff_uint24_t)no[2];
+}
+
+static inline void mutff_hton_24(unsigned char *dest, mutff_uint24_t n) {
+  // note this is using implicit truncation
+  dest[0] = n >> 16;
+  dest[1] = n >> 8;
+  dest[2] = n;
+}
+
+static inline uint32_t mutff_ntoh_32(unsigned char *no) {
+  return ((uint32_t)no[0] << 24) | ((uint32_t)no[1] << 16) |
+         ((uint32_t)no[2] << 8) | (uint32_t)no[3];
+}
+
+static inline void mutff_hton_32(unsigned char *dest, uint32_t n) {
+  // note this is using implicit truncation
+  dest[0] = n >> 24;
+  dest[1] = n >> 16;
+  dest[2] = n >> 8;
+  dest[3] = n;
+}
+
+static inline uint64_t mutff_ntoh_64(unsigned char *no) {
+  return ((uint64_t)no[0] << 56) | ((uint64_t)no[1] << 48) |
+         ((uint64_t)no[2] << 40) | ((uint64_t)no[3] << 32) |
+         ((uint64_t)no[4] << 24) | ((uint64_t)no[5] << 16) |
+         ((uint64_t)no[6] << 8) | (uint64_t)no[7];
+}
+
+static inline void mutff_hton_64(unsigned char *dest, uint64_t n) {
+  // note this is using implicit truncation
+  dest[0] = n >> 56;
+  dest[1] = n >> 48;
+  dest[2] = n >> 40;
+  dest[3] = n >> 32;
+  dest[4] = n >> 24;
+  dest[5] = n >> 16;
+  dest[6] = n >> 8;
+  dest[7] = n;
+}
+
+static inline MuTFFError mutff_read_u8(MuTFFContext *ctx, size_t *n,
+                                       uint8_t *data) {
+  const MuTFFError err = mutff_read(ctx, data, 1);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *n = 1U;
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_read_i8(MuTFFContext *ctx, size_t *n,
+                                       int8_t *dest) {
+  MuTFFError err;
+  uint8_t twos;
+  size_t bytes;
+  *n = 0;
+  *n = 0;
+
+  MuTFF_FN(mutff_read_u8, &twos);
+  // convert from twos complement to implementation-defined
+  *dest = (twos & 0x7FU) - (twos & 0x80U);
+
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_read_u16(MuTFFContext *ctx, size_t *n,
+                                        uint16_t *dest) {
+  unsigned char data[2];
+  const MuTFFError err = mutff_read(ctx, data, 2);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  // Convert from network order (big-endian)
+  // to host order (implementation-defined).
+  *dest = mutff_ntoh_16(data);
+  *n = 2U;
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_read_i16(MuTFFContext *ctx, size_t *n,
+                                        int16_t *dest) {
+  MuTFFError err;
+  uint16_t twos;
+  size_t bytes;
+  *n = 0;
+
+  MuTFF_FN(mutff_read_u16, &twos);
+  *dest = (twos & 0x7FFFU) - (twos & 0x8000U);
+
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_read_u24(MuTFFContext *ctx, size_t *n,
+                                        mutff_uint24_t *dest) {
+  unsigned char data[3];
+  const MuTFFError err = mutff_read(ctx, data, 3);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *dest = mutff_ntoh_24(data);
+  *n = 3U;
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_read_u32(MuTFFContext *ctx, size_t *n,
+                                        uint32_t *dest) {
+  unsigned char data[4];
+  const MuTFFError err = mutff_read(ctx, data, 4);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *dest = mutff_ntoh_32(data);
+  *n = 4U;
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_read_i32(MuTFFContext *ctx, size_t *n,
+                                        int32_t *dest) {
+  MuTFFError err;
+  uint32_t twos;
+  size_t bytes;
+  *n = 0;
+
+  MuTFF_FN(mutff_read_u32, &twos);
+  *dest = (twos & 0x7FFFFFFFU) - (twos & 0x80000000U);
+
+  *n = bytes;
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_read_u64(MuTFFContext *ctx, size_t *n,
+                                        uint64_t *dest) {
+  unsigned char data[8];
+  const MuTFFError err = mutff_read(ctx, data, 8);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *dest = mutff_ntoh_64(data);
+  *n = 8U;
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_write_u8(MuTFFContext *ctx, size_t *n,
+                                        uint8_t data) {
+  const MuTFFError err = mutff_write(ctx, &data, 1);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *n = 1U;
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_write_i8(MuTFFContext *ctx, size_t *n,
+                                        int8_t x) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  // ensure number is stored as two's complement
+  x = x >= 0 ? x : ~abs(x) + 1;
+  MuTFF_FN(mutff_write_u8, x);
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_write_u16(MuTFFContext *ctx, size_t *n,
+                                         uint16_t x) {
+  unsigned char data[2];
+  // convert number to network order
+  mutff_hton_16(data, x);
+  const MuTFFError err = mutff_write(ctx, &data, 2);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *n = 2U;
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_write_i16(MuTFFContext *ctx, size_t *n,
+                                         int16_t x) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  x = x >= 0 ? x : ~abs(x) + 1;
+  MuTFF_FN(mutff_write_u16, x);
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_write_u24(MuTFFContext *ctx, size_t *n,
+                                         mutff_uint24_t x) {
+  unsigned char data[3];
+  mutff_hton_24(data, x);
+  const MuTFFError err = mutff_write(ctx, &data, 3);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *n = 3U;
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_write_u32(MuTFFContext *ctx, size_t *n,
+                                         uint32_t x) {
+  unsigned char data[4];
+  mutff_hton_32(data, x);
+  const MuTFFError err = mutff_write(ctx, &data, 4);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *n = 4U;
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_write_i32(MuTFFContext *ctx, size_t *n,
+                                         int32_t x) {
+  return mutff_write_u32(ctx, n, x >= 0 ? x : ~abs(x) + 1);
+}
+
+static inline MuTFFError mutff_write_u64(MuTFFContext *ctx, size_t *n,
+                                         uint64_t x) {
+  unsigned char data[8];
+  mutff_hton_64(data, x);
+  const MuTFFError err = mutff_write(ctx, &data, 8);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  *n = 8U;
+  return MuTFFErrorNone;
+}
+
+// return the size of an atom including its header, given the size of the data
+// in it
+static inline uint64_t mutff_atom_size(uint64_t data_size) {
+  return data_size + 8U <= UINT32_MAX ? data_size + 8U : data_size + 16U;
+}
+
+// return the size of the data in an atom, given the size of the entire atom
+// including its header in it
+static inline uint64_t mutff_data_size(uint64_t atom_size) {
+  return atom_size <= UINT32_MAX ? atom_size - 8U : atom_size - 16U;
+}
+
+static inline MuTFFError mutff_read_header(MuTFFContext *ctx, size_t *n,
+                                           uint64_t *size, uint32_t *type) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+  uint32_t short_size;
+
+  MuTFF_FN(mutff_read_u32, &short_size);
+  MuTFF_FN(mutff_read_u32, type);
+  if (short_size == 1U) {
+    MuTFF_FN(mutff_read_u64, size);
+  } else {
+    *size = short_size;
+  }
+
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_peek_atom_header(MuTFFContext *ctx, size_t *n,
+                                                uint64_t *size,
+                                                uint32_t *type) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+
+  MuTFF_FN(mutff_read_header, size, type);
+  MuTFF_SEEK_CUR(-bytes);
+
+  return MuTFFErrorNone;
+}
+
+static inline MuTFFError mutff_write_header(MuTFFContext *ctx, size_t *n,
+                                            uint64_t size, uint32_t type) {
+  MuTFFError err;
+  size_t bytes;
+  *n = 0;
+
+  if (size > UINT32_MAX) {
+    MuTFF_FN(mutff_write_u32, 1);
+    MuTFF_FN(mutff_write_u32, type);
+    MuTFF_FN(mutff_write_u64, size);
+  } else {
+    MuTFF_FN(mutff_write_u32, size);
+    MuTFF_FN(mutff_write_u32, type);
+  }
+
+  return MuTFFErrorNone;
+}
+
+#endif  // MUTFF_UTIL_H_
+
+// vi:sw=2:ts=2:et:fdm=marker
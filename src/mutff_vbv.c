@@ -0,0 +1,162 @@
+///
+/// @file      mutff_vbv.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library decoder buffer model source
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_vbv.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_sample.h"
+
+// the number of bits to arrive by a time, in the media time scale
+static uint64_t mutff_vbv_arrived(uint64_t bit_rate, uint64_t time,
+                                  uint32_t time_scale) {
+  return (time / time_scale) * bit_rate +
+         (time % time_scale) * bit_rate / time_scale;
+}
+
+static void mutff_vbv_event(MuTFFVBVReport *out, MuTFFVBVEventType type,
+                            uint32_t sample, uint64_t time, uint64_t excess) {
+  if (out->event_count < MuTFF_MAX_VBV_EVENTS) {
+    MuTFFVBVEvent *event = &out->event[out->event_count++];
+    event->type = type;
+    event->sample = sample;
+    event->time = time;
+    event->excess = excess;
+  }
+}
+
+// the most bits held just before a removal with a delay that never underflows
+static uint64_t mutff_vbv_peak(const MuTFFSampleTableAtom *sample_table,
+                               uint32_t sample_count, uint32_t time_scale,
+                               uint64_t bit_rate, uint64_t delay) {
+  const MuTFFSampleSizeAtom *stsz = &sample_table->sample_size;
+  const MuTFFTimeToSampleAtom *stts = &sample_table->time_to_sample;
+  uint64_t removed = 0;
+  uint64_t decode_time = 0;
+  uint64_t peak = 0;
+  uint32_t stts_entry = 0;
+  uint32_t stts_sample = 0;
+  for (uint32_t i = 0; i < sample_count; ++i) {
+    const uint64_t arrived =
+        mutff_vbv_arrived(bit_rate, decode_time + delay, time_scale);
+    if (arrived - removed > peak) {
+      peak = arrived - removed;
+    }
+    removed += 8U * (uint64_t)(stsz->sample_size != 0U
+                                   ? stsz->sample_size
+                                   : stsz->sample_size_table[i]);
+    const MuTFFTimeToSampleTableEntry *entry =
+        &stts->time_to_sample_table[stts_entry];
+    decode_time += entry->sample_duration;
+    if (++stts_sample >= entry->sample_count) {
+      stts_entry++;
+      stts_sample = 0;
+    }
+  }
+  return peak;
+}
+
+MuTFFError mutff_simulate_vbv(MuTFFVBVReport *out,
+                              const MuTFFSampleTableAtom *sample_table,
+                              uint32_t time_scale, const MuTFFVBVModel *model) {
+  MuTFFError err;
+  uint32_t sample_count;
+  const MuTFFSampleSizeAtom *stsz = &sample_table->sample_size;
+  const MuTFFTimeToSampleAtom *stts = &sample_table->time_to_sample;
+
+  out->underflow_count = 0;
+  out->overflow_count = 0;
+  out->event_count = 0;
+  out->peak_fullness = 0;
+  out->min_initial_delay = 0;
+  out->min_buffer_size = 0;
+
+  if (time_scale == 0U || model->bit_rate == 0U) {
+    return MuTFFErrorBadFormat;
+  }
+  err = mutff_sample_table_sample_count(&sample_count, sample_table);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (stsz->sample_size == 0U &&
+      (stsz->number_of_entries < sample_count ||
+       sample_count > MuTFF_MAX_SAMPLE_SIZE_TABLE_LEN)) {
+    return MuTFFErrorBadFormat;
+  }
+
+  // `removed` is the prefix sum of the sample sizes, in bits, before the
+  // current sample
+  uint64_t removed = 0;
+  uint64_t decode_time = 0;
+  uint64_t max_deficit = 0;
+  uint32_t stts_entry = 0;
+  uint32_t stts_sample = 0;
+  for (uint32_t i = 0; i < sample_count; ++i) {
+    const uint64_t size =
+        8U * (uint64_t)(stsz->sample_size != 0U ? stsz->sample_size
+                                                : stsz->sample_size_table[i]);
+
+    // fullness with no delay, to find the least delay
+    const uint64_t arrived_undelayed =
+        mutff_vbv_arrived(model->bit_rate, decode_time, time_scale);
+    if (removed + size > arrived_undelayed &&
+        removed + size - arrived_undelayed > max_deficit) {
+      max_deficit = removed + size - arrived_undelayed;
+    }
+
+    // fullness with the model's delay
+    const uint64_t time = decode_time + model->initial_delay;
+    const uint64_t arrived =
+        mutff_vbv_arrived(model->bit_rate, time, time_scale);
+    if (arrived < removed + size) {
+      out->underflow_count++;
+      mutff_vbv_event(out, MuTFFVBVUnderflow, i, time,
+                      removed + size - arrived);
+    }
+    if (arrived > removed) {
+      const uint64_t fullness = arrived - removed;
+      if (fullness > out->peak_fullness) {
+        out->peak_fullness = fullness;
+      }
+      if (fullness > model->buffer_size) {
+        out->overflow_count++;
+        mutff_vbv_event(out, MuTFFVBVOverflow, i, time,
+                        fullness - model->buffer_size);
+      }
+    }
+    removed += size;
+
+    if (stts_entry >= stts->number_of_entries) {
+      return MuTFFErrorBadFormat;
+    }
+    const MuTFFTimeToSampleTableEntry *entry =
+        &stts->time_to_sample_table[stts_entry];
+    decode_time += entry->sample_duration;
+    if (++stts_sample >= entry->sample_count) {
+      stts_entry++;
+      stts_sample = 0;
+    }
+  }
+
+  // the delay is rounded up to a media tick, so the buffer size is found from
+  // the arrivals at that delay rather than from the deficit
+  out->min_initial_delay =
+      (max_deficit / model->bit_rate) * time_scale +
+      ((max_deficit % model->bit_rate) * time_scale + model->bit_rate - 1U) /
+          model->bit_rate;
+  out->min_buffer_size =
+      mutff_vbv_peak(sample_table, sample_count, time_scale, model->bit_rate,
+                     out->min_initial_delay);
+  return MuTFFErrorNone;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
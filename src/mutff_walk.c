@@ -0,0 +1,140 @@
+///
+/// @file      mutff_walk.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     MuTFF QuickTime file format library atom walker source file
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#include "mutff_walk.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutff.h"
+#include "mutff_util.h"
+
+// move the context to an offset within the walked region
+static MuTFFError mutff_atom_walker_seek(MuTFFContext *ctx,
+                                         const MuTFFAtomWalker *walker,
+                                         uint64_t offset) {
+  MuTFFError err;
+  unsigned int pos;
+
+  err = mutff_tell(ctx, &pos);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  const int64_t delta = (int64_t)(walker->start + offset) - (int64_t)pos;
+  if (delta == 0) {
+    return MuTFFErrorNone;
+  }
+  return mutff_seek(ctx, (long)delta);
+}
+
+MuTFFError mutff_atom_walker_init(MuTFFContext *ctx, MuTFFAtomWalker *walker,
+                                  uint64_t size) {
+  walker->next = 0;
+  walker->depth = 0;
+  walker->end[0] = size;
+  return mutff_tell(ctx, &walker->start);
+}
+
+MuTFFError mutff_atom_walker_next(MuTFFContext *ctx, MuTFFAtomWalker *walker,
+                                  MuTFFAtomInfo *out) {
+  MuTFFError err;
+  size_t bytes;
+  uint64_t size;
+  uint32_t type;
+
+  // leave every container whose children have all been visited
+  while (walker->depth > 0U && walker->next >= walker->end[walker->depth]) {
+    walker->depth--;
+  }
+  const uint64_t end = walker->end[walker->depth];
+  if (walker->next >= end) {
+    return MuTFFErrorEOF;
+  }
+
+  err = mutff_atom_walker_seek(ctx, walker, walker->next);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  err = mutff_read_header(ctx, &bytes, &size, &type);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+  if (size == 0U) {
+    // the atom extends to the end of its container
+    if (end == UINT64_MAX) {
+      return MuTFFErrorBadFormat;
+    }
+    size = end - walker->next;
+  }
+  if (size < bytes || size > end - walker->next) {
+    return MuTFFErrorBadFormat;
+  }
+  err = mutff_seek(ctx, -(long)bytes);
+  if (err != MuTFFErrorNone) {
+    return err;
+  }
+
+  out->offset = walker->next;
+  out->size = size;
+  out->type = type;
+  out->header_size = bytes;
+  out->depth = walker->depth;
+  walker->next += size;
+
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_atom_walker_enter(MuTFFAtomWalker *walker,
+                                   const MuTFFAtomInfo *atom, uint64_t skip) {
+  if (walker->depth >= MuTFF_MAX_ATOM_DEPTH) {
+    return MuTFFErrorOutOfMemory;
+  }
+  if (skip > atom->size - atom->header_size) {
+    return MuTFFErrorBadFormat;
+  }
+  walker->depth++;
+  walker->end[walker->depth] = atom->offset + atom->size;
+  walker->next = atom->offset + atom->header_size + skip;
+  return MuTFFErrorNone;
+}
+
+MuTFFError mutff_atom_walker_finish(MuTFFContext *ctx, size_t *n,
+                                    const MuTFFAtomWalker *walker) {
+  const uint64_t end = walker->depth > 0U ? walker->end[1] : walker->next;
+  *n = end;
+  return mutff_atom_walker_seek(ctx, walker, end);
+}
+
+bool mutff_is_container_atom(uint32_t type) {
+  switch (type) {
+    case MuTFF_FOURCC('m', 'o', 'o', 'v'):
+    case MuTFF_FOURCC('c', 'l', 'i', 'p'):
+    case MuTFF_FOURCC('t', 'r', 'a', 'k'):
+    case MuTFF_FOURCC('m', 'a', 't', 't'):
+    case MuTFF_FOURCC('e', 'd', 't', 's'):
+    case MuTFF_FOURCC('t', 'r', 'e', 'f'):
+    case MuTFF_FOURCC('t', 'a', 'p', 't'):
+    case MuTFF_FOURCC('m', 'd', 'i', 'a'):
+    case MuTFF_FOURCC('m', 'i', 'n', 'f'):
+    case MuTFF_FOURCC('g', 'm', 'h', 'd'):
+    case MuTFF_FOURCC('d', 'i', 'n', 'f'):
+    case MuTFF_FOURCC('s', 't', 'b', 'l'):
+    case MuTFF_FOURCC('u', 'd', 't', 'a'):
+    case MuTFF_FOURCC('m', 'v', 'e', 'x'):
+    case MuTFF_FOURCC('m', 'o', 'o', 'f'):
+    case MuTFF_FOURCC('t', 'r', 'a', 'f'):
+    case MuTFF_FOURCC('m', 'f', 'r', 'a'):
+      return true;
+    default:
+      return false;
+  }
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
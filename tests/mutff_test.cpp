@@ -7,8 +7,27 @@
 
 extern "C" {
 #include "mutff.h"
+#include "mutff_cmov.h"
 #include "mutff_default.h"
+#include "mutff_dialect.h"
+#include "mutff_drift.h"
+#include "mutff_edl.h"
+#include "mutff_faststart.h"
+#include "mutff_fragment.h"
+#include "mutff_frame.h"
+#include "mutff_hint.h"
+#include "mutff_item.h"
+#include "mutff_memory.h"
+#include "mutff_pcm.h"
+#include "mutff_pool.h"
+#include "mutff_query.h"
+#include "mutff_sample.h"
+#include "mutff_segment.h"
 #include "mutff_stdlib.h"
+#include "mutff_summary.h"
+#include "mutff_sync.h"
+#include "mutff_vbv.h"
+#include "mutff_walk.h"
 }
 
 // {{{1 unit tests
@@ -4904,6 +4923,113 @@ TEST_F(UnitTest, ReadMovieAtom) {
 }
 // }}}2
 
+// {{{2 movie atom layout unit tests
+TEST_F(UnitTest, MovieAtomLayout) {
+  MuTFFError err;
+  MuTFFMovieAtomLayout layout;
+  err = mutff_movie_atom_layout(&layout, &moov_test_struct);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(layout.size, moov_test_data_size);
+  EXPECT_EQ(layout.head.offset, 0);
+  EXPECT_EQ(layout.head.size, 8 + mvhd_test_data_size);
+  ASSERT_EQ(layout.track_count, 1);
+  EXPECT_EQ(layout.track[0].offset, 8 + mvhd_test_data_size);
+  EXPECT_EQ(layout.track[0].size, trak_test_data_size);
+  EXPECT_EQ(layout.tail.offset, 8 + mvhd_test_data_size + trak_test_data_size);
+  EXPECT_EQ(layout.tail.size, moov_test_data_size - layout.tail.offset);
+}
+
+TEST_F(UnitTest, WriteMovieAtomRegions) {
+  MuTFFError err;
+  MuTFFMovieAtomLayout layout;
+  err = mutff_movie_atom_layout(&layout, &moov_test_struct);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  // write each region through its own context, tail first
+  unsigned char data[moov_test_data_size];
+  MuTFFMemoryBuffer buf;
+  MuTFFContext region_ctx;
+  region_ctx.io = mutff_memory_driver;
+  region_ctx.file = &buf;
+
+  mutff_memory_buffer_init(&buf, &data[layout.tail.offset], layout.tail.size);
+  err = mutff_write_movie_atom_tail(&region_ctx, &bytes, &moov_test_struct);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, layout.tail.size);
+
+  mutff_memory_buffer_init(&buf, &data[layout.track[0].offset],
+                           layout.track[0].size);
+  err = mutff_write_track_atom(&region_ctx, &bytes, &moov_test_struct.track[0]);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, layout.track[0].size);
+
+  mutff_memory_buffer_init(&buf, &data[layout.head.offset], layout.head.size);
+  err = mutff_write_movie_atom_head(&region_ctx, &bytes, &moov_test_struct);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, layout.head.size);
+
+  for (size_t i = 0; i < moov_test_data_size; ++i) {
+    EXPECT_EQ(data[i], moov_test_data[i]);
+  }
+}
+// }}}2
+
+// {{{2 movie atom rewrite unit tests
+TEST_F(UnitTest, RewriteMovieAtom) {
+  MuTFFError err;
+  fwrite(moov_test_data, moov_test_data_size, 1, (FILE *)ctx.file);
+  rewind((FILE *)ctx.file);
+  MuTFFMovieAtomSource source;
+  err = mutff_read_movie_atom_source(&ctx, &bytes, &source);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, moov_test_data_size);
+  EXPECT_EQ(source.offset, 0);
+  ASSERT_EQ(source.child_count, 6);
+  EXPECT_EQ(source.child_type[1], MuTFF_FOURCC('t', 'r', 'a', 'k'));
+  EXPECT_EQ(source.child[1].offset, 8 + mvhd_test_data_size);
+  EXPECT_EQ(source.child[1].size, trak_test_data_size);
+
+  MuTFFMovieAtom atom = moov_test_struct;
+  unsigned char data[moov_test_data_size];
+  MuTFFMemoryBuffer buf;
+  MuTFFContext out_ctx;
+  out_ctx.io = mutff_memory_driver;
+  out_ctx.file = &buf;
+
+  // clean children are copied from the source, not serialised
+  atom.track[0].track_header.duration = 0xDEADBEEF;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+  err = mutff_rewrite_movie_atom(&out_ctx, &bytes, &ctx, &source, &atom, 0);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, moov_test_data_size);
+  for (size_t i = 0; i < moov_test_data_size; ++i) {
+    EXPECT_EQ(data[i], moov_test_data[i]);
+  }
+
+  // dirty children are serialised
+  atom = moov_test_struct;
+  atom.user_data_present = false;
+  unsigned char expected[moov_test_data_size];
+  MuTFFMemoryBuffer expected_buf;
+  MuTFFContext expected_ctx;
+  expected_ctx.io = mutff_memory_driver;
+  expected_ctx.file = &expected_buf;
+  mutff_memory_buffer_init(&expected_buf, expected, sizeof(expected));
+  err = mutff_write_movie_atom(&expected_ctx, &bytes, &atom);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, moov_test_data_size - udta_test_data_size);
+
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+  err = mutff_rewrite_movie_atom(&out_ctx, &bytes, &ctx, &source, &atom,
+                                 MuTFF_DIRTY_USER_DATA);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(bytes, moov_test_data_size - udta_test_data_size);
+  for (size_t i = 0; i < bytes; ++i) {
+    EXPECT_EQ(data[i], expected[i]);
+  }
+}
+// }}}2
+
 // {{{2 movie fragment header atom unit tests
 static const uint32_t mfhd_test_data_size = 16;
 // clang-format off
@@ -5509,6 +5635,939 @@ TEST_F(UnitTest, ReadMovieFile) {
   EXPECT_EQ(ftell((FILE *)ctx.file), file_test_data_size);
 }
 // }}}2
+
+// {{{2 memory driver unit tests
+TEST(MemoryDriver, ReadWriteSeek) {
+  MuTFFError err;
+  unsigned char data[4];
+  unsigned char out[4];
+  unsigned int pos;
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+
+  const unsigned char in[4] = {0x01, 0x02, 0x03, 0x04};
+  err = mutff_write(&ctx, in, 4);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_write(&ctx, in, 1);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+  err = mutff_tell(&ctx, &pos);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(pos, 4);
+
+  err = mutff_seek(&ctx, -3);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_read(&ctx, out, 3);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(out[0], 0x02);
+  EXPECT_EQ(out[1], 0x03);
+  EXPECT_EQ(out[2], 0x04);
+  err = mutff_read(&ctx, out, 1);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+
+  EXPECT_EQ(mutff_seek(&ctx, 1), MuTFFErrorIOError);
+  EXPECT_EQ(mutff_seek(&ctx, -5), MuTFFErrorIOError);
+}
+// }}}2
+
+// {{{2 parse pool unit tests
+TEST(ParsePool, AcquireRelease) {
+  MuTFFError err;
+  MuTFFParseContext contexts[2];
+  uint64_t arena[8];
+  MuTFFParsePool pool;
+  mutff_parse_pool_init(&pool, contexts, 2, arena, sizeof(arena));
+  EXPECT_EQ(pool.free_count, 2);
+
+  MuTFFParseContext *a;
+  MuTFFParseContext *b;
+  MuTFFParseContext *c;
+  err = mutff_parse_pool_acquire(&a, &pool);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_parse_pool_acquire(&b, &pool);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_NE(a, b);
+  err = mutff_parse_pool_acquire(&c, &pool);
+  EXPECT_EQ(err, MuTFFErrorOutOfMemory);
+  EXPECT_EQ(a->arena_size, 32);
+  EXPECT_EQ(b->arena_size, 32);
+  EXPECT_NE(a->arena, b->arena);
+
+  void *x;
+  void *y;
+  err = mutff_parse_context_alloc(&x, a, 3);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_parse_context_alloc(&y, a, 8);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ((unsigned char *)y - (unsigned char *)x, 8);
+  err = mutff_parse_context_alloc(&y, a, 17);
+  EXPECT_EQ(err, MuTFFErrorOutOfMemory);
+  err = mutff_parse_context_alloc(&y, a, 16);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  mutff_parse_pool_release(&pool, a);
+  EXPECT_EQ(pool.free_count, 1);
+  err = mutff_parse_pool_acquire(&c, &pool);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(c, a);
+  err = mutff_parse_context_alloc(&y, c, 32);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(y, x);
+}
+// }}}2
+
+// {{{2 atom walker unit tests
+TEST(AtomWalker, Nested) {
+  MuTFFError err;
+  // two levels of nesting followed by a sibling at the top level
+  unsigned char data[] = {
+      0x00, 0x00, 0x00, 0x18, 'm',  'o',  'o',  'v',  // moov
+      0x00, 0x00, 0x00, 0x10, 't',  'r',  'a',  'k',  // trak
+      0x00, 0x00, 0x00, 0x08, 'f',  'r',  'e',  'e',  // free
+      0x00, 0x00, 0x00, 0x0a, 's',  'k',  'i',  'p',  // skip
+      0x00, 0x00,
+  };
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+
+  MuTFFAtomWalker walker;
+  MuTFFAtomInfo atom;
+  err = mutff_atom_walker_init(&ctx, &walker, sizeof(data));
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  const uint32_t types[] = {
+      MuTFF_FOURCC('m', 'o', 'o', 'v'),
+      MuTFF_FOURCC('t', 'r', 'a', 'k'),
+      MuTFF_FOURCC('f', 'r', 'e', 'e'),
+      MuTFF_FOURCC('s', 'k', 'i', 'p'),
+  };
+  const size_t depths[] = {0, 1, 2, 0};
+  for (size_t i = 0; i < 4; ++i) {
+    err = mutff_atom_walker_next(&ctx, &walker, &atom);
+    ASSERT_EQ(err, MuTFFErrorNone);
+    EXPECT_EQ(atom.type, types[i]);
+    EXPECT_EQ(atom.depth, depths[i]);
+    EXPECT_EQ(buf.pos, atom.offset);
+    if (mutff_is_container_atom(atom.type)) {
+      err = mutff_atom_walker_enter(&walker, &atom, 0);
+      ASSERT_EQ(err, MuTFFErrorNone);
+    }
+  }
+  err = mutff_atom_walker_next(&ctx, &walker, &atom);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+
+  size_t bytes;
+  err = mutff_atom_walker_finish(&ctx, &bytes, &walker);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, sizeof(data));
+  EXPECT_EQ(buf.pos, sizeof(data));
+}
+
+TEST(AtomWalker, MaxDepth) {
+  MuTFFError err;
+  unsigned char data[8 * (MuTFF_MAX_ATOM_DEPTH + 1)];
+  for (size_t i = 0; i <= MuTFF_MAX_ATOM_DEPTH; ++i) {
+    const size_t size = sizeof(data) - 8 * i;
+    unsigned char *header = &data[8 * i];
+    header[0] = 0;
+    header[1] = 0;
+    header[2] = 0;
+    header[3] = size;
+    memcpy(&header[4], "moov", 4);
+  }
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+
+  MuTFFAtomWalker walker;
+  MuTFFAtomInfo atom;
+  err = mutff_atom_walker_init(&ctx, &walker, sizeof(data));
+  ASSERT_EQ(err, MuTFFErrorNone);
+  for (size_t i = 0; i < MuTFF_MAX_ATOM_DEPTH; ++i) {
+    err = mutff_atom_walker_next(&ctx, &walker, &atom);
+    ASSERT_EQ(err, MuTFFErrorNone);
+    err = mutff_atom_walker_enter(&walker, &atom, 0);
+    ASSERT_EQ(err, MuTFFErrorNone);
+  }
+  err = mutff_atom_walker_next(&ctx, &walker, &atom);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(atom.depth, MuTFF_MAX_ATOM_DEPTH);
+  err = mutff_atom_walker_enter(&walker, &atom, 0);
+  EXPECT_EQ(err, MuTFFErrorOutOfMemory);
+}
+// }}}2
+
+// {{{2 dialect unit tests
+TEST(Dialect, FileType) {
+  MuTFFDialect dialect;
+  MuTFFFileTypeAtom atom = {
+      MuTFF_FOURCC('q', 't', ' ', ' '),
+      0,
+      1,
+      {MuTFF_FOURCC('i', 's', 'o', 'm')},
+  };
+  mutff_file_type_dialect(&dialect, &atom);
+  EXPECT_EQ(dialect, MuTFFDialectQuickTime);
+
+  atom.major_brand = MuTFF_FOURCC('m', 'p', '4', '2');
+  mutff_file_type_dialect(&dialect, &atom);
+  EXPECT_EQ(dialect, MuTFFDialectISO);
+
+  atom.compatible_brands[1] = MuTFF_FOURCC('c', 'm', 'f', 'c');
+  atom.compatible_brands_count = 2;
+  mutff_file_type_dialect(&dialect, &atom);
+  EXPECT_EQ(dialect, MuTFFDialectCMAF);
+
+  atom.major_brand = MuTFF_FOURCC('x', 'x', 'x', 'x');
+  atom.compatible_brands_count = 0;
+  mutff_file_type_dialect(&dialect, &atom);
+  EXPECT_EQ(dialect, MuTFFDialectISO);
+
+  EXPECT_TRUE(mutff_dialect_has_atom(MuTFFDialectQuickTime,
+                                     MuTFF_FOURCC('c', 'l', 'i', 'p')));
+  EXPECT_FALSE(mutff_dialect_has_atom(MuTFFDialectISO,
+                                      MuTFF_FOURCC('c', 'l', 'i', 'p')));
+  EXPECT_TRUE(mutff_dialect_has_atom(MuTFFDialectISO,
+                                     MuTFF_FOURCC('t', 'r', 'a', 'k')));
+  EXPECT_FALSE(mutff_dialect_movie_first(MuTFFDialectISO));
+  EXPECT_TRUE(mutff_dialect_movie_first(MuTFFDialectCMAF));
+}
+
+TEST(Dialect, MovieFirstSummary) {
+  MuTFFError err;
+  size_t bytes;
+  unsigned char data[256];
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+
+  const MuTFFFileTypeAtom file_type = {
+      MuTFF_FOURCC('c', 'm', 'f', 'c'),
+      0,
+      1,
+      {MuTFF_FOURCC('i', 's', 'o', '6')},
+  };
+  err = mutff_write_file_type_atom(&ctx, &bytes, &file_type);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  MuTFFMovieAtom movie = {};
+  movie.movie_header.time_scale = 1000;
+  err = mutff_write_movie_atom(&ctx, &bytes, &movie);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  const size_t movie_end = buf.pos;
+  // a truncated fragment, which must not be read
+  const unsigned char fragment[] = {0x00, 0x00, 0x01, 0x00, 'm', 'o', 'o', 'f'};
+  memcpy(&data[buf.pos], fragment, sizeof(fragment));
+
+  buf.pos = 0;
+  MuTFFMovieSummary summary;
+  err = mutff_read_movie_summary(&ctx, &bytes, &summary);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(summary.dialect, MuTFFDialectCMAF);
+  EXPECT_EQ(summary.time_scale, 1000);
+  EXPECT_EQ(bytes, movie_end);
+  EXPECT_EQ(buf.pos, movie_end);
+}
+// }}}2
+
+// {{{2 HEIF item unit tests
+TEST(HEIF, Thumbnail) {
+  MuTFFError err;
+  size_t bytes;
+  unsigned char data[] = {
+      0x00, 0x00, 0x00, 0x10, 'f',  't',  'y',  'p',  // ftyp
+      'h',  'e',  'i',  'c',  0x00, 0x00, 0x00, 0x00,  //
+      0x00, 0x00, 0x00, 0xf1, 'm',  'e',  't',  'a',  // meta
+      0x00, 0x00, 0x00, 0x00,                          //
+      0x00, 0x00, 0x00, 0x21, 'h',  'd',  'l',  'r',  // hdlr
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  //
+      'p',  'i',  'c',  't',  0x00, 0x00, 0x00, 0x00,  //
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  //
+      0x00,                                            //
+      0x00, 0x00, 0x00, 0x0e, 'p',  'i',  't',  'm',  // pitm
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x01,              //
+      0x00, 0x00, 0x00, 0x38, 'i',  'i',  'n',  'f',  // iinf
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x02,              //
+      0x00, 0x00, 0x00, 0x15, 'i',  'n',  'f',  'e',  // infe
+      0x02, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00,  //
+      'h',  'v',  'c',  '1',  0x00,                    //
+      0x00, 0x00, 0x00, 0x15, 'i',  'n',  'f',  'e',  // infe
+      0x02, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00,  //
+      'h',  'v',  'c',  '1',  0x00,                    //
+      0x00, 0x00, 0x00, 0x2c, 'i',  'l',  'o',  'c',  // iloc
+      0x00, 0x00, 0x00, 0x00, 0x44, 0x00, 0x00, 0x02,  //
+      0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00,  // item 1
+      0x01, 0x10, 0x00, 0x00, 0x00, 0x32,              //
+      0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00,  // item 2
+      0x01, 0x42, 0x00, 0x00, 0x00, 0x0a,              //
+      0x00, 0x00, 0x00, 0x1a, 'i',  'r',  'e',  'f',  // iref
+      0x00, 0x00, 0x00, 0x00,                          //
+      0x00, 0x00, 0x00, 0x0e, 't',  'h',  'm',  'b',  // thmb
+      0x00, 0x02, 0x00, 0x01, 0x00, 0x01,              //
+      0x00, 0x00, 0x00, 0x38, 'i',  'p',  'r',  'p',  // iprp
+      0x00, 0x00, 0x00, 0x1c, 'i',  'p',  'c',  'o',  // ipco
+      0x00, 0x00, 0x00, 0x14, 'i',  's',  'p',  'e',  // ispe
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00,  //
+      0x00, 0x00, 0x01, 0x00,                          //
+      0x00, 0x00, 0x00, 0x14, 'i',  'p',  'm',  'a',  // ipma
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,  //
+      0x00, 0x01, 0x01, 0x81,                          //
+      0x00, 0x00, 0x00, 0x08, 'm',  'd',  'a',  't',  // mdat
+  };
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+
+  MuTFFMetaAtom meta;
+  err = mutff_read_heif_file(&ctx, &bytes, &meta);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, sizeof(data));
+  EXPECT_EQ(meta.handler_type, MuTFF_FOURCC('p', 'i', 'c', 't'));
+  ASSERT_EQ(meta.item_count, 2);
+  ASSERT_EQ(meta.property_count, 1);
+  EXPECT_EQ(meta.property[0].type, MuTFF_FOURCC('i', 's', 'p', 'e'));
+  EXPECT_EQ(meta.property[0].extent.offset, 217);
+  EXPECT_EQ(meta.property[0].extent.size, 20);
+
+  const MuTFFItem *primary;
+  err = mutff_meta_primary_item(&primary, &meta);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(primary->item_id, 1);
+  EXPECT_EQ(primary->item_type, MuTFF_FOURCC('h', 'v', 'c', '1'));
+  ASSERT_EQ(primary->property_count, 1);
+  EXPECT_EQ(primary->property[0].essential, true);
+  EXPECT_EQ(primary->property[0].index, 1);
+
+  MuTFFItemExtent extents[MuTFF_MAX_ITEM_EXTENTS];
+  err = mutff_meta_item_extents(extents, &meta, primary);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(primary->extent_count, 1);
+  EXPECT_EQ(extents[0].offset, 0x110);
+  EXPECT_EQ(extents[0].length, 0x32);
+
+  const MuTFFItem *thumbnail;
+  err = mutff_meta_item_thumbnail(&thumbnail, &meta, primary);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(thumbnail->item_id, 2);
+  err = mutff_meta_item_extents(extents, &meta, thumbnail);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(extents[0].offset, 0x142);
+  EXPECT_EQ(extents[0].length, 0x0a);
+
+  err = mutff_meta_item_thumbnail(&thumbnail, &meta, thumbnail);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+
+  // the items of other handlers are not images
+  memcpy(&data[44], "mdir", 4);
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+  err = mutff_read_heif_file(&ctx, &bytes, &meta);
+  EXPECT_EQ(err, MuTFFErrorBadFormat);
+}
+
+TEST(HEIF, ManyItems) {
+  // a grid of 20 tiles with five extents each, a thumbnail and Exif data,
+  // with the item locations first and the references last
+  unsigned char data[2048];
+  size_t len = 0;
+  const auto put = [&](uint32_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      data[len++] = value >> (8 * (size - 1 - i)) & 0xff;
+    }
+  };
+  const auto begin = [&](const char *type) {
+    const size_t start = len;
+    put(0, 4);
+    memcpy(&data[len], type, 4);
+    len += 4;
+    return start;
+  };
+  const auto end = [&](size_t start) {
+    const size_t size = len - start;
+    len = start;
+    put(size, 4);
+    len = start + size;
+  };
+  const uint16_t ids[] = {1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11,
+                          12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 30, 31};
+  const size_t meta = begin("meta");
+  put(0, 4);
+  const size_t hdlr = begin("hdlr");
+  put(0, 8);
+  put(MuTFF_FOURCC('p', 'i', 'c', 't'), 4);
+  put(0, 13);
+  end(hdlr);
+  const size_t pitm = begin("pitm");
+  put(0, 4);
+  put(1, 2);
+  end(pitm);
+  const size_t iloc = begin("iloc");
+  put(0, 4);
+  put(0x4400, 2);
+  put(sizeof(ids) / sizeof(ids[0]), 2);
+  for (const uint16_t id : ids) {
+    const size_t extent_count = id >= 2 && id <= 21 ? 5 : 1;
+    put(id, 2);
+    put(0, 2);
+    put(extent_count, 2);
+    for (size_t i = 0; i < extent_count; ++i) {
+      put(0x1000 * id + 0x10 * i, 4);
+      put(0x10, 4);
+    }
+  }
+  end(iloc);
+  const size_t iinf = begin("iinf");
+  put(0, 4);
+  put(sizeof(ids) / sizeof(ids[0]), 2);
+  for (const uint16_t id : ids) {
+    const size_t infe = begin("infe");
+    put(0x02000000, 4);
+    put(id, 2);
+    put(0, 2);
+    put(id == 1 ? MuTFF_FOURCC('g', 'r', 'i', 'd')
+                : MuTFF_FOURCC('h', 'v', 'c', '1'),
+        4);
+    put(0, 1);
+    end(infe);
+  }
+  end(iinf);
+  const size_t iprp = begin("iprp");
+  const size_t ipco = begin("ipco");
+  const size_t ispe = begin("ispe");
+  put(0, 12);
+  end(ispe);
+  end(ipco);
+  const size_t ipma = begin("ipma");
+  put(0, 4);
+  put(sizeof(ids) / sizeof(ids[0]), 4);
+  for (const uint16_t id : ids) {
+    put(id, 2);
+    put(1, 1);
+    put(0x81, 1);
+  }
+  end(ipma);
+  end(iprp);
+  const size_t iref = begin("iref");
+  put(0, 4);
+  const size_t dimg = begin("dimg");
+  put(1, 2);
+  put(20, 2);
+  for (uint16_t id = 2; id <= 21; ++id) {
+    put(id, 2);
+  }
+  end(dimg);
+  const size_t thmb = begin("thmb");
+  put(30, 2);
+  put(1, 2);
+  put(1, 2);
+  end(thmb);
+  const size_t cdsc = begin("cdsc");
+  put(31, 2);
+  put(1, 2);
+  put(1, 2);
+  end(cdsc);
+  end(iref);
+  end(meta);
+
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, len);
+  MuTFFMetaAtom out;
+  size_t bytes;
+  MuTFFError err = mutff_read_meta_atom(&ctx, &bytes, &out);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, len);
+  EXPECT_EQ(buf.pos, len);
+
+  // only the primary item and its thumbnail are stored
+  EXPECT_EQ(out.item_count, 2);
+  EXPECT_EQ(out.reference_count, 1);
+  const MuTFFItem *primary;
+  err = mutff_meta_primary_item(&primary, &out);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(primary->item_type, MuTFF_FOURCC('g', 'r', 'i', 'd'));
+  ASSERT_EQ(primary->extent_count, 1);
+  EXPECT_EQ(primary->extent[0].offset, 0x1000);
+  EXPECT_EQ(primary->property_count, 1);
+  const MuTFFItem *thumbnail;
+  err = mutff_meta_item_thumbnail(&thumbnail, &out, primary);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(thumbnail->item_id, 30);
+  EXPECT_EQ(thumbnail->item_type, MuTFF_FOURCC('h', 'v', 'c', '1'));
+  ASSERT_EQ(thumbnail->extent_count, 1);
+  EXPECT_EQ(thumbnail->extent[0].offset, 0x1e000);
+  EXPECT_EQ(thumbnail->property_count, 1);
+}
+// }}}2
+
+// {{{2 RTP hint unit tests
+TEST(RTPHint, SampleDescription) {
+  MuTFFError err;
+  size_t bytes;
+  unsigned char data[64];
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+
+  MuTFFSampleDescription in = {};
+  in.data_format = MuTFF_FOURCC('r', 't', 'p', ' ');
+  in.data_reference_index = 1;
+  in.data.hint.version = 1;
+  in.data.hint.last_compatible_version = 1;
+  in.data.hint.max_packet_size = 1450;
+  in.data.hint.time_scale_present = true;
+  in.data.hint.time_scale = 90000;
+  in.data.hint.sequence_offset_present = true;
+  in.data.hint.sequence_offset = -3;
+  err = mutff_write_sample_description(&ctx, &bytes, &in);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 48);
+
+  buf.size = buf.pos;
+  buf.pos = 0;
+  MuTFFSampleDescription out;
+  err = mutff_read_sample_description(&ctx, &bytes, &out);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 48);
+  EXPECT_EQ(out.data.hint.max_packet_size, 1450);
+  EXPECT_EQ(out.data.hint.time_scale_present, true);
+  EXPECT_EQ(out.data.hint.time_scale, 90000);
+  EXPECT_EQ(out.data.hint.time_offset_present, false);
+  EXPECT_EQ(out.data.hint.sequence_offset_present, true);
+  EXPECT_EQ(out.data.hint.sequence_offset, -3);
+}
+
+TEST(RTPHint, SampleDescriptionBounds) {
+  MuTFFError err;
+  size_t bytes;
+  // an unknown entry before 'tims', then what looks like a 'tsro' entry just
+  // past the end of the description
+  unsigned char data[] = {
+      0x00, 0x00, 0x00, 0x30, 'r',  't',  'p',  ' ',  0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x05, 0xaa,
+      0x00, 0x00, 0x00, 0x0c, 'x',  't',  'r',  'a',  0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x0c, 't',  'i',  'm',  's',  0x00, 0x01, 0x5f, 0x90,
+      0x00, 0x00, 0x00, 0x0c, 't',  's',  'r',  'o',  0x00, 0x00, 0x00, 0x07,
+  };
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+  MuTFFSampleDescription out;
+  err = mutff_read_sample_description(&ctx, &bytes, &out);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 48);
+  EXPECT_EQ(out.data.hint.time_scale_present, true);
+  EXPECT_EQ(out.data.hint.time_scale, 90000);
+  EXPECT_EQ(out.data.hint.time_offset_present, false);
+
+  // an entry running past the description
+  data[3] = 0x2c;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+  err = mutff_read_sample_description(&ctx, &bytes, &out);
+  EXPECT_EQ(err, MuTFFErrorBadFormat);
+
+  // a description running past the end of the file
+  data[3] = 0x3c;
+  mutff_memory_buffer_init(&buf, data, 48);
+  err = mutff_read_sample_description(&ctx, &bytes, &out);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+}
+// }}}2
+
+// {{{2 PCM unit tests
+TEST(PCM, SoundSampleDescription) {
+  MuTFFError err;
+  size_t bytes;
+  unsigned char data[96];
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+
+  MuTFFSampleDescription in = {};
+  in.data_format = MuTFF_FOURCC('i', 'n', '2', '4');
+  in.data_reference_index = 1;
+  in.data.sound.version = 1;
+  in.data.sound.number_of_channels = 2;
+  in.data.sound.sample_size = 16;
+  in.data.sound.compression_id = -2;
+  in.data.sound.sample_rate = {(int16_t)48000, 0};
+  in.data.sound.samples_per_packet = 1;
+  in.data.sound.bytes_per_packet = 3;
+  in.data.sound.bytes_per_frame = 6;
+  in.data.sound.bytes_per_sample = 3;
+  in.data.sound.little_endian = true;
+  err = mutff_write_sample_description(&ctx, &bytes, &in);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 70);
+
+  buf.size = buf.pos;
+  buf.pos = 0;
+  MuTFFSampleDescription out;
+  err = mutff_read_sample_description(&ctx, &bytes, &out);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 70);
+  EXPECT_EQ(out.data.sound.version, 1);
+  EXPECT_EQ(out.data.sound.number_of_channels, 2);
+  EXPECT_EQ((uint16_t)out.data.sound.sample_rate.integral, 48000);
+  EXPECT_EQ(out.data.sound.bytes_per_frame, 6);
+  EXPECT_EQ(out.data.sound.little_endian, true);
+
+  MuTFFPCMFormat format;
+  err = mutff_pcm_format(&format, &out);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(format.floating_point, false);
+  EXPECT_EQ(format.big_endian, false);
+  EXPECT_EQ(format.bytes_per_sample, 3);
+  EXPECT_EQ(format.channels, 2);
+
+  // only a 'wave' atom directly in the description is entered
+  const unsigned char wave[] = {0x00, 0x00, 0x00, 0x1a, 'w', 'a', 'v', 'e'};
+  memmove(&data[60], &data[52], 18);
+  memcpy(&data[52], wave, sizeof(wave));
+  data[3] = 78;
+  mutff_memory_buffer_init(&buf, data, 78);
+  err = mutff_read_sample_description(&ctx, &bytes, &out);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 78);
+  EXPECT_EQ(out.data.sound.little_endian, false);
+}
+
+TEST(PCM, Peaks) {
+  MuTFFError err;
+  unsigned char data[] = {
+      0x40, 0x00, 0xc0, 0x00,  // chunk 1
+      0x00, 0x00, 0x00, 0x00,  //
+      0x20, 0x00, 0x20, 0x00,  // chunk 2
+      0x80, 0x00, 0x00, 0x00,  //
+      0x7f, 0x7f, 0x7f, 0x7f,  // not sound
+      0x00, 0x00, 0x00, 0x00,  // chunk 3
+      0x40, 0x00, 0x40, 0x00,  //
+  };
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+
+  // 16-bit big-endian stereo, two frames per chunk
+  MuTFFSampleTableAtom sample_table = {};
+  sample_table.sample_description.number_of_entries = 1;
+  MuTFFSampleDescription *desc =
+      &sample_table.sample_description.sample_description_table[0];
+  desc->data_format = MuTFF_FOURCC('t', 'w', 'o', 's');
+  desc->data.sound.number_of_channels = 2;
+  desc->data.sound.sample_size = 16;
+  sample_table.sample_to_chunk_present = true;
+  sample_table.sample_to_chunk.number_of_entries = 1;
+  sample_table.sample_to_chunk.sample_to_chunk_table[0] = {1, 2, 1};
+  sample_table.chunk_offset_present = true;
+  sample_table.chunk_offset.number_of_entries = 3;
+  sample_table.chunk_offset.chunk_offset_table[0] = 0;
+  sample_table.chunk_offset.chunk_offset_table[1] = 8;
+  sample_table.chunk_offset.chunk_offset_table[2] = 20;
+
+  MuTFFPCMPeak peaks[2];
+  size_t count;
+  unsigned char work[8];
+  err = mutff_pcm_peaks(&ctx, peaks, &count, 2, &sample_table, 3, work,
+                        sizeof(work));
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(count, 2);
+  EXPECT_FLOAT_EQ(peaks[0].min, -0.5F);
+  EXPECT_FLOAT_EQ(peaks[0].max, 0.5F);
+  EXPECT_NEAR(peaks[0].rms, 0.3227486, 1e-6);
+  EXPECT_FLOAT_EQ(peaks[1].min, -1.0F);
+  EXPECT_FLOAT_EQ(peaks[1].max, 0.5F);
+  EXPECT_FLOAT_EQ(peaks[1].rms, 0.5F);
+
+  err = mutff_pcm_peaks(&ctx, peaks, &count, 1, &sample_table, 3, work,
+                        sizeof(work));
+  EXPECT_EQ(err, MuTFFErrorOutOfMemory);
+}
+
+TEST(PCM, ReadFloat) {
+  MuTFFError err;
+  unsigned char data[] = {
+      0x40, 0x00, 0xc0, 0x00,  // chunk 1
+      0x00, 0x00, 0x00, 0x00,  //
+      0x7f, 0x7f, 0x7f, 0x7f,  // not sound
+      0x20, 0x00, 0x20, 0x00,  // chunk 2
+      0x80, 0x00, 0x00, 0x00,  //
+      0x00, 0x00, 0x00, 0x00,  //
+  };
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+
+  // 16-bit little-endian stereo, with two then three frames per chunk
+  MuTFFSampleTableAtom sample_table = {};
+  sample_table.sample_description.number_of_entries = 1;
+  MuTFFSampleDescription *desc =
+      &sample_table.sample_description.sample_description_table[0];
+  desc->data_format = MuTFF_FOURCC('s', 'o', 'w', 't');
+  desc->data.sound.number_of_channels = 2;
+  desc->data.sound.sample_size = 16;
+  sample_table.sample_to_chunk_present = true;
+  sample_table.sample_to_chunk.number_of_entries = 2;
+  sample_table.sample_to_chunk.sample_to_chunk_table[0] = {1, 2, 1};
+  sample_table.sample_to_chunk.sample_to_chunk_table[1] = {2, 3, 1};
+  sample_table.chunk_offset_present = true;
+  sample_table.chunk_offset.number_of_entries = 2;
+  sample_table.chunk_offset.chunk_offset_table[0] = 0;
+  sample_table.chunk_offset.chunk_offset_table[1] = 12;
+
+  MuTFFPCMReader reader;
+  err = mutff_pcm_reader_init(&reader, &sample_table);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  float out[8];
+  size_t frames;
+  unsigned char work[16];
+  err = mutff_pcm_read_float(&ctx, &frames, out, 3, &reader, work,
+                             sizeof(work));
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(frames, 3);
+  EXPECT_EQ(reader.format.big_endian, false);
+  const float first[] = {64, 192, 0, 0, 32, 32};
+  for (size_t i = 0; i < 6; ++i) {
+    EXPECT_FLOAT_EQ(out[i], first[i] / 32768.0F);
+  }
+  err = mutff_pcm_read_float(&ctx, &frames, out, 4, &reader, work,
+                             sizeof(work));
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(frames, 2);
+  EXPECT_FLOAT_EQ(out[0], 128.0F / 32768.0F);
+  EXPECT_FLOAT_EQ(out[1], 0.0F);
+  err = mutff_pcm_read_float(&ctx, &frames, out, 4, &reader, work,
+                             sizeof(work));
+  EXPECT_EQ(err, MuTFFErrorEOF);
+
+  // the same frames, one plane per channel
+  float left[5];
+  float right[5];
+  float *const planes[] = {left, right};
+  err = mutff_pcm_reader_init(&reader, &sample_table);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_pcm_read_float_planar(&ctx, &frames, planes, 5, &reader, work,
+                                    sizeof(work));
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(frames, 5);
+  EXPECT_FLOAT_EQ(left[0], 64.0F / 32768.0F);
+  EXPECT_FLOAT_EQ(right[0], 192.0F / 32768.0F);
+  EXPECT_FLOAT_EQ(left[2], 32.0F / 32768.0F);
+  EXPECT_FLOAT_EQ(left[3], 128.0F / 32768.0F);
+  EXPECT_FLOAT_EQ(right[4], 0.0F);
+
+  // big-endian and little-endian floats
+  const MuTFFPCMFormat be = {true, true, 4, 1};
+  const MuTFFPCMFormat le = {true, false, 4, 1};
+  const unsigned char half[] = {0x3f, 0x00, 0x00, 0x00,
+                                 0x00, 0x00, 0x00, 0x3f};
+  mutff_pcm_to_float(out, half, 1, &be);
+  EXPECT_FLOAT_EQ(out[0], 0.5F);
+  mutff_pcm_to_float(out, &half[4], 1, &le);
+  EXPECT_FLOAT_EQ(out[0], 0.5F);
+}
+// }}}2
+
+// {{{2 frame view unit tests
+TEST(FrameView, Padded) {
+  MuTFFError err;
+  unsigned char data[48] = {};
+  MuTFFMemoryBuffer buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+
+  // a 3x2 '2vuy' frame, with rows padded from 8 to 12 bytes
+  MuTFFSampleTableAtom sample_table = {};
+  sample_table.sample_description.number_of_entries = 1;
+  MuTFFSampleDescription *desc =
+      &sample_table.sample_description.sample_description_table[0];
+  desc->data_format = MuTFF_FOURCC('2', 'v', 'u', 'y');
+  desc->data.video.width = 3;
+  desc->data.video.height = 2;
+  sample_table.time_to_sample.number_of_entries = 1;
+  sample_table.time_to_sample.time_to_sample_table[0] = {2, 1};
+  sample_table.sample_to_chunk_present = true;
+  sample_table.sample_to_chunk.number_of_entries = 1;
+  sample_table.sample_to_chunk.sample_to_chunk_table[0] = {1, 2, 1};
+  sample_table.sample_size_present = true;
+  sample_table.sample_size.sample_size = 24;
+  sample_table.sample_size.number_of_entries = 2;
+  sample_table.chunk_offset_present = true;
+  sample_table.chunk_offset.number_of_entries = 1;
+  sample_table.chunk_offset.chunk_offset_table[0] = 0;
+
+  MuTFFFrameView view;
+  err = mutff_frame_view(&view, &buf, &sample_table, 1);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(view.data, &data[24]);
+  EXPECT_EQ(view.width, 3);
+  EXPECT_EQ(view.height, 2);
+  EXPECT_EQ(view.pixel_format, MuTFFPixelFormatCbYCrY);
+  EXPECT_EQ(view.stride, 12);
+  EXPECT_EQ(buf.pos, 0);
+
+  // or every frame in turn
+  MuTFFSampleCursor cursor;
+  err = mutff_sample_cursor_init(&cursor, &sample_table, 0);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  for (size_t i = 0; i < 2; ++i) {
+    err = mutff_frame_view_next(&view, &buf, &cursor);
+    ASSERT_EQ(err, MuTFFErrorNone);
+    EXPECT_EQ(view.data, &data[i * 24]);
+  }
+  err = mutff_frame_view_next(&view, &buf, &cursor);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+
+  // the second frame runs past the end of the buffer
+  buf.size = 40;
+  err = mutff_frame_view(&view, &buf, &sample_table, 1);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+
+  // rows shorter than the pixel data
+  sample_table.sample_size.sample_size = 14;
+  err = mutff_frame_view(&view, &buf, &sample_table, 0);
+  EXPECT_EQ(err, MuTFFErrorBadFormat);
+
+  size_t row_size;
+  MuTFFPixelFormat format;
+  desc->data_format = MuTFF_FOURCC('v', '2', '1', '0');
+  desc->data.video.width = 1920;
+  err = mutff_video_pixel_format(&format, &row_size, desc);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(format, MuTFFPixelFormatV210);
+  EXPECT_EQ(row_size, 5120);
+  desc->data.video.width = 1280;
+  err = mutff_video_pixel_format(&format, &row_size, desc);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(row_size, 3424);
+
+  // v210 rows must be padded to 128 bytes
+  desc->data.video.width = 7;
+  sample_table.sample_size.sample_size = 2 * 32;
+  err = mutff_frame_view(&view, &buf, &sample_table, 0);
+  EXPECT_EQ(err, MuTFFErrorBadFormat);
+  sample_table.sample_size.sample_size = 2 * 128;
+  err = mutff_frame_view(&view, &buf, &sample_table, 0);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+  desc->data_format = MuTFF_FOURCC('j', 'p', 'e', 'g');
+  err = mutff_video_pixel_format(&format, &row_size, desc);
+  EXPECT_EQ(err, MuTFFErrorBadFormat);
+}
+// }}}2
+
+// {{{2 query unit tests
+TEST(Query, PipelinedRequests) {
+  MuTFFError err;
+  size_t bytes;
+  unsigned char data[256];
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+
+  MuTFFQueryRequest a = {MuTFF_QUERY_BYTE_RANGE, 1, 0, 0x0123456789, 8,
+                         "test.mov"};
+  MuTFFQueryRequest b = {MuTFF_QUERY_SYNC_SAMPLES, 2, 3, 4, 1, "a"};
+  err = mutff_write_query_request(&ctx, &bytes, &a);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 32);
+  err = mutff_write_query_request(&ctx, &bytes, &b);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 25);
+  EXPECT_EQ(data[0], 0);
+  EXPECT_EQ(data[3], 32);
+  EXPECT_EQ(data[4], 't');
+
+  mutff_memory_buffer_init(&buf, data, 57);
+  MuTFFQueryRequest request;
+  err = mutff_read_query_request(&ctx, &bytes, &request);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 32);
+  EXPECT_EQ(request.type, a.type);
+  EXPECT_EQ(request.request_id, a.request_id);
+  EXPECT_EQ(request.track, a.track);
+  EXPECT_EQ(request.argument, a.argument);
+  ASSERT_EQ(request.name_length, a.name_length);
+  EXPECT_EQ(memcmp(request.name, a.name, a.name_length), 0);
+  err = mutff_read_query_request(&ctx, &bytes, &request);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 25);
+  EXPECT_EQ(request.type, b.type);
+  EXPECT_EQ(request.request_id, b.request_id);
+  EXPECT_EQ(request.track, b.track);
+  EXPECT_EQ(request.argument, b.argument);
+  err = mutff_read_query_request(&ctx, &bytes, &request);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+}
+
+TEST(Query, Response) {
+  MuTFFError err;
+  size_t bytes;
+  unsigned char data[512];
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+
+  MuTFFQueryResponse in;
+  in.type = MuTFF_QUERY_SYNC_SAMPLES;
+  in.request_id = 7;
+  in.status = MuTFFErrorNone;
+  in.data.sync_samples.next = 9;
+  in.data.sync_samples.sample_count = 2;
+  in.data.sync_samples.sample[0] = {0, 0, 36};
+  in.data.sync_samples.sample[1] = {8, 0x100000000, 0x200000000};
+  err = mutff_write_query_response(&ctx, &bytes, &in);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 16 + 8 + 2 * 20);
+
+  MuTFFQueryResponse failed;
+  failed.type = MuTFF_QUERY_BYTE_RANGE;
+  failed.request_id = 8;
+  failed.status = MuTFFErrorEOF;
+  err = mutff_write_query_response(&ctx, &bytes, &failed);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 16);
+
+  mutff_memory_buffer_init(&buf, data, buf.pos);
+  MuTFFQueryResponse out;
+  err = mutff_read_query_response(&ctx, &bytes, &out);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(out.type, in.type);
+  EXPECT_EQ(out.request_id, in.request_id);
+  EXPECT_EQ(out.status, MuTFFErrorNone);
+  EXPECT_EQ(out.data.sync_samples.next, 9);
+  ASSERT_EQ(out.data.sync_samples.sample_count, 2);
+  EXPECT_EQ(out.data.sync_samples.sample[1].sample, 8);
+  EXPECT_EQ(out.data.sync_samples.sample[1].decode_time, 0x100000000);
+  EXPECT_EQ(out.data.sync_samples.sample[1].offset, 0x200000000);
+  err = mutff_read_query_response(&ctx, &bytes, &out);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(out.request_id, 8);
+  EXPECT_EQ(out.status, MuTFFErrorEOF);
+}
+// }}}2
 // }}}1
 
 // {{{1 test.mov tests
@@ -5546,6 +6605,67 @@ TEST_F(TestMov, MovieFile) {
 }
 // }}}2
 
+// {{{2 MovieFileTail
+TEST_F(TestMov, MovieFileTail) {
+  static unsigned char data[29036];
+  ASSERT_EQ(fread(data, sizeof(data), 1, (FILE *)ctx.file), 1);
+
+  MuTFFMovieFile movie_file;
+  MuTFFMovieFileTail tail;
+  MuTFFMemoryBuffer buf;
+  MuTFFContext mem_ctx;
+  mem_ctx.io = mutff_memory_driver;
+  mem_ctx.file = &buf;
+  size_t bytes;
+  MuTFFError err;
+  mutff_init_movie_file_tail(&tail, &movie_file);
+
+  // part of the file type atom
+  mutff_memory_buffer_init(&buf, data, 10);
+  err = mutff_read_movie_file_tail(&mem_ctx, &bytes, &tail, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 0);
+  EXPECT_EQ(tail.offset, 0);
+
+  // file type and wide atoms, part of the movie data atom
+  mutff_memory_buffer_init(&buf, data, 128);
+  err = mutff_read_movie_file_tail(&mem_ctx, &bytes, &tail, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 28);
+  EXPECT_EQ(tail.offset, 28);
+  EXPECT_EQ(movie_file.file_type_present, true);
+  EXPECT_EQ(movie_file.wide_count, 1);
+  EXPECT_EQ(movie_file.movie_data_count, 0);
+
+  // everything but the last byte of the movie atom
+  mutff_memory_buffer_init(&buf, data, sizeof(data) - 1);
+  err = mutff_read_movie_file_tail(&mem_ctx, &bytes, &tail, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 28302);
+  EXPECT_EQ(tail.offset, 28330);
+  EXPECT_EQ(movie_file.movie_data_count, 1);
+  EXPECT_EQ(tail.movie_present, false);
+
+  // the whole file, read from an arbitrary position
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+  buf.pos = 1000;
+  err = mutff_read_movie_file_tail(&mem_ctx, &bytes, &tail, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 706);
+  EXPECT_EQ(tail.offset, sizeof(data));
+  EXPECT_EQ(tail.movie_present, true);
+  EXPECT_EQ(movie_file.movie.track_count, 1);
+  EXPECT_EQ(movie_file.file_type_present, true);
+  EXPECT_EQ(movie_file.movie_data_count, 1);
+  EXPECT_EQ(movie_file.wide_count, 1);
+
+  // nothing new
+  err = mutff_read_movie_file_tail(&mem_ctx, &bytes, &tail, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 0);
+}
+// }}}2
+
 // {{{2 MovieAtom
 TEST_F(TestMov, MovieAtom) {
   const size_t offset = 28330;
@@ -5937,6 +7057,1064 @@ TEST_F(TestMov, SampleSize) {
   EXPECT_EQ(ftell((FILE *)ctx.file), offset + 20);
 }
 // }}}2
+
+// {{{2 Sample
+TEST_F(TestMov, Sample) {
+  MuTFFMovieFile movie_file;
+  size_t bytes;
+  MuTFFError err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  const MuTFFSampleTableAtom *sample_table;
+  err = mutff_media_atom_sample_table(&sample_table,
+                                      &movie_file.movie.track[0].media);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  uint32_t sample_count;
+  err = mutff_sample_table_sample_count(&sample_count, sample_table);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(sample_count, 14);
+
+  MuTFFSample sample;
+  for (uint32_t i = 0; i < sample_count; ++i) {
+    err = mutff_sample_table_sample(&sample, sample_table, i);
+    ASSERT_EQ(err, MuTFFErrorNone);
+    EXPECT_EQ(sample.offset, 36 + i * 0x07e5);
+    EXPECT_EQ(sample.size, 0x07e5);
+    EXPECT_EQ(sample.decode_time, i * 1024);
+    EXPECT_EQ(sample.duration, 1024);
+    EXPECT_EQ(sample.sample_description_id, 1);
+    EXPECT_EQ(sample.sync, true);
+  }
+  err = mutff_sample_table_sample(&sample, sample_table, sample_count);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+
+  // a cursor visits the same samples as lookups, over chunks of varying size
+  MuTFFSampleTableAtom stbl = *sample_table;
+  stbl.sample_to_chunk.number_of_entries = 2;
+  stbl.sample_to_chunk.sample_to_chunk_table[0] = {1, 3, 1};
+  stbl.sample_to_chunk.sample_to_chunk_table[1] = {3, 4, 1};
+  stbl.chunk_offset.number_of_entries = 4;
+  for (uint32_t i = 0; i < 4; ++i) {
+    stbl.chunk_offset.chunk_offset_table[i] = 100000 * (i + 1);
+  }
+  stbl.time_to_sample.number_of_entries = 2;
+  stbl.time_to_sample.time_to_sample_table[0] = {4, 1000};
+  stbl.time_to_sample.time_to_sample_table[1] = {10, 1024};
+  stbl.composition_offset_present = true;
+  stbl.composition_offset.entry_count = 2;
+  stbl.composition_offset.composition_offset_table[0] = {5, 2048};
+  stbl.composition_offset.composition_offset_table[1] = {9, 0};
+  stbl.sync_sample_present = true;
+  stbl.sync_sample.number_of_entries = 3;
+  stbl.sync_sample.sync_sample_table[0] = 1;
+  stbl.sync_sample.sync_sample_table[1] = 6;
+  stbl.sync_sample.sync_sample_table[2] = 11;
+  MuTFFSampleCursor cursor;
+  MuTFFSample visited;
+  err = mutff_sample_cursor_init(&cursor, &stbl, 0);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  for (uint32_t i = 0; i < sample_count; ++i) {
+    err = mutff_sample_cursor_next(&visited, &cursor);
+    ASSERT_EQ(err, MuTFFErrorNone);
+    err = mutff_sample_table_sample(&sample, &stbl, i);
+    ASSERT_EQ(err, MuTFFErrorNone);
+    EXPECT_EQ(visited.offset, sample.offset);
+    EXPECT_EQ(visited.decode_time, sample.decode_time);
+    EXPECT_EQ(visited.duration, sample.duration);
+    EXPECT_EQ(visited.composition_offset, sample.composition_offset);
+    EXPECT_EQ(visited.sync, sample.sync);
+  }
+  err = mutff_sample_cursor_next(&visited, &cursor);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+  err = mutff_sample_table_sample(&sample, &stbl, 7);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(sample.offset, 300000 + 0x7e5);
+  EXPECT_EQ(sample.decode_time, 4000 + 3 * 1024);
+  EXPECT_EQ(sample.composition_offset, 0);
+  EXPECT_FALSE(sample.sync);
+  err = mutff_sample_table_sample(&sample, &stbl, 5);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(sample.offset, 200000 + 2 * 0x7e5);
+  EXPECT_TRUE(sample.sync);
+  err = mutff_sample_table_sample(&sample, &stbl, 4);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(sample.composition_offset, 2048);
+}
+// }}}2
+
+// {{{2 SamplePartition
+TEST_F(TestMov, SamplePartition) {
+  MuTFFMovieFile movie_file;
+  size_t bytes;
+  MuTFFError err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  const MuTFFSampleTableAtom *sample_table;
+  err = mutff_media_atom_sample_table(&sample_table,
+                                      &movie_file.movie.track[0].media);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  uint32_t runs[5];
+  err = mutff_sample_table_partition(runs, 4, sample_table);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  const uint32_t expected[] = {0, 4, 7, 11, 14};
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(runs[i], expected[i]);
+  }
+
+  // more runs than samples
+  uint32_t many[21];
+  err = mutff_sample_table_partition(many, 20, sample_table);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(many[0], 0);
+  EXPECT_EQ(many[20], 14);
+  for (size_t i = 0; i < 20; ++i) {
+    EXPECT_LE(many[i], many[i + 1]);
+    EXPECT_LE(many[i + 1] - many[i], 1);
+  }
+}
+// }}}2
+
+// {{{2 SampleSplit
+TEST_F(TestMov, SampleSplit) {
+  MuTFFMovieFile movie_file;
+  size_t bytes;
+  MuTFFError err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  const MuTFFSampleTableAtom *sample_table;
+  err = mutff_media_atom_sample_table(&sample_table,
+                                      &movie_file.movie.track[0].media);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  MuTFFSampleTableAtom *mutable_sample_table;
+  err = mutff_media_atom_mutable_sample_table(
+      &mutable_sample_table, &movie_file.movie.track[0].media);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(mutable_sample_table, sample_table);
+
+  // cuts are deferred to the next sync sample
+  MuTFFSampleTableAtom stbl = *sample_table;
+  stbl.sync_sample_present = true;
+  stbl.sync_sample.number_of_entries = 3;
+  stbl.sync_sample.sync_sample_table[0] = 1;
+  stbl.sync_sample.sync_sample_table[1] = 6;
+  stbl.sync_sample.sync_sample_table[2] = 11;
+  uint32_t runs[5];
+  err = mutff_sample_table_split(runs, 4, &stbl);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  const uint32_t expected[] = {0, 5, 10, 14, 14};
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(runs[i], expected[i]);
+  }
+
+  MuTFFSampleTableAtom trimmed;
+  err = mutff_sample_table_trim(&trimmed, &stbl, 5, 5, 28);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(trimmed.sample_size.number_of_entries, 5);
+  ASSERT_EQ(trimmed.time_to_sample.number_of_entries, 1);
+  EXPECT_EQ(trimmed.time_to_sample.time_to_sample_table[0].sample_count, 5);
+  EXPECT_EQ(trimmed.time_to_sample.time_to_sample_table[0].sample_duration,
+            1024);
+  ASSERT_EQ(trimmed.sync_sample.number_of_entries, 1);
+  EXPECT_EQ(trimmed.sync_sample.sync_sample_table[0], 1);
+  ASSERT_EQ(trimmed.chunk_offset.number_of_entries, 1);
+  EXPECT_EQ(trimmed.chunk_offset.chunk_offset_table[0], 28);
+  ASSERT_EQ(trimmed.sample_to_chunk.number_of_entries, 1);
+  EXPECT_EQ(trimmed.sample_to_chunk.sample_to_chunk_table[0].first_chunk, 1);
+  EXPECT_EQ(
+      trimmed.sample_to_chunk.sample_to_chunk_table[0].samples_per_chunk, 5);
+
+  MuTFFSample sample;
+  err = mutff_sample_table_sample(&sample, &trimmed, 4);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(sample.offset, 28 + 4 * 0x7e5);
+  EXPECT_EQ(sample.decode_time, 4 * 1024);
+  EXPECT_FALSE(sample.sync);
+
+  err = mutff_sample_table_trim(&trimmed, &stbl, 10, 5, 28);
+  EXPECT_EQ(err, MuTFFErrorBadFormat);
+}
+// }}}2
+
+// {{{2 SampleIndex
+TEST_F(TestMov, SampleIndex) {
+  MuTFFMovieFile movie_file;
+  size_t bytes;
+  MuTFFError err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  uint64_t size;
+  err = mutff_sample_index_size(&size, &movie_file.movie);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(size, sizeof(MuTFFSampleIndex) + 14 * sizeof(MuTFFSampleIndexEntry));
+
+  uint64_t data[size / sizeof(uint64_t)];
+  err = mutff_build_sample_index(data, size - 1, &movie_file.movie);
+  EXPECT_EQ(err, MuTFFErrorOutOfMemory);
+  err = mutff_build_sample_index(data, size, &movie_file.movie);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  // the index is only accessed through offsets, so it may be moved
+  uint64_t copy[size / sizeof(uint64_t)];
+  memcpy(copy, data, size);
+  memset(data, 0, size);
+  const MuTFFSampleIndex *index = (const MuTFFSampleIndex *)copy;
+  err = mutff_check_sample_index(index, size);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(index->time_scale, 1000);
+  EXPECT_EQ(index->track_count, 1);
+  EXPECT_EQ(index->track[0].handler_type, MuTFF_FOURCC('v', 'i', 'd', 'e'));
+  EXPECT_EQ(index->track[0].time_scale, 0x3000);
+  EXPECT_EQ(index->track[0].sample_count, 14);
+
+  const MuTFFSampleIndexEntry *entry;
+  err = mutff_sample_index_entry(&entry, index, 0, 5);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(entry->offset, 36 + 5 * 0x07e5);
+  EXPECT_EQ(entry->size, 0x07e5);
+  EXPECT_EQ(entry->decode_time, 5 * 1024);
+  EXPECT_EQ(entry->flags, MuTFF_SAMPLE_INDEX_SYNC);
+  err = mutff_sample_index_entry(&entry, index, 0, 14);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+
+  copy[0] = 0;
+  err = mutff_check_sample_index(index, size);
+  EXPECT_EQ(err, MuTFFErrorBadFormat);
+}
+// }}}2
+
+// {{{2 Query
+TEST_F(TestMov, Query) {
+  MuTFFMovieFile movie_file;
+  size_t bytes;
+  MuTFFError err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  uint64_t size;
+  err = mutff_sample_index_size(&size, &movie_file.movie);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  uint64_t data[size / sizeof(uint64_t)];
+  err = mutff_build_sample_index(data, size, &movie_file.movie);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  const MuTFFSampleIndex *index = (const MuTFFSampleIndex *)data;
+
+  MuTFFQueryRequest request = {MuTFF_QUERY_TRACK_SUMMARY, 1, 0, 0, 0, ""};
+  MuTFFQueryResponse response;
+  mutff_answer_query(&response, index, &request);
+  ASSERT_EQ(response.status, MuTFFErrorNone);
+  EXPECT_EQ(response.request_id, 1);
+  EXPECT_EQ(response.data.track_summary.time_scale, 0x3000);
+  EXPECT_EQ(response.data.track_summary.sample_count, 14);
+
+  request.type = MuTFF_QUERY_BYTE_RANGE;
+  request.argument = 3 * 1024 + 10;
+  mutff_answer_query(&response, index, &request);
+  ASSERT_EQ(response.status, MuTFFErrorNone);
+  EXPECT_EQ(response.data.byte_range.sample, 3);
+  EXPECT_EQ(response.data.byte_range.sync_sample, 3);
+  EXPECT_EQ(response.data.byte_range.offset, 36 + 3 * 0x07e5);
+  EXPECT_EQ(response.data.byte_range.size, 0x07e5);
+  request.argument = 14 * 1024;
+  mutff_answer_query(&response, index, &request);
+  EXPECT_EQ(response.status, MuTFFErrorEOF);
+
+  request.type = MuTFF_QUERY_SYNC_SAMPLES;
+  request.argument = 0;
+  mutff_answer_query(&response, index, &request);
+  ASSERT_EQ(response.status, MuTFFErrorNone);
+  EXPECT_EQ(response.data.sync_samples.sample_count, 14);
+  EXPECT_EQ(response.data.sync_samples.next, 14);
+  EXPECT_EQ(response.data.sync_samples.sample[13].sample, 13);
+
+  request.track = 1;
+  mutff_answer_query(&response, index, &request);
+  EXPECT_EQ(response.status, MuTFFErrorBadFormat);
+}
+// }}}2
+
+// {{{2 MovieSummary
+TEST_F(TestMov, MovieSummary) {
+  MuTFFMovieSummary summary;
+  size_t bytes;
+  const MuTFFError err = mutff_read_movie_summary(&ctx, &bytes, &summary);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 29036);
+
+  EXPECT_EQ(summary.major_brand, MuTFF_FOURCC('q', 't', ' ', ' '));
+  EXPECT_EQ(summary.minor_version, 0x00000200);
+  EXPECT_EQ(summary.compatible_brands_count, 1);
+  EXPECT_EQ(summary.compatible_brands[0], MuTFF_FOURCC('q', 't', ' ', ' '));
+  EXPECT_EQ(summary.dialect, MuTFFDialectQuickTime);
+  EXPECT_EQ(summary.time_scale, 1000);
+
+  ASSERT_EQ(summary.track_count, 1);
+  const MuTFFTrackSummary *track = &summary.track[0];
+  EXPECT_EQ(track->track_id, 1);
+  EXPECT_EQ(track->handler_type, MuTFF_FOURCC('v', 'i', 'd', 'e'));
+  EXPECT_EQ(track->codec, MuTFF_FOURCC('j', 'p', 'e', 'g'));
+  EXPECT_EQ(track->width, 640);
+  EXPECT_EQ(track->height, 480);
+  EXPECT_EQ(track->time_scale, 0x3000);
+  EXPECT_EQ(track->duration, 0x3800);
+  EXPECT_EQ(track->sample_count, 14);
+}
+// }}}2
+
+// {{{2 RTPPacket
+TEST_F(TestMov, RTPPacket) {
+  MuTFFError err;
+  size_t bytes;
+  MuTFFMovieFile movie_file;
+  err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  const MuTFFSampleTableAtom *video;
+  err = mutff_media_atom_sample_table(&video, &movie_file.movie.track[0].media);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  // a hint track with the video track as its only reference
+  MuTFFHintSampleDescription description = {};
+  description.time_offset_present = true;
+  description.time_offset = 1000;
+  description.sequence_offset_present = true;
+  description.sequence_offset = 100;
+  MuTFFHintTrack track;
+  track.sample_table = NULL;
+  track.description = &description;
+  track.reference_count = 1;
+  track.reference[0] = video;
+
+  unsigned char sample_data[] = {
+      0x00, 0x01, 0x00, 0x00,  // packet count, reserved
+      0x00, 0x00, 0x00, 0x0a,  // relative time
+      0x00, 0xe0, 0x00, 0x05,  // marker, payload type, sequence number
+      0x00, 0x00, 0x00, 0x02,  // flags, entry count
+      0x01, 0x02, 0xaa, 0xbb, 0x00, 0x00, 0x00, 0x00,  // immediate
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  //
+      0x02, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x02,  // sample
+      0x00, 0x00, 0x00, 0x04, 0x00, 0x01, 0x00, 0x01,  //
+  };
+  MuTFFMemoryBuffer buf;
+  MuTFFContext sample_ctx = {mutff_memory_driver, &buf};
+  mutff_memory_buffer_init(&buf, sample_data, sizeof(sample_data));
+  MuTFFRTPHintSample sample;
+  err = mutff_read_rtp_hint_sample(&sample_ctx, &bytes, &sample);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, sizeof(sample_data));
+  ASSERT_EQ(sample.packet_count, 1);
+  const MuTFFRTPPacket *packet = &sample.packet[0];
+  EXPECT_EQ(packet->marker, true);
+  EXPECT_EQ(packet->payload_type, 96);
+  ASSERT_EQ(packet->constructor_count, 2);
+
+  MuTFFRTPSegment segments[MuTFF_MAX_RTP_CONSTRUCTORS];
+  size_t segment_count;
+  err = mutff_rtp_packet_segments(segments, &segment_count, &track, packet);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(segment_count, 2);
+  EXPECT_EQ(segments[0].data, packet->constructor[0].data);
+  EXPECT_EQ(segments[0].length, 2);
+  EXPECT_EQ(segments[1].data, nullptr);
+  EXPECT_EQ(segments[1].offset, 36 + 0x07e5 + 4);
+  EXPECT_EQ(segments[1].length, 16);
+
+  unsigned char out[64];
+  err = mutff_write_rtp_packet(&ctx, &bytes, out, sizeof(out), &track, packet,
+                               2048, 0x01020304);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 12 + 2 + 16);
+  const unsigned char header[] = {0x80, 0xe0, 0x00, 0x69, 0x00, 0x00,
+                                  0x0b, 0xf2, 0x01, 0x02, 0x03, 0x04};
+  EXPECT_EQ(memcmp(out, header, sizeof(header)), 0);
+  EXPECT_EQ(out[12], 0xaa);
+  EXPECT_EQ(out[13], 0xbb);
+  unsigned char media[16];
+  fseek((FILE *)ctx.file, 36 + 0x07e5 + 4, SEEK_SET);
+  ASSERT_EQ(fread(media, sizeof(media), 1, (FILE *)ctx.file), 1);
+  EXPECT_EQ(memcmp(&out[14], media, sizeof(media)), 0);
+
+  err = mutff_write_rtp_packet(&ctx, &bytes, out, 29, &track, packet, 2048,
+                               0x01020304);
+  EXPECT_EQ(err, MuTFFErrorOutOfMemory);
+}
+// }}}2
+
+// {{{2 SyncAlignment
+TEST_F(TestMov, SyncAlignment) {
+  MuTFFError err;
+  size_t bytes;
+  MuTFFMovieFile movie_file;
+  err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  // every sample of test.mov is a sync sample
+  MuTFFSyncTimeIterator its[2];
+  int64_t time;
+  err = mutff_sync_time_iterator_init(&its[0], &movie_file.movie, 0, 0x3000);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  for (int i = 0; i < 14; ++i) {
+    err = mutff_sync_time_next(&time, &its[0]);
+    ASSERT_EQ(err, MuTFFErrorNone);
+    EXPECT_EQ(time, i * 1024);
+  }
+  err = mutff_sync_time_next(&time, &its[0]);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+
+  MuTFFSyncAlignment alignment;
+  size_t heap[3];
+  for (size_t i = 0; i < 2; ++i) {
+    err = mutff_sync_time_iterator_init(&its[i], &movie_file.movie, 0, 0x3000);
+    ASSERT_EQ(err, MuTFFErrorNone);
+  }
+  err = mutff_check_sync_alignment(&alignment, its, 2, 0, heap);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(alignment.aligned_count, 14);
+  EXPECT_EQ(alignment.misalignment_count, 0);
+
+  // a rendition with a sync sample every fourth sample
+  MuTFFMovieFile gop_file = movie_file;
+  MuTFFSampleTableAtom *sample_table =
+      &gop_file.movie.track[0].media.video_media_information.sample_table;
+  sample_table->sync_sample_present = true;
+  sample_table->sync_sample.number_of_entries = 3;
+  sample_table->sync_sample.sync_sample_table[0] = 1;
+  sample_table->sync_sample.sync_sample_table[1] = 5;
+  sample_table->sync_sample.sync_sample_table[2] = 9;
+  err = mutff_sync_time_iterator_init(&its[0], &movie_file.movie, 0, 0x3000);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_sync_time_iterator_init(&its[1], &gop_file.movie, 0, 0x3000);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_check_sync_alignment(&alignment, its, 2, 0, heap);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(alignment.aligned_count, 3);
+  EXPECT_EQ(alignment.misalignment_count, 11);
+  EXPECT_EQ(alignment.misalignment[0].time, 1024);
+  EXPECT_EQ(alignment.misalignment[0].rendition, 0);
+  EXPECT_EQ(alignment.misalignment[0].sync_index, 1);
+
+  // the same rendition offset by a sample, within tolerance
+  MuTFFMovieFile offset_file = gop_file;
+  sample_table =
+      &offset_file.movie.track[0].media.video_media_information.sample_table;
+  sample_table->sync_sample.sync_sample_table[0] = 2;
+  sample_table->sync_sample.sync_sample_table[1] = 6;
+  sample_table->sync_sample.sync_sample_table[2] = 10;
+  err = mutff_sync_time_iterator_init(&its[0], &gop_file.movie, 0, 0x3000);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_sync_time_iterator_init(&its[1], &offset_file.movie, 0, 0x3000);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_check_sync_alignment(&alignment, its, 2, 1024, heap);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(alignment.aligned_count, 3);
+  EXPECT_EQ(alignment.misalignment_count, 0);
+
+  // misalignments are recorded in order of time, then of rendition
+  MuTFFSyncTimeIterator three[3];
+  err = mutff_sync_time_iterator_init(&three[0], &offset_file.movie, 0, 0x3000);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_sync_time_iterator_init(&three[1], &gop_file.movie, 0, 0x3000);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_sync_time_iterator_init(&three[2], &movie_file.movie, 0, 0x3000);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_check_sync_alignment(&alignment, three, 3, 0, heap);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(alignment.aligned_count, 0);
+  EXPECT_EQ(alignment.misalignment_count, 20);
+  const MuTFFSyncMisalignment expected[] = {
+      {0, 1, 0}, {0, 2, 0}, {1024, 0, 0}, {1024, 2, 1}, {2048, 2, 2}};
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(alignment.misalignment[i].time, expected[i].time) << i;
+    EXPECT_EQ(alignment.misalignment[i].rendition, expected[i].rendition)
+        << i;
+    EXPECT_EQ(alignment.misalignment[i].sync_index, expected[i].sync_index)
+        << i;
+  }
+}
+// }}}2
+
+// {{{2 VBV
+TEST_F(TestMov, VBV) {
+  MuTFFError err;
+  size_t bytes;
+  MuTFFMovieFile movie_file;
+  err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  const MuTFFSampleTableAtom *sample_table;
+  err = mutff_media_atom_sample_table(&sample_table,
+                                      &movie_file.movie.track[0].media);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  // 16168 bits every twelfth of a second, a little under the bit rate
+  MuTFFVBVModel model = {200000, 40000, 1024};
+  MuTFFVBVReport report;
+  err = mutff_simulate_vbv(&report, sample_table, 0x3000, &model);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(report.underflow_count, 0);
+  EXPECT_EQ(report.overflow_count, 0);
+  EXPECT_EQ(report.peak_fullness, 233333 - 16168 * 13);
+  EXPECT_EQ(report.min_initial_delay, 994);
+  // the bits arrived by the last removal at the least delay
+  EXPECT_EQ(report.min_buffer_size,
+            (13 * 1024 + 994) * 200000ULL / 0x3000 - 16168 * 13);
+
+  // the buffer fills up as the surplus accumulates
+  model.buffer_size = 20000;
+  err = mutff_simulate_vbv(&report, sample_table, 0x3000, &model);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(report.underflow_count, 0);
+  EXPECT_EQ(report.overflow_count, 7);
+  ASSERT_EQ(report.event_count, 7);
+  EXPECT_EQ(report.event[0].type, MuTFFVBVOverflow);
+  EXPECT_EQ(report.event[0].sample, 7);
+  EXPECT_EQ(report.event[0].time, 8 * 1024);
+
+  // without a delay no sample has arrived in time
+  model = {200000, 40000, 0};
+  err = mutff_simulate_vbv(&report, sample_table, 0x3000, &model);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(report.underflow_count, 14);
+  EXPECT_EQ(report.event[0].type, MuTFFVBVUnderflow);
+  EXPECT_EQ(report.event[0].excess, 16168);
+
+  // the reported minimums simulate clean, and the buffer size is the least
+  const uint64_t bit_rates[] = {200000, 150000, 123457, 99991};
+  for (const uint64_t bit_rate : bit_rates) {
+    model = {bit_rate, 0, 0};
+    err = mutff_simulate_vbv(&report, sample_table, 0x3000, &model);
+    ASSERT_EQ(err, MuTFFErrorNone);
+    model = {bit_rate, report.min_buffer_size, report.min_initial_delay};
+    err = mutff_simulate_vbv(&report, sample_table, 0x3000, &model);
+    ASSERT_EQ(err, MuTFFErrorNone);
+    EXPECT_EQ(report.underflow_count, 0) << bit_rate;
+    EXPECT_EQ(report.overflow_count, 0) << bit_rate;
+    EXPECT_EQ(report.peak_fullness, model.buffer_size) << bit_rate;
+    model.buffer_size--;
+    err = mutff_simulate_vbv(&report, sample_table, 0x3000, &model);
+    ASSERT_EQ(err, MuTFFErrorNone);
+    EXPECT_GT(report.overflow_count, 0) << bit_rate;
+  }
+}
+// }}}2
+
+// {{{2 Drift
+TEST_F(TestMov, Drift) {
+  MuTFFError err;
+  size_t bytes;
+  MuTFFMovieFile movie_file;
+  err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  // the edit is a millisecond longer than the media
+  MuTFFDriftPoint curve[8];
+  size_t curve_count;
+  MuTFFDriftReport report;
+  err = mutff_analyse_drift(curve, &curve_count, 8, &report, &movie_file.movie,
+                            0, 0, 250);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(curve_count, 5);
+  for (size_t i = 0; i < curve_count; ++i) {
+    EXPECT_EQ(curve[i].time, (int64_t)i * 250);
+    EXPECT_EQ(curve[i].drift, 0);
+  }
+  ASSERT_EQ(report.event_count, 2);
+  EXPECT_EQ(report.event[0].type, MuTFFDriftEventGap);
+  EXPECT_EQ(report.event[0].time, 1166);
+  EXPECT_EQ(report.event[0].duration, 1);
+
+  // a second track, delayed by an empty edit
+  MuTFFMovieAtom *movie = &movie_file.movie;
+  movie->track[1] = movie->track[0];
+  movie->track_count = 2;
+  MuTFFEditListAtom *edit_list = &movie->track[1].edit.edit_list_atom;
+  edit_list->edit_list_table[1] = edit_list->edit_list_table[0];
+  edit_list->edit_list_table[0].track_duration = 100;
+  edit_list->edit_list_table[0].media_time = UINT32_MAX;
+  edit_list->number_of_entries = 2;
+  err = mutff_analyse_drift(curve, &curve_count, 8, &report, movie, 1, 0, 250);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(curve_count, 5);
+  for (size_t i = 0; i < curve_count; ++i) {
+    EXPECT_EQ(curve[i].time, (int64_t)i * 250);
+    EXPECT_EQ(curve[i].drift, 100);
+  }
+  ASSERT_EQ(report.event_count, 4);
+  EXPECT_EQ(report.event[0].track, 1);
+  EXPECT_EQ(report.event[0].type, MuTFFDriftEventGap);
+  EXPECT_EQ(report.event[0].time, 0);
+  EXPECT_EQ(report.event[0].duration, 100);
+  EXPECT_EQ(report.event[1].time, 1266);
+  EXPECT_EQ(report.event[2].track, 0);
+  EXPECT_EQ(report.event[3].track, 0);
+  EXPECT_EQ(report.event[3].type, MuTFFDriftEventEnd);
+  EXPECT_EQ(report.event[3].time, 1166);
+  EXPECT_EQ(report.event[3].duration, 100);
+
+  // the second track shows a quarter of a second twice
+  edit_list->edit_list_table[0] = {500, 0, {1, 0}};
+  edit_list->edit_list_table[1] = {500, 0x0c00, {1, 0}};
+  err = mutff_analyse_drift(curve, &curve_count, 8, &report, movie, 1, 0, 250);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(curve_count, 3);
+  EXPECT_EQ(curve[1].drift, 0);
+  EXPECT_EQ(curve[2].time, 500);
+  EXPECT_EQ(curve[2].drift, 250);
+  ASSERT_GE(report.event_count, 1);
+  EXPECT_EQ(report.event[0].track, 1);
+  EXPECT_EQ(report.event[0].type, MuTFFDriftEventOverlap);
+  EXPECT_EQ(report.event[0].time, 500);
+  EXPECT_EQ(report.event[0].duration, 250);
+
+  err = mutff_analyse_drift(curve, &curve_count, 2, &report, movie, 1, 0, 250);
+  EXPECT_EQ(err, MuTFFErrorOutOfMemory);
+
+  // the second track's later samples run long
+  movie->track[1] = movie->track[0];
+  MuTFFTimeToSampleAtom *stts = &movie->track[1]
+                                     .media.video_media_information
+                                     .sample_table.time_to_sample;
+  stts->time_to_sample_table[0] = {7, 1024};
+  stts->time_to_sample_table[1] = {7, 1100};
+  stts->number_of_entries = 2;
+  err = mutff_analyse_drift(curve, &curve_count, 8, &report, movie, 1, 0, 250);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(curve_count, 5);
+  EXPECT_EQ(curve[2].drift, 0);
+  EXPECT_EQ(curve[3].drift, 12);
+  EXPECT_EQ(curve[4].drift, 30);
+  ASSERT_EQ(report.event_count, 2);
+  EXPECT_EQ(report.event[1].track, 0);
+  EXPECT_EQ(report.event[1].type, MuTFFDriftEventEnd);
+  EXPECT_EQ(report.event[1].duration, 1);
+
+  // and at half speed
+  movie->track[1] = movie->track[0];
+  movie->track[1].edit.edit_list_atom.edit_list_table[0].media_rate = {0,
+                                                                       0x8000};
+  err = mutff_analyse_drift(curve, &curve_count, 8, &report, movie, 1, 0, 250);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(curve_count, 3);
+  EXPECT_EQ(curve[1].drift, 250);
+  EXPECT_EQ(curve[2].drift, 500);
+}
+// }}}2
+
+// {{{2 FragmentPlan
+TEST_F(TestMov, FragmentPlan) {
+  MuTFFError err;
+  size_t bytes;
+  MuTFFMovieFile movie_file;
+  err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  MuTFFSampleTableAtom *sample_table =
+      &movie_file.movie.track[0].media.video_media_information.sample_table;
+
+  // every sample is a sync sample, so two fit in 5000 bytes
+  MuTFFFragmentRange fragments[8];
+  size_t count;
+  MuTFFFragmentPolicy policy = {5000, 0};
+  err = mutff_plan_fragments(fragments, &count, 8, sample_table, &policy);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(count, 7);
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_EQ(fragments[i].first_sample, i * 2);
+    EXPECT_EQ(fragments[i].sample_count, 2);
+    EXPECT_EQ(fragments[i].size, 2 * 0x07e5);
+    EXPECT_EQ(fragments[i].duration, 2 * 1024);
+  }
+
+  policy = {0, 3000};
+  err = mutff_plan_fragments(fragments, &count, 8, sample_table, &policy);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(count, 7);
+  err = mutff_plan_fragments(fragments, &count, 6, sample_table, &policy);
+  EXPECT_EQ(err, MuTFFErrorOutOfMemory);
+
+  // sync samples every fourth sample, the last run being too large
+  sample_table->sync_sample_present = true;
+  sample_table->sync_sample.number_of_entries = 3;
+  sample_table->sync_sample.sync_sample_table[0] = 1;
+  sample_table->sync_sample.sync_sample_table[1] = 5;
+  sample_table->sync_sample.sync_sample_table[2] = 9;
+  policy = {10000, 0};
+  err = mutff_plan_fragments(fragments, &count, 8, sample_table, &policy);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(count, 3);
+  EXPECT_EQ(fragments[0].first_sample, 0);
+  EXPECT_EQ(fragments[0].sample_count, 4);
+  EXPECT_EQ(fragments[1].first_sample, 4);
+  EXPECT_EQ(fragments[1].sample_count, 4);
+  EXPECT_EQ(fragments[2].first_sample, 8);
+  EXPECT_EQ(fragments[2].sample_count, 6);
+  EXPECT_GT(fragments[2].size, policy.max_size);
+}
+// }}}2
+
+// {{{2 EDL
+TEST_F(TestMov, EDL) {
+  MuTFFError err;
+  size_t bytes;
+  MuTFFMovieFile movie_file;
+  err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  // the first half second, then from 0x2000 after a half second gap
+  const MuTFFEDLSource source = {&movie_file.movie, "test.mov"};
+  const MuTFFEDLSegment segments[] = {
+      {0, 0, 0, 0, 0x1800},
+      {0, 0, 1000, 0x2000, 0x3000},
+  };
+  MuTFFMovieAtom movie;
+  err = mutff_render_edl(&movie, &source, 1, segments, 2, 1000);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  ASSERT_EQ(movie.track_count, 1);
+  EXPECT_EQ(movie.movie_header.duration, 1333);
+  EXPECT_EQ(movie.movie_header.next_track_id, 2);
+
+  // write the movie and read it back
+  unsigned char data[8192];
+  MuTFFMemoryBuffer buf;
+  MuTFFContext mem_ctx;
+  mem_ctx.io = mutff_memory_driver;
+  mem_ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+  err = mutff_write_movie_atom(&mem_ctx, &bytes, &movie);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  mutff_memory_buffer_init(&buf, data, bytes);
+  err = mutff_read_movie_atom(&mem_ctx, &bytes, &movie);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  const MuTFFTrackAtom *trak = &movie.track[0];
+  EXPECT_EQ(trak->track_header.track_id, 1);
+  EXPECT_EQ(trak->track_header.duration, 1333);
+  const MuTFFEditListAtom *elst = &trak->edit.edit_list_atom;
+  ASSERT_EQ(elst->number_of_entries, 3);
+  EXPECT_EQ(elst->edit_list_table[0].track_duration, 500);
+  EXPECT_EQ(elst->edit_list_table[0].media_time, 0);
+  EXPECT_EQ(elst->edit_list_table[1].track_duration, 500);
+  EXPECT_EQ(elst->edit_list_table[1].media_time, UINT32_MAX);
+  EXPECT_EQ(elst->edit_list_table[2].track_duration, 333);
+  EXPECT_EQ(elst->edit_list_table[2].media_time, 0x2000);
+
+  // the media stays where it is
+  const MuTFFVideoMediaInformationAtom *minf =
+      &trak->media.video_media_information;
+  const MuTFFDataReferenceAtom *dref = &minf->data_information.data_reference;
+  ASSERT_EQ(dref->number_of_entries, 1);
+  EXPECT_EQ(dref->data_references[0].type, MuTFF_FOURCC('u', 'r', 'l', ' '));
+  EXPECT_EQ(dref->data_references[0].flags, 0);
+  EXPECT_STREQ(dref->data_references[0].data, "test.mov");
+  EXPECT_EQ(minf->sample_table.sample_description.sample_description_table[0]
+                .data_reference_index,
+            1);
+  EXPECT_EQ(minf->sample_table.chunk_offset.chunk_offset_table[0],
+            movie_file.movie.track[0]
+                .media.video_media_information.sample_table.chunk_offset
+                .chunk_offset_table[0]);
+
+  // segments of a track may not overlap
+  const MuTFFEDLSegment overlapping[] = {
+      {0, 0, 0, 0, 0x1800},
+      {0, 0, 400, 0x2000, 0x3000},
+  };
+  err = mutff_render_edl(&movie, &source, 1, overlapping, 2, 1000);
+  EXPECT_EQ(err, MuTFFErrorBadFormat);
+}
+// }}}2
+
+// {{{2 Faststart
+TEST_F(TestMov, Faststart) {
+  MuTFFError err;
+  size_t bytes;
+  unsigned char movie[1024];
+  MuTFFFaststartView view;
+
+  err = mutff_faststart_view_init(&view, &ctx, movie, 512);
+  EXPECT_EQ(err, MuTFFErrorOutOfMemory);
+  fseek((FILE *)ctx.file, 0, SEEK_SET);
+  err = mutff_faststart_view_init(&view, &ctx, movie, sizeof(movie));
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(view.size, 29036);
+  EXPECT_EQ(view.movie_size, 706);
+
+  // the movie atom follows the file type atom
+  unsigned char header[8];
+  err = mutff_faststart_read_at(&view, header, 20, 8);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(header[2], 706 >> 8);
+  EXPECT_EQ(header[3], 706 & 0xff);
+  EXPECT_EQ(memcmp(&header[4], "moov", 4), 0);
+  err = mutff_faststart_read_at(&view, header, 726, 8);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(memcmp(&header[4], "wide", 4), 0);
+  err = mutff_faststart_read_at(&view, header, 29032, 8);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+
+  // the view reads as a file, with its chunk offsets pointing at the moved
+  // media
+  MuTFFContext view_ctx;
+  view_ctx.io = mutff_faststart_driver;
+  view_ctx.file = &view;
+  MuTFFMovieFile movie_file;
+  err = mutff_read_movie_file(&view_ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 29036);
+  const MuTFFChunkOffsetAtom *stco =
+      &movie_file.movie.track[0]
+           .media.video_media_information.sample_table.chunk_offset;
+  ASSERT_EQ(stco->number_of_entries, 1);
+  EXPECT_EQ(stco->chunk_offset_table[0], 36 + 706);
+
+  unsigned char expected[16];
+  unsigned char actual[16];
+  fseek((FILE *)ctx.file, 36, SEEK_SET);
+  ASSERT_EQ(fread(expected, 1, sizeof(expected), (FILE *)ctx.file),
+            sizeof(expected));
+  err = mutff_faststart_read_at(&view, actual, stco->chunk_offset_table[0],
+                                sizeof(actual));
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(memcmp(actual, expected, sizeof(actual)), 0);
+}
+
+TEST(Faststart, Containers) {
+  // ftyp, mdat, then moov holding trak>mdia>minf>stbl>stco and a 'udta' with
+  // a legacy zero terminator
+  unsigned char file[] = {
+      0x00, 0x00, 0x00, 0x10, 'f',  't',  'y',  'p',  'q',  't',  ' ',  ' ',
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 'm',  'd',  'a',  't',
+      0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x00, 0x00, 0x00, 0x48,
+      'm',  'o',  'o',  'v',  0x00, 0x00, 0x00, 0x34, 't',  'r',  'a',  'k',
+      0x00, 0x00, 0x00, 0x2c, 'm',  'd',  'i',  'a',  0x00, 0x00, 0x00, 0x24,
+      'm',  'i',  'n',  'f',  0x00, 0x00, 0x00, 0x1c, 's',  't',  'b',  'l',
+      0x00, 0x00, 0x00, 0x14, 's',  't',  'c',  'o',  0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x0c,
+      'u',  'd',  't',  'a',  0x00, 0x00, 0x00, 0x00,
+  };
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx;
+  ctx.io = mutff_memory_driver;
+  ctx.file = &buf;
+  unsigned char movie[128];
+  MuTFFFaststartView view;
+  mutff_memory_buffer_init(&buf, file, sizeof(file));
+  MuTFFError err = mutff_faststart_view_init(&view, &ctx, movie, sizeof(movie));
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(view.movie_size, 72);
+  unsigned char offset[4];
+  err = mutff_faststart_read_at(&view, offset, 16 + 56, 4);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(offset[3], 24 + 72);
+
+  // a compressed movie's chunk offsets cannot be adjusted
+  memcpy(&file[96], "cmov", 4);
+  mutff_memory_buffer_init(&buf, file, sizeof(file));
+  err = mutff_faststart_view_init(&view, &ctx, movie, sizeof(movie));
+  EXPECT_EQ(err, MuTFFErrorBadFormat);
+}
+// }}}2
+
+// {{{2 Segment
+TEST_F(TestMov, Segment) {
+  MuTFFMovieFile movie_file;
+  size_t bytes;
+  MuTFFError err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  uint64_t size;
+  err = mutff_sample_index_size(&size, &movie_file.movie);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  uint64_t data[size / sizeof(uint64_t)];
+  err = mutff_build_sample_index(data, size, &movie_file.movie);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  const MuTFFSampleIndex *index = (const MuTFFSampleIndex *)data;
+
+  // every sample is a sync sample, so segments are four samples long
+  unsigned char header[256];
+  MuTFFSegment segment;
+  err = mutff_make_segment(&segment, header, 64, index, 0, 0, 4096);
+  EXPECT_EQ(err, MuTFFErrorOutOfMemory);
+  err = mutff_make_segment(&segment, header, sizeof(header), index, 0, 2, 4096);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(segment.first_sample, 8);
+  EXPECT_EQ(segment.sample_count, 4);
+  EXPECT_EQ(segment.decode_time, 8192);
+  EXPECT_EQ(segment.header_size, 144);
+  EXPECT_EQ(segment.size, 144 + 4 * 0x7e5);
+  ASSERT_EQ(segment.range_count, 1);
+  EXPECT_EQ(segment.range[0].offset, 36 + 8 * 0x7e5);
+  EXPECT_EQ(segment.range[0].size, 4 * 0x7e5);
+
+  MuTFFMemoryBuffer buf;
+  MuTFFContext mem_ctx;
+  mem_ctx.io = mutff_memory_driver;
+  mem_ctx.file = &buf;
+  mutff_memory_buffer_init(&buf, header, segment.header_size);
+  MuTFFMovieFragmentAtom moof;
+  err = mutff_read_movie_fragment_atom(&mem_ctx, &bytes, &moof);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 136);
+  EXPECT_EQ(moof.movie_fragment_header.sequence_number, 3);
+  ASSERT_EQ(moof.track_fragment_count, 1);
+  const MuTFFTrackFragmentAtom *traf = &moof.track_fragment[0];
+  EXPECT_EQ(traf->track_fragment_header.track_id, 1);
+  EXPECT_EQ(traf->track_fragment_decode_time.base_media_decode_time, 8192);
+  ASSERT_EQ(traf->track_fragment_run_count, 1);
+  EXPECT_EQ(traf->track_fragment_run[0].data_offset, 144);
+  EXPECT_EQ(traf->track_fragment_run[0].sample_count, 4);
+  EXPECT_EQ(traf->track_fragment_run[0].records[0].sample_size, 0x7e5);
+  EXPECT_EQ(memcmp(&header[140], "mdat", 4), 0);
+
+  // the last segment is short
+  err = mutff_make_segment(&segment, header, sizeof(header), index, 0, 3, 4096);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(segment.first_sample, 12);
+  EXPECT_EQ(segment.sample_count, 2);
+  err = mutff_make_segment(&segment, header, sizeof(header), index, 0, 4, 4096);
+  EXPECT_EQ(err, MuTFFErrorEOF);
+
+  // the least recently used segment is replaced
+  MuTFFSegmentCacheEntry entries[2];
+  unsigned char cache_buf[2 * 256];
+  MuTFFSegmentCache cache;
+  mutff_segment_cache_init(&cache, entries, 2, cache_buf, sizeof(cache_buf));
+  const MuTFFSegment *first;
+  const MuTFFSegment *second;
+  const MuTFFSegment *again;
+  err = mutff_segment_cache_get(&first, &cache, index, 0, 0, 4096);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_segment_cache_get(&second, &cache, index, 0, 1, 4096);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_NE(first, second);
+  err = mutff_segment_cache_get(&again, &cache, index, 0, 0, 4096);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(again, first);
+  err = mutff_segment_cache_get(&again, &cache, index, 0, 2, 4096);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(again, second);
+  EXPECT_EQ(again->first_sample, 8);
+  err = mutff_segment_cache_get(&again, &cache, index, 0, 0, 4096);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(again, first);
+  EXPECT_EQ(again->first_sample, 0);
+
+  // composition offsets are carried into the runs
+  MuTFFSampleTableAtom *stbl =
+      &movie_file.movie.track[0].media.video_media_information.sample_table;
+  stbl->composition_offset_present = true;
+  stbl->composition_offset.entry_count = 2;
+  stbl->composition_offset.composition_offset_table[0] = {9, 1024};
+  stbl->composition_offset.composition_offset_table[1] = {5, (uint32_t)-1024};
+  err = mutff_build_sample_index(data, size, &movie_file.movie);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  err = mutff_make_segment(&segment, header, sizeof(header), index, 0, 2, 4096);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(segment.header_size, 160);
+  mutff_memory_buffer_init(&buf, header, segment.header_size);
+  err = mutff_read_movie_fragment_atom(&mem_ctx, &bytes, &moof);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  const MuTFFTrackFragmentRunAtom *trun =
+      &moof.track_fragment[0].track_fragment_run[0];
+  EXPECT_EQ(trun->version, 1);
+  EXPECT_TRUE(trun->sample_composition_time_offset_present);
+  EXPECT_EQ(trun->data_offset, 160);
+  EXPECT_EQ(trun->records[0].sample_composition_time_offset, 1024);
+  EXPECT_EQ(trun->records[1].sample_composition_time_offset, -1024);
+}
+// }}}2
+
+// {{{2 CompressedMovie
+TEST_F(TestMov, CompressedMovie) {
+  MuTFFError err;
+  size_t bytes;
+  MuTFFMovieAtom movie;
+  fseek((FILE *)ctx.file, 28330, SEEK_SET);
+  err = mutff_read_movie_atom(&ctx, &bytes, &movie);
+  ASSERT_EQ(err, MuTFFErrorNone);
+
+  unsigned char work[4096];
+  unsigned char data[1024];
+  MuTFFMemoryBuffer buf;
+  MuTFFContext mem_ctx;
+  mem_ctx.io = mutff_memory_driver;
+  mem_ctx.file = &buf;
+  size_t movie_size;
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+  err = mutff_write_movie_atom(&mem_ctx, &movie_size, &movie);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  mutff_memory_buffer_init(&buf, data, sizeof(data));
+  err = mutff_write_compressed_movie_atom(&mem_ctx, &bytes, &movie, work, 512);
+  EXPECT_EQ(err, MuTFFErrorOutOfMemory);
+  err = mutff_write_compressed_movie_atom(&mem_ctx, &bytes, &movie, work,
+                                          sizeof(work));
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_LT(bytes, movie_size);
+  EXPECT_EQ(memcmp(&data[4], "moov", 4), 0);
+  EXPECT_EQ(memcmp(&data[12], "cmov", 4), 0);
+  EXPECT_EQ(memcmp(&data[20], "dcom", 4), 0);
+  EXPECT_EQ(memcmp(&data[24], "zlib", 4), 0);
+  EXPECT_EQ(memcmp(&data[32], "cmvd", 4), 0);
+  EXPECT_EQ(data[38], movie_size >> 8);
+  EXPECT_EQ(data[39], movie_size & 0xff);
+
+  // the compressed movie needs working space to read
+  MuTFFMovieAtom compressed;
+  const size_t compressed_size = bytes;
+  mutff_memory_buffer_init(&buf, data, compressed_size);
+  err = mutff_read_movie_atom(&mem_ctx, &bytes, &compressed);
+  EXPECT_EQ(err, MuTFFErrorCompressed);
+
+  // the compressed movie reads as the original
+  mutff_memory_buffer_init(&buf, data, compressed_size);
+  err = mutff_read_compressed_movie_atom(
+      &mem_ctx, &bytes, &compressed, work,
+      movie_size + MuTFF_COMPRESSED_MOVIE_WORK_SIZE);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, buf.size);
+  EXPECT_EQ(compressed.movie_header.time_scale, 1000);
+  ASSERT_EQ(compressed.track_count, 1);
+  const MuTFFSampleTableAtom *stbl =
+      &compressed.track[0].media.video_media_information.sample_table;
+  EXPECT_EQ(stbl->sample_size.number_of_entries, 14);
+  EXPECT_EQ(stbl->sample_size.sample_size, 0x7e5);
+  EXPECT_EQ(stbl->chunk_offset.chunk_offset_table[0], 36);
+
+  // the decompressed movie must fit the buffer
+  mutff_memory_buffer_init(&buf, data, compressed_size);
+  err = mutff_read_compressed_movie_atom(&mem_ctx, &bytes, &compressed, work,
+                                         movie_size + 512);
+  EXPECT_EQ(err, MuTFFErrorOutOfMemory);
+}
+// }}}2
+
+// {{{2 CompressedMovieFile
+// test_cmov.mov is test.mov with its movie atom compressed by zlib
+TEST(TestCompressedMov, MovieFile) {
+  MuTFFContext ctx;
+  ctx.file = fopen("test_cmov.mov", "rb");
+  ctx.io = mutff_stdlib_driver;
+  ASSERT_NE(ctx.file, nullptr);
+
+  // the context is left at the start of the compressed movie atom
+  MuTFFMovieFile movie_file;
+  size_t bytes;
+  MuTFFError err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  EXPECT_EQ(err, MuTFFErrorCompressed);
+  EXPECT_EQ(ftell((FILE *)ctx.file), 28330);
+
+  unsigned char work[4096];
+  fseek((FILE *)ctx.file, 0, SEEK_SET);
+  err = mutff_read_movie_file_buffered(&ctx, &bytes, &movie_file, work,
+                                       sizeof(work));
+  fclose((FILE *)ctx.file);
+  ASSERT_EQ(err, MuTFFErrorNone);
+  EXPECT_EQ(bytes, 28713);
+
+  EXPECT_EQ(movie_file.movie_data_count, 1);
+  const MuTFFMovieAtom *movie = &movie_file.movie;
+  EXPECT_EQ(movie->movie_header.time_scale, 1000);
+  ASSERT_EQ(movie->track_count, 1);
+  const MuTFFSampleTableAtom *stbl =
+      &movie->track[0].media.video_media_information.sample_table;
+  EXPECT_EQ(stbl->sample_size.number_of_entries, 14);
+  EXPECT_EQ(stbl->sample_size.sample_size, 0x7e5);
+  EXPECT_EQ(stbl->chunk_offset.chunk_offset_table[0], 36);
+}
+// }}}2
 // }}}1
 
 // vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,189 @@
+///
+/// @file      mutff_export.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     Export the samples of a still image track as an image sequence
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+/// Usage: mutff_export [-j JOBS] [-t TRACK] FILE DIRECTORY
+///
+/// Each sample of the first video track of FILE, or track TRACK counting from
+/// zero, is written to its own file in DIRECTORY, named by its index. The
+/// track must hold standalone images: 'jpeg', 'mjpa', 'png ' or 'tiff'. The
+/// samples are divided between JOBS threads, four by default, in runs of
+/// similar size, and copied within the kernel where possible.
+///
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_sample.h"
+#include "mutff_tools.h"
+
+#define MAX_JOBS 64U
+
+typedef struct {
+  const MuTFFSampleTableAtom *sample_table;
+  const char *extension;
+  const char *dir;
+  int src;
+  uint32_t first;
+  uint32_t end;
+  int status;
+} Job;
+
+static MuTFFMovieFile movie_file;
+
+static const char *image_extension(uint32_t data_format) {
+  switch (data_format) {
+    case MuTFF_FOURCC('j', 'p', 'e', 'g'):
+    case MuTFF_FOURCC('m', 'j', 'p', 'a'):
+      return "jpg";
+    case MuTFF_FOURCC('p', 'n', 'g', ' '):
+      return "png";
+    case MuTFF_FOURCC('t', 'i', 'f', 'f'):
+      return "tiff";
+    default:
+      return NULL;
+  }
+}
+
+static void *export_run(void *arg) {
+  Job *job = arg;
+  char path[4096];
+  MuTFFSample sample;
+  MuTFFSampleCursor cursor;
+  if (mutff_sample_cursor_init(&cursor, job->sample_table, job->first) !=
+      MuTFFErrorNone) {
+    fprintf(stderr, "sample %u: could not locate sample\n",
+            (unsigned)job->first);
+    job->status = -1;
+    return NULL;
+  }
+  for (uint32_t i = job->first; i < job->end; ++i) {
+    if (mutff_sample_cursor_next(&sample, &cursor) != MuTFFErrorNone) {
+      fprintf(stderr, "sample %u: could not locate sample\n", (unsigned)i);
+      job->status = -1;
+      return NULL;
+    }
+    if (snprintf(path, sizeof(path), "%s/%06u.%s", job->dir, (unsigned)i,
+                 job->extension) >= (int)sizeof(path)) {
+      job->status = -1;
+      return NULL;
+    }
+    const int dest = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (dest < 0) {
+      perror(path);
+      job->status = -1;
+      return NULL;
+    }
+    const int err = copy_range(job->src, (off_t)sample.offset, dest,
+                               sample.size);
+    if (close(dest) != 0 || err != 0) {
+      perror(path);
+      job->status = -1;
+      return NULL;
+    }
+  }
+  job->status = 0;
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  unsigned long jobs = 4;
+  long track = -1;
+  int opt;
+  while ((opt = getopt(argc, argv, "j:t:")) != -1) {
+    if (opt == 'j') {
+      jobs = strtoul(optarg, NULL, 10);
+    } else if (opt == 't') {
+      track = strtol(optarg, NULL, 10);
+    } else {
+      jobs = 0;
+      break;
+    }
+  }
+  if (argc - optind != 2 || jobs == 0U || jobs > MAX_JOBS) {
+    fprintf(stderr, "usage: %s [-j JOBS] [-t TRACK] FILE DIRECTORY\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+  const char *path = argv[optind];
+  const char *dir = argv[optind + 1];
+
+  if (load_movie(&movie_file, path) != 0) {
+    return EXIT_FAILURE;
+  }
+  const MuTFFMovieAtom *movie = &movie_file.movie;
+  if (track < 0) {
+    track = (long)video_track(movie);
+  }
+  if ((size_t)track >= movie->track_count) {
+    fprintf(stderr, "%s: no track %ld\n", path, track);
+    return EXIT_FAILURE;
+  }
+  const MuTFFSampleTableAtom *sample_table;
+  if (mutff_media_atom_sample_table(&sample_table,
+                                    &movie->track[track].media) !=
+          MuTFFErrorNone ||
+      sample_table->sample_description.number_of_entries == 0U) {
+    fprintf(stderr, "%s: track %ld has no samples\n", path, track);
+    return EXIT_FAILURE;
+  }
+  const char *extension = image_extension(
+      sample_table->sample_description.sample_description_table[0]
+          .data_format);
+  if (extension == NULL) {
+    fprintf(stderr, "%s: track %ld does not hold still images\n", path, track);
+    return EXIT_FAILURE;
+  }
+
+  uint32_t runs[MAX_JOBS + 1U];
+  if (mutff_sample_table_partition(runs, jobs, sample_table) !=
+      MuTFFErrorNone) {
+    fprintf(stderr, "%s: bad sample table\n", path);
+    return EXIT_FAILURE;
+  }
+
+  const int src = open(path, O_RDONLY);
+  if (src < 0) {
+    perror(path);
+    return EXIT_FAILURE;
+  }
+  Job job[MAX_JOBS];
+  pthread_t thread[MAX_JOBS];
+  for (size_t i = 0; i < jobs; ++i) {
+    job[i].sample_table = sample_table;
+    job[i].extension = extension;
+    job[i].dir = dir;
+    job[i].src = src;
+    job[i].first = runs[i];
+    job[i].end = runs[i + 1U];
+    job[i].status = -1;
+    if (pthread_create(&thread[i], NULL, export_run, &job[i]) != 0) {
+      fprintf(stderr, "could not start thread\n");
+      return EXIT_FAILURE;
+    }
+  }
+  int status = EXIT_SUCCESS;
+  for (size_t i = 0; i < jobs; ++i) {
+    pthread_join(thread[i], NULL);
+    if (job[i].status != 0) {
+      status = EXIT_FAILURE;
+    }
+  }
+  close(src);
+  fprintf(stderr, "exported %u samples\n", (unsigned)runs[jobs]);
+  return status;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,347 @@
+///
+/// @file      mutff_indexd.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     Daemon serving sample index queries over a Unix domain socket
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+/// Usage: mutff_indexd DIRECTORY SOCKET
+///
+/// Every movie in DIRECTORY is parsed once at startup and its sample index is
+/// kept in memory. Clients connect to SOCKET and send requests in the format
+/// described in mutff_query.h, naming movies by their file name within
+/// DIRECTORY. Requests naming an unknown movie are answered with status
+/// MuTFFErrorIOError. Responses are queued per client and sent as its socket
+/// accepts them, so a client which reads slowly does not hold up the others.
+///
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_memory.h"
+#include "mutff_query.h"
+#include "mutff_sample.h"
+#include "mutff_stdlib.h"
+
+#define MAX_MOVIES 256U
+#define MAX_CLIENTS 32U
+#define BUFFER_SIZE 4096U
+#define MAX_RESPONSE_SIZE 512U
+
+typedef struct {
+  size_t name_length;
+  char name[MuTFF_MAX_QUERY_NAME_LEN];
+  MuTFFSampleIndex *index;
+} Movie;
+
+typedef struct {
+  int fd;
+  size_t in_length;
+  unsigned char in[BUFFER_SIZE];
+  size_t out_length;
+  unsigned char out[BUFFER_SIZE];
+} Client;
+
+static Movie movies[MAX_MOVIES];
+static size_t movie_count;
+static Client clients[MAX_CLIENTS];
+static MuTFFMovieFile movie_file;
+
+static int load_movie(Movie *movie, const char *dir, const char *name) {
+  char path[4096];
+  const size_t name_length = strlen(name);
+  if (name_length > MuTFF_MAX_QUERY_NAME_LEN) {
+    return -1;
+  }
+  if (snprintf(path, sizeof(path), "%s/%s", dir, name) >= (int)sizeof(path)) {
+    return -1;
+  }
+  struct stat st;
+  if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+    return -1;
+  }
+
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return -1;
+  }
+  MuTFFContext ctx;
+  ctx.io = mutff_stdlib_driver;
+  ctx.file = file;
+  size_t bytes;
+  MuTFFError err = mutff_read_movie_file(&ctx, &bytes, &movie_file);
+  fclose(file);
+  if (err != MuTFFErrorNone) {
+    return -1;
+  }
+
+  uint64_t size;
+  err = mutff_sample_index_size(&size, &movie_file.movie);
+  if (err != MuTFFErrorNone) {
+    return -1;
+  }
+  movie->index = malloc(size);
+  if (movie->index == NULL) {
+    return -1;
+  }
+  err = mutff_build_sample_index(movie->index, size, &movie_file.movie);
+  if (err != MuTFFErrorNone) {
+    free(movie->index);
+    return -1;
+  }
+  memcpy(movie->name, name, name_length);
+  movie->name_length = name_length;
+  return 0;
+}
+
+static void load_movies(const char *dir) {
+  DIR *d = opendir(dir);
+  if (d == NULL) {
+    perror(dir);
+    exit(EXIT_FAILURE);
+  }
+  struct dirent *entry;
+  while ((entry = readdir(d)) != NULL && movie_count < MAX_MOVIES) {
+    if (load_movie(&movies[movie_count], dir, entry->d_name) == 0) {
+      ++movie_count;
+    }
+  }
+  closedir(d);
+}
+
+static const Movie *find_movie(const MuTFFQueryRequest *request) {
+  for (size_t i = 0; i < movie_count; ++i) {
+    if (movies[i].name_length == request->name_length &&
+        memcmp(movies[i].name, request->name, request->name_length) == 0) {
+      return &movies[i];
+    }
+  }
+  return NULL;
+}
+
+// send as much queued output as the socket accepts without blocking
+static int flush_output(Client *client) {
+  size_t sent_length = 0;
+  while (sent_length < client->out_length) {
+    const ssize_t sent = send(client->fd, &client->out[sent_length],
+                              client->out_length - sent_length, 0);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      return -1;
+    }
+    sent_length += (size_t)sent;
+  }
+  memmove(client->out, &client->out[sent_length],
+          client->out_length - sent_length);
+  client->out_length -= sent_length;
+  return 0;
+}
+
+static uint32_t frame_size(const unsigned char *data) {
+  return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+         ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+// answer the complete requests in the client's input buffer, in order, while
+// there is room to queue the responses
+static int handle_requests(Client *client) {
+  MuTFFMemoryBuffer in;
+  MuTFFMemoryBuffer out;
+  MuTFFContext in_ctx = {mutff_memory_driver, &in};
+  MuTFFContext out_ctx = {mutff_memory_driver, &out};
+  size_t consumed = 0;
+  size_t bytes;
+
+  mutff_memory_buffer_init(&out, client->out, sizeof(client->out));
+  out.pos = client->out_length;
+  while (client->in_length - consumed >= 4U &&
+         out.size - out.pos >= MAX_RESPONSE_SIZE) {
+    const uint32_t size = frame_size(&client->in[consumed]);
+    // a request which can never fit in the buffer is an error
+    if (size > sizeof(client->in)) {
+      return -1;
+    }
+    if (size > client->in_length - consumed) {
+      break;
+    }
+    mutff_memory_buffer_init(&in, &client->in[consumed], size);
+    MuTFFQueryRequest request;
+    MuTFFError err = mutff_read_query_request(&in_ctx, &bytes, &request);
+    if (err != MuTFFErrorNone || bytes != size) {
+      return -1;
+    }
+    consumed += size;
+
+    MuTFFQueryResponse response;
+    const Movie *movie = find_movie(&request);
+    if (movie == NULL) {
+      response.type = request.type;
+      response.request_id = request.request_id;
+      response.status = MuTFFErrorIOError;
+    } else {
+      mutff_answer_query(&response, movie->index, &request);
+    }
+    err = mutff_write_query_response(&out_ctx, &bytes, &response);
+    if (err != MuTFFErrorNone) {
+      return -1;
+    }
+  }
+
+  client->out_length = out.pos;
+  memmove(client->in, &client->in[consumed], client->in_length - consumed);
+  client->in_length -= consumed;
+  return 0;
+}
+
+// read what the client has sent, answer it and send what the socket accepts
+static int serve_client(Client *client, short revents) {
+  if ((revents & (POLLERR | POLLNVAL)) != 0) {
+    return -1;
+  }
+  if ((revents & POLLIN) != 0) {
+    const ssize_t received =
+        recv(client->fd, &client->in[client->in_length],
+             sizeof(client->in) - client->in_length, 0);
+    if (received == 0) {
+      return -1;
+    }
+    if (received < 0) {
+      if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+        return -1;
+      }
+    } else {
+      client->in_length += (size_t)received;
+    }
+  } else if ((revents & POLLHUP) != 0) {
+    return -1;
+  }
+
+  // sending output makes room to answer more requests, so keep going until
+  // neither answering nor sending gets anywhere
+  for (;;) {
+    const size_t in_length = client->in_length;
+    const size_t out_length = client->out_length;
+    if (handle_requests(client) != 0 || flush_output(client) != 0) {
+      return -1;
+    }
+    if (client->in_length == in_length && client->out_length == out_length) {
+      return 0;
+    }
+  }
+}
+
+static int listen_on(const char *path) {
+  struct sockaddr_un addr;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "%s: socket path too long\n", path);
+    exit(EXIT_FAILURE);
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("socket");
+    exit(EXIT_FAILURE);
+  }
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(fd, (int)MAX_CLIENTS) != 0) {
+    perror(path);
+    exit(EXIT_FAILURE);
+  }
+  return fd;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s DIRECTORY SOCKET\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  load_movies(argv[1]);
+  fprintf(stderr, "indexed %zu movies\n", movie_count);
+  const int listen_fd = listen_on(argv[2]);
+
+  for (size_t i = 0; i < MAX_CLIENTS; ++i) {
+    clients[i].fd = -1;
+  }
+
+  struct pollfd fds[MAX_CLIENTS + 1U];
+  for (;;) {
+    fds[0].fd = listen_fd;
+    fds[0].events = POLLIN;
+    for (size_t i = 0; i < MAX_CLIENTS; ++i) {
+      const Client *client = &clients[i];
+      fds[i + 1U].fd = client->fd;
+      fds[i + 1U].events = 0;
+      // stop reading requests while there is no room for their responses
+      if (client->in_length < sizeof(client->in) &&
+          sizeof(client->out) - client->out_length >= MAX_RESPONSE_SIZE) {
+        fds[i + 1U].events |= POLLIN;
+      }
+      if (client->out_length > 0U) {
+        fds[i + 1U].events |= POLLOUT;
+      }
+    }
+    if (poll(fds, MAX_CLIENTS + 1U, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("poll");
+      return EXIT_FAILURE;
+    }
+
+    if ((fds[0].revents & POLLIN) != 0) {
+      const int fd = accept(listen_fd, NULL, NULL);
+      if (fd >= 0) {
+        size_t i = 0;
+        while (i < MAX_CLIENTS && clients[i].fd >= 0) {
+          ++i;
+        }
+        if (i == MAX_CLIENTS ||
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+          close(fd);
+        } else {
+          clients[i].fd = fd;
+          clients[i].in_length = 0;
+          clients[i].out_length = 0;
+        }
+      }
+    }
+
+    for (size_t i = 0; i < MAX_CLIENTS; ++i) {
+      Client *client = &clients[i];
+      if (client->fd < 0 || fds[i + 1U].revents == 0) {
+        continue;
+      }
+      if (serve_client(client, fds[i + 1U].revents) != 0) {
+        close(client->fd);
+        client->fd = -1;
+      }
+    }
+  }
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
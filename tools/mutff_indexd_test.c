@@ -0,0 +1,180 @@
+///
+/// @file      mutff_indexd_test.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     Check that mutff_indexd answers pipelined requests
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+/// Usage: mutff_indexd_test DAEMON DIRECTORY SOCKET MOVIE
+///
+/// DAEMON is started serving DIRECTORY on SOCKET, and sent track summary
+/// requests for MOVIE all at once, more than can be answered before the
+/// client's output buffer is full. The test passes if every request is
+/// answered, in order, with no error.
+///
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mutff.h"
+#include "mutff_memory.h"
+#include "mutff_query.h"
+
+// the requests fit in a client's input buffer, their responses do not fit in
+// its output buffer
+#define REQUEST_COUNT 120U
+#define TIMEOUT_MS 5000
+
+static int connect_to(const char *path) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1U);
+
+  // wait for the daemon to start listening
+  for (int attempt = 0; attempt < 100; ++attempt) {
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+      return fd;
+    }
+    close(fd);
+    const struct timespec delay = {0, 50000000};
+    nanosleep(&delay, NULL);
+  }
+  return -1;
+}
+
+static int send_all(int fd, const unsigned char *data, size_t length) {
+  while (length > 0U) {
+    const ssize_t sent = send(fd, data, length, 0);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    data += sent;
+    length -= (size_t)sent;
+  }
+  return 0;
+}
+
+static uint32_t frame_size(const unsigned char *data) {
+  return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+         ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+// send every request at once, then read the responses
+static int pipeline(int fd, const char *movie) {
+  static unsigned char requests[REQUEST_COUNT * 128U];
+  MuTFFMemoryBuffer buf;
+  MuTFFContext ctx = {mutff_memory_driver, &buf};
+  size_t bytes;
+
+  mutff_memory_buffer_init(&buf, requests, sizeof(requests));
+  for (uint32_t i = 0; i < REQUEST_COUNT; ++i) {
+    MuTFFQueryRequest request;
+    request.type = MuTFF_QUERY_TRACK_SUMMARY;
+    request.request_id = i;
+    request.track = 0;
+    request.argument = 0;
+    request.name_length = strlen(movie);
+    memcpy(request.name, movie, request.name_length);
+    if (mutff_write_query_request(&ctx, &bytes, &request) != MuTFFErrorNone) {
+      return -1;
+    }
+  }
+  if (send_all(fd, requests, buf.pos) != 0) {
+    perror("send");
+    return -1;
+  }
+
+  unsigned char in[4096];
+  size_t in_length = 0;
+  uint32_t answered = 0;
+  while (answered < REQUEST_COUNT) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    if (poll(&pfd, 1, TIMEOUT_MS) <= 0) {
+      fprintf(stderr, "stalled after %u responses\n", (unsigned)answered);
+      return -1;
+    }
+    const ssize_t received =
+        recv(fd, &in[in_length], sizeof(in) - in_length, 0);
+    if (received <= 0) {
+      fprintf(stderr, "closed after %u responses\n", (unsigned)answered);
+      return -1;
+    }
+    in_length += (size_t)received;
+
+    size_t consumed = 0;
+    while (in_length - consumed >= 4U &&
+           frame_size(&in[consumed]) <= in_length - consumed) {
+      const uint32_t size = frame_size(&in[consumed]);
+      MuTFFQueryResponse response;
+      mutff_memory_buffer_init(&buf, &in[consumed], size);
+      if (mutff_read_query_response(&ctx, &bytes, &response) !=
+              MuTFFErrorNone ||
+          response.request_id != answered ||
+          response.status != MuTFFErrorNone) {
+        fprintf(stderr, "bad response %u\n", (unsigned)answered);
+        return -1;
+      }
+      consumed += size;
+      answered++;
+    }
+    memmove(in, &in[consumed], in_length - consumed);
+    in_length -= consumed;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 5) {
+    fprintf(stderr, "usage: %s DAEMON DIRECTORY SOCKET MOVIE\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const pid_t daemon = fork();
+  if (daemon < 0) {
+    perror("fork");
+    return EXIT_FAILURE;
+  }
+  if (daemon == 0) {
+    execl(argv[1], argv[1], argv[2], argv[3], (char *)NULL);
+    perror(argv[1]);
+    _exit(EXIT_FAILURE);
+  }
+
+  int status = EXIT_FAILURE;
+  const int fd = connect_to(argv[3]);
+  if (fd < 0) {
+    fprintf(stderr, "%s: could not connect\n", argv[3]);
+  } else {
+    if (pipeline(fd, argv[4]) == 0) {
+      status = EXIT_SUCCESS;
+    }
+    close(fd);
+  }
+  kill(daemon, SIGTERM);
+  waitpid(daemon, NULL, 0);
+  unlink(argv[3]);
+  return status;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,288 @@
+///
+/// @file      mutff_split.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     Split a track into standalone movies at sync samples
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+/// Usage: mutff_split [-n PARTS] [-t TRACK] FILE PREFIX
+///
+/// The first video track of FILE, or track TRACK counting from zero, is cut
+/// at sync samples into PARTS parts, four by default, of similar size. Part i
+/// is written to PREFIXi.mov, a movie of that track alone, with the parts
+/// written on a thread each and their samples copied within the kernel where
+/// possible.
+///
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_sample.h"
+#include "mutff_stdlib.h"
+#include "mutff_tools.h"
+
+#define MAX_PARTS 64U
+
+typedef struct {
+  size_t track;
+  const char *prefix;
+  size_t part;
+  int src;
+  uint32_t first;
+  uint32_t end;
+  int status;
+} Job;
+
+static MuTFFMovieFile movie_file;
+
+static int write_u32(FILE *file, uint32_t x) {
+  const unsigned char bytes[4] = {(unsigned char)(x >> 24U),
+                                  (unsigned char)(x >> 16U),
+                                  (unsigned char)(x >> 8U), (unsigned char)x};
+  return fwrite(bytes, 1, sizeof(bytes), file) == sizeof(bytes) ? 0 : -1;
+}
+
+// the movie of one part, its samples stored from offset
+static int make_part_movie(MuTFFMovieAtom *out, const Job *job,
+                           uint32_t offset) {
+  const MuTFFMovieAtom *movie = &movie_file.movie;
+  const MuTFFSampleTableAtom *source;
+  MuTFFSampleTableAtom *sample_table;
+
+  *out = *movie;
+  out->track_count = 1;
+  out->track[0] = movie->track[job->track];
+  MuTFFTrackAtom *track = &out->track[0];
+  track->edit_present = false;
+  track->track_reference_present = false;
+  if (mutff_media_atom_sample_table(&source,
+                                    &movie->track[job->track].media) !=
+          MuTFFErrorNone ||
+      mutff_media_atom_mutable_sample_table(&sample_table, &track->media) !=
+          MuTFFErrorNone) {
+    return -1;
+  }
+  if (mutff_sample_table_trim(sample_table, source, job->first,
+                              job->end - job->first,
+                              offset) != MuTFFErrorNone) {
+    return -1;
+  }
+
+  uint64_t duration = 0;
+  for (uint32_t i = 0; i < sample_table->time_to_sample.number_of_entries;
+       ++i) {
+    const MuTFFTimeToSampleTableEntry *entry =
+        &sample_table->time_to_sample.time_to_sample_table[i];
+    duration += (uint64_t)entry->sample_count * entry->sample_duration;
+  }
+  const uint32_t media_time_scale = track->media.media_header.time_scale;
+  if (media_time_scale == 0U) {
+    return -1;
+  }
+  track->media.media_header.duration = (uint32_t)duration;
+  track->track_header.duration =
+      (uint32_t)(duration * out->movie_header.time_scale / media_time_scale);
+  out->movie_header.duration = track->track_header.duration;
+  return 0;
+}
+
+static int write_part(const Job *job, FILE *file, MuTFFMovieAtom *movie) {
+  MuTFFContext ctx;
+  ctx.io = mutff_stdlib_driver;
+  ctx.file = file;
+  size_t bytes;
+  MuTFFSample sample;
+
+  if (movie_file.file_type_present &&
+      mutff_write_file_type_atom(&ctx, &bytes, &movie_file.file_type) !=
+          MuTFFErrorNone) {
+    return -1;
+  }
+  const MuTFFSampleTableAtom *source;
+  if (mutff_media_atom_sample_table(
+          &source, &movie_file.movie.track[job->track].media) !=
+      MuTFFErrorNone) {
+    return -1;
+  }
+  MuTFFSampleCursor cursor;
+  uint64_t data_size = 0;
+  if (mutff_sample_cursor_init(&cursor, source, job->first) !=
+      MuTFFErrorNone) {
+    return -1;
+  }
+  for (uint32_t i = job->first; i < job->end; ++i) {
+    if (mutff_sample_cursor_next(&sample, &cursor) != MuTFFErrorNone) {
+      return -1;
+    }
+    data_size += sample.size;
+  }
+  if (data_size + 8U > UINT32_MAX) {
+    fprintf(stderr, "part %zu: too large\n", job->part);
+    return -1;
+  }
+  const long mdat = ftell(file);
+  if (mdat < 0 || write_u32(file, (uint32_t)data_size + 8U) != 0 ||
+      write_u32(file, MuTFF_FOURCC('m', 'd', 'a', 't')) != 0 ||
+      fflush(file) != 0) {
+    return -1;
+  }
+  if (make_part_movie(movie, job, (uint32_t)mdat + 8U) != 0) {
+    fprintf(stderr, "part %zu: could not make sample table\n", job->part);
+    return -1;
+  }
+
+  // copy each run of samples which follow one another in the source
+  uint64_t run_offset = 0;
+  uint64_t run_size = 0;
+  if (mutff_sample_cursor_init(&cursor, source, job->first) !=
+      MuTFFErrorNone) {
+    return -1;
+  }
+  for (uint32_t i = job->first; i < job->end; ++i) {
+    if (mutff_sample_cursor_next(&sample, &cursor) != MuTFFErrorNone) {
+      return -1;
+    }
+    if (run_size > 0U && run_offset + run_size != sample.offset) {
+      if (copy_range(job->src, (off_t)run_offset, fileno(file),
+                     (size_t)run_size) != 0) {
+        return -1;
+      }
+      run_size = 0;
+    }
+    if (run_size == 0U) {
+      run_offset = sample.offset;
+    }
+    run_size += sample.size;
+  }
+  if (run_size > 0U && copy_range(job->src, (off_t)run_offset, fileno(file),
+                                  (size_t)run_size) != 0) {
+    return -1;
+  }
+
+  if (fseek(file, 0, SEEK_END) != 0 ||
+      mutff_write_movie_atom(&ctx, &bytes, movie) != MuTFFErrorNone) {
+    return -1;
+  }
+  return 0;
+}
+
+static void *split_part(void *arg) {
+  Job *job = arg;
+  char path[4096];
+  if (snprintf(path, sizeof(path), "%s%zu.mov", job->prefix, job->part) >=
+      (int)sizeof(path)) {
+    job->status = -1;
+    return NULL;
+  }
+  MuTFFMovieAtom *movie = malloc(sizeof(*movie));
+  FILE *file = fopen(path, "w+b");
+  if (movie == NULL || file == NULL) {
+    perror(path);
+    free(movie);
+    if (file != NULL) {
+      fclose(file);
+    }
+    job->status = -1;
+    return NULL;
+  }
+  job->status = write_part(job, file, movie);
+  if (fclose(file) != 0 || job->status != 0) {
+    fprintf(stderr, "%s: could not write part\n", path);
+    job->status = -1;
+  }
+  free(movie);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  unsigned long parts = 4;
+  long track = -1;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:t:")) != -1) {
+    if (opt == 'n') {
+      parts = strtoul(optarg, NULL, 10);
+    } else if (opt == 't') {
+      track = strtol(optarg, NULL, 10);
+    } else {
+      parts = 0;
+      break;
+    }
+  }
+  if (argc - optind != 2 || parts == 0U || parts > MAX_PARTS) {
+    fprintf(stderr, "usage: %s [-n PARTS] [-t TRACK] FILE PREFIX\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const char *path = argv[optind];
+  const char *prefix = argv[optind + 1];
+
+  if (load_movie(&movie_file, path) != 0) {
+    return EXIT_FAILURE;
+  }
+  const MuTFFMovieAtom *movie = &movie_file.movie;
+  if (track < 0) {
+    track = (long)video_track(movie);
+  }
+  if ((size_t)track >= movie->track_count) {
+    fprintf(stderr, "%s: no track %ld\n", path, track);
+    return EXIT_FAILURE;
+  }
+  const MuTFFSampleTableAtom *sample_table;
+  uint32_t cuts[MAX_PARTS + 1U];
+  if (mutff_media_atom_sample_table(&sample_table,
+                                    &movie->track[track].media) !=
+          MuTFFErrorNone ||
+      mutff_sample_table_split(cuts, parts, sample_table) != MuTFFErrorNone) {
+    fprintf(stderr, "%s: bad sample table\n", path);
+    return EXIT_FAILURE;
+  }
+
+  const int src = open(path, O_RDONLY);
+  if (src < 0) {
+    perror(path);
+    return EXIT_FAILURE;
+  }
+  Job job[MAX_PARTS];
+  pthread_t thread[MAX_PARTS];
+  size_t started = 0;
+  int status = EXIT_SUCCESS;
+  for (size_t i = 0; i < parts; ++i) {
+    // there are fewer sync samples than parts
+    if (cuts[i] == cuts[i + 1U]) {
+      continue;
+    }
+    Job *j = &job[started];
+    j->track = (size_t)track;
+    j->prefix = prefix;
+    j->part = started;
+    j->src = src;
+    j->first = cuts[i];
+    j->end = cuts[i + 1U];
+    j->status = -1;
+    if (pthread_create(&thread[started], NULL, split_part, j) != 0) {
+      fprintf(stderr, "could not start thread\n");
+      status = EXIT_FAILURE;
+      break;
+    }
+    started++;
+  }
+  for (size_t i = 0; i < started; ++i) {
+    pthread_join(thread[i], NULL);
+    if (job[i].status != 0) {
+      status = EXIT_FAILURE;
+    }
+  }
+  close(src);
+  fprintf(stderr, "wrote %zu parts\n", started);
+  return status;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,100 @@
+///
+/// @file      mutff_syncalign.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     Check sync samples line up across the renditions of a movie
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+/// Usage: mutff_syncalign [-t TOLERANCE] FILE...
+///
+/// The sync samples of the first video track of each file, or the first track
+/// if there is no video track, are compared. TOLERANCE is the greatest
+/// permitted difference between sync sample times in milliseconds and defaults
+/// to zero. Exits with status 2 if any sync sample is misaligned.
+///
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_sync.h"
+#include "mutff_tools.h"
+
+#define TIME_SCALE 90000U
+
+int main(int argc, char **argv) {
+  unsigned long tolerance_ms = 0;
+  int opt;
+  while ((opt = getopt(argc, argv, "t:")) != -1) {
+    if (opt == 't') {
+      tolerance_ms = strtoul(optarg, NULL, 10);
+    } else {
+      fprintf(stderr, "usage: %s [-t TOLERANCE] FILE...\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  const size_t count = (size_t)(argc - optind);
+  if (count == 0U) {
+    fprintf(stderr, "usage: %s [-t TOLERANCE] FILE...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  MuTFFMovieFile *movies = calloc(count, sizeof(*movies));
+  MuTFFSyncTimeIterator *its = calloc(count, sizeof(*its));
+  size_t *heap = calloc(count, sizeof(*heap));
+  if (movies == NULL || its == NULL || heap == NULL) {
+    perror("calloc");
+    return EXIT_FAILURE;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    const char *path = argv[optind + (int)i];
+    if (load_movie(&movies[i], path) != 0) {
+      return EXIT_FAILURE;
+    }
+    const MuTFFMovieAtom *movie = &movies[i].movie;
+    const MuTFFError err = mutff_sync_time_iterator_init(
+        &its[i], movie, video_track(movie), TIME_SCALE);
+    if (err != MuTFFErrorNone) {
+      fprintf(stderr, "%s: could not read sync samples (error %d)\n", path,
+              (int)err);
+      return EXIT_FAILURE;
+    }
+  }
+
+  MuTFFSyncAlignment alignment;
+  const MuTFFError err = mutff_check_sync_alignment(
+      &alignment, its, count, tolerance_ms * (TIME_SCALE / 1000U), heap);
+  if (err != MuTFFErrorNone) {
+    fprintf(stderr, "could not check alignment (error %d)\n", (int)err);
+    return EXIT_FAILURE;
+  }
+
+  for (uint32_t i = 0; i < alignment.misalignment_count &&
+                       i < MuTFF_MAX_SYNC_MISALIGNMENTS;
+       ++i) {
+    const MuTFFSyncMisalignment *misalignment = &alignment.misalignment[i];
+    printf("%s: sync sample %u at %.3f s is misaligned\n",
+           argv[optind + (int)misalignment->rendition],
+           (unsigned)misalignment->sync_index,
+           (double)misalignment->time / TIME_SCALE);
+  }
+  if (alignment.misalignment_count > MuTFF_MAX_SYNC_MISALIGNMENTS) {
+    printf("... and %u more\n",
+           (unsigned)(alignment.misalignment_count -
+                      MuTFF_MAX_SYNC_MISALIGNMENTS));
+  }
+  printf("%u aligned, %u misaligned\n", (unsigned)alignment.aligned_count,
+         (unsigned)alignment.misalignment_count);
+
+  free(movies);
+  free(its);
+  free(heap);
+  return alignment.misalignment_count == 0U ? EXIT_SUCCESS : 2;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
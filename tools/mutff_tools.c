@@ -0,0 +1,81 @@
+///
+/// @file      mutff_tools.c
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     Helpers shared by the MuTFF POSIX tools
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#define _GNU_SOURCE
+
+#include "mutff_tools.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+#include "mutff_stdlib.h"
+
+#define BUFFER_SIZE 65536U
+
+int copy_range(int src, off_t offset, int dest, size_t size) {
+  while (size > 0U) {
+    const ssize_t copied = copy_file_range(src, &offset, dest, NULL, size, 0);
+    if (copied > 0) {
+      size -= (size_t)copied;
+      continue;
+    }
+    if (copied == 0) {
+      return -1;
+    }
+    if (errno != EXDEV && errno != ENOSYS && errno != EINVAL) {
+      return -1;
+    }
+    char buf[BUFFER_SIZE];
+    const size_t chunk = size < sizeof(buf) ? size : sizeof(buf);
+    const ssize_t bytes = pread(src, buf, chunk, offset);
+    if (bytes <= 0 || write(dest, buf, (size_t)bytes) != bytes) {
+      return -1;
+    }
+    offset += bytes;
+    size -= (size_t)bytes;
+  }
+  return 0;
+}
+
+int load_movie(MuTFFMovieFile *out, const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    perror(path);
+    return -1;
+  }
+  MuTFFContext ctx;
+  ctx.io = mutff_stdlib_driver;
+  ctx.file = file;
+  size_t bytes;
+  const MuTFFError err = mutff_read_movie_file(&ctx, &bytes, out);
+  fclose(file);
+  if (err != MuTFFErrorNone) {
+    fprintf(stderr, "%s: could not read movie (error %d)\n", path, (int)err);
+    return -1;
+  }
+  return 0;
+}
+
+size_t video_track(const MuTFFMovieAtom *movie) {
+  for (size_t i = 0; i < movie->track_count; ++i) {
+    MuTFFMediaType type;
+    if (mutff_media_atom_type(&type, &movie->track[i].media) ==
+            MuTFFErrorNone &&
+        type == MuTFFMediaTypeVideo) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+// vi:sw=2:ts=2:et:fdm=marker
@@ -0,0 +1,31 @@
+///
+/// @file      mutff_tools.h
+/// @author    Frank Plowman <post@frankplowman.com>
+/// @brief     Helpers shared by the MuTFF POSIX tools
+/// @copyright 2023 Frank Plowman
+/// @license   This project is released under the GNU Public License Version 3.
+///            For the terms of this license, see [LICENSE.md](LICENSE.md)
+///
+
+#ifndef MUTFF_TOOLS_H_
+#define MUTFF_TOOLS_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "mutff.h"
+#include "mutff_default.h"
+
+// copy a range of one file to another, falling back to read and write where
+// the kernel cannot copy between the two
+int copy_range(int src, off_t offset, int dest, size_t size);
+
+// read the movie file at path, reporting any error
+int load_movie(MuTFFMovieFile *out, const char *path);
+
+// the index of the first video track of a movie, or zero if there is none
+size_t video_track(const MuTFFMovieAtom *movie);
+
+#endif  // MUTFF_TOOLS_H_
+
+// vi:sw=2:ts=2:et:fdm=marker